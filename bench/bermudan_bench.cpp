@@ -0,0 +1,277 @@
+// bench/bermudan_bench.cpp
+#include <benchmark/benchmark.h>
+
+#include "YieldCurveBuilder.hpp"
+#include "SwapBuilder.hpp"
+#include "SwaptionCalibrator.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "BasicBermudanSwaptionPricer.hpp"
+#include "ChebyshevSurrogate.hpp"
+#include "G2AdiSwaptionEngine.hpp"
+#include "SchedulePool.hpp"
+
+#include <ql/settings.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/indexes/ibor/euribor.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/instruments/swaption.hpp>
+#include <ql/pricingengines/swaption/discretizedswaption.hpp>
+#include <ql/pricingengines/swaption/jamshidianswaptionengine.hpp>
+#include <ql/pricingengines/swaption/g2swaptionengine.hpp>
+#include <ql/models/shortrate/calibrationhelpers/swaptionhelper.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/models/shortrate/twofactormodels/g2.hpp>
+#include <ql/math/optimization/levenbergmarquardt.hpp>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace QuantLib;
+
+namespace {
+
+    const char* const kEngines[] = {"tree", "fdm"};
+    const char* const kModels[] = {"hw", "g2", "bk"};
+    const int kSteps[] = {25, 50, 100, 200};
+
+    struct Market {
+        Handle<YieldTermStructure> ts;
+        ext::shared_ptr<SwapBuilder> builder;
+        ext::shared_ptr<VanillaSwap> swap;
+
+        Market() {
+            Date today(15, July, 2025);
+            Settings::instance().evaluationDate() = today;
+            ts = YieldCurveBuilder(0.035).buildCurve(TARGET().advance(today, 2, Days));
+            builder = ext::make_shared<SwapBuilder>(ts);
+            swap = builder->buildSwap(builder->fairRate());
+        }
+
+        // Exercise and coupon times of the Bermudan, so every grid size
+        // lands on the dates the rollback has to stop at.
+        std::vector<Time> mandatoryTimes(const ext::shared_ptr<ShortRateModel>& model) const {
+            BermudanSwaptionPricer pricer(swap, model, "tree");
+            Swaption::arguments args;
+            pricer.swaption()->setupArguments(&args);
+            args.validate();
+            DiscretizedSwaption asset(args, ts->referenceDate(), ts->dayCounter());
+            return asset.mandatoryTimes();
+        }
+    };
+
+    // One full reprice per iteration: the model notification makes the
+    // engine refit its lattice (or rebuild its FD mesh) as after a market move.
+    void BM_Price(benchmark::State& state, const std::string& engine, const std::string& model) {
+        Market m;
+        auto shortRate = BermudanSwaptionPricer::makeModel(model, m.ts);
+        std::vector<Time> times = m.mandatoryTimes(shortRate);
+        TimeGrid grid(times.begin(), times.end(), static_cast<Size>(state.range(0)));
+
+        BermudanSwaptionPricer pricer(m.swap, shortRate, engine, &grid);
+        for (auto _ : state) {
+            shortRate->notifyObservers();
+            benchmark::DoNotOptimize(pricer.price());
+        }
+        state.counters["steps"] = static_cast<double>(grid.size() - 1);
+    }
+
+    // Same reprice through the compile-time HW/tree pricer, to compare with
+    // BM_Price/tree/hw.
+    void BM_PriceTyped(benchmark::State& state) {
+        Market m;
+        auto model = ext::make_shared<HullWhite>(m.ts);
+        std::vector<Time> times = m.mandatoryTimes(model);
+        TimeGrid grid(times.begin(), times.end(), static_cast<Size>(state.range(0)));
+
+        BasicBermudanSwaptionPricer<HullWhite, TreeEngine> pricer(m.swap, model, &grid);
+        for (auto _ : state) {
+            model->notifyObservers();
+            benchmark::DoNotOptimize(pricer.price());
+        }
+        state.counters["steps"] = static_cast<double>(grid.size() - 1);
+    }
+
+    // Fine G2 mesh: range(0) points per factor and twice as many time steps,
+    // ADI sweeps on range(1) threads
+    void BM_G2Adi(benchmark::State& state) {
+        Market m;
+        auto model = ext::make_shared<G2>(m.ts);
+        const auto points = static_cast<Size>(state.range(0));
+        BermudanSwaptionPricer pricer(m.swap, model, "fdm-adi");
+        pricer.swaption()->setPricingEngine(ext::make_shared<G2AdiSwaptionEngine>(
+            model, 2 * points, points, points, G2AdiSwaptionEngine::CraigSneyd,
+            static_cast<std::size_t>(state.range(1))));
+        for (auto _ : state) {
+            model->notifyObservers();
+            benchmark::DoNotOptimize(pricer.swaption()->NPV());
+        }
+    }
+
+    // Quote from a range(0) x range(0) surrogate (built once, outside the
+    // timing), sweeping the strike across the domain
+    void BM_SurrogateQuote(benchmark::State& state) {
+        const BermudanTrade shape{Date(15, July, 2025), 0.0, "hw", "tree", 1.0};
+        SurrogateSettings settings;
+        settings.rateNodes = static_cast<std::size_t>(state.range(0));
+        settings.multiplierNodes = settings.rateNodes;
+        const ChebyshevSurrogate surrogate = ChebyshevSurrogate::build(shape, settings);
+
+        double mult = settings.minMultiplier;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(surrogate.price(0.035, mult));
+            mult = mult < settings.maxMultiplier - 0.01 ? mult + 0.01 : settings.minMultiplier;
+        }
+        state.counters["error_estimate"] = surrogate.errorEstimate();
+    }
+
+    std::vector<ext::shared_ptr<BlackCalibrationHelper>> diagonalHelpers(const Market& m) {
+        static const double vols[] = {0.1620, 0.1580, 0.1580, 0.1580, 0.1570};
+        auto index = ext::make_shared<Euribor6M>(m.ts);
+        std::vector<ext::shared_ptr<BlackCalibrationHelper>> helpers;
+        for (int i = 0; i < 5; ++i) {
+            helpers.push_back(ext::make_shared<SwaptionHelper>(
+                Period(i + 1, Years), Period(5 - i, Years),
+                Handle<Quote>(ext::make_shared<SimpleQuote>(vols[i])),
+                index, index->tenor(), index->dayCounter(), index->dayCounter(), m.ts));
+        }
+        return helpers;
+    }
+
+    ext::shared_ptr<PricingEngine> helperEngine(const ext::shared_ptr<HullWhite>& model) {
+        return ext::make_shared<JamshidianSwaptionEngine>(model);
+    }
+
+    ext::shared_ptr<PricingEngine> helperEngine(const ext::shared_ptr<G2>& model) {
+        return ext::make_shared<G2SwaptionEngine>(model, 6.0, 16);
+    }
+
+    // Cold fit per iteration; range(0) is the repricing thread count (0 -> shared pool)
+    template <class Model>
+    void BM_Calibrate(benchmark::State& state) {
+        Market m;
+        auto helpers = diagonalHelpers(m);
+        std::vector<double> vols;
+        for (const auto& h : helpers)
+            vols.push_back(h->volatility()->value());
+        SwaptionCalibrator calibrator(helpers, vols, {5, 4, 3, 2, 1}, m.ts);
+
+        CalibrationSettings settings;
+        settings.warmStart = false;
+        settings.threads = static_cast<std::size_t>(state.range(0));
+
+        Size evaluations = 0;
+        for (auto _ : state) {
+            auto model = ext::make_shared<Model>(m.ts);
+            for (auto& h : helpers)
+                h->setPricingEngine(helperEngine(model));
+            LevenbergMarquardt lm;
+            evaluations = calibrator.calibrateModel(model, lm, settings).evaluations;
+        }
+        state.counters["evaluations"] = static_cast<double>(evaluations);
+    }
+
+    void BM_FairRate(benchmark::State& state) {
+        Market m;
+        for (auto _ : state)
+            benchmark::DoNotOptimize(m.builder->fairRate());
+    }
+
+    // Book of 64 trades on distinct curves on range(0) threads. "fdm" is left
+    // out: on a stock QuantLib build it prices under the global guard.
+    void BM_PriceBatch(benchmark::State& state, const std::string& engine,
+                       const std::string& model) {
+        std::vector<BermudanTrade> trades;
+        for (int i = 0; i < 64; ++i)
+            trades.push_back({Date(15, July, 2025), 0.02 + 0.0005 * i, model, engine, 1.0});
+        const auto threads = static_cast<std::size_t>(state.range(0));
+        for (auto _ : state)
+            benchmark::DoNotOptimize(BermudanSwaptionPricer::priceBatch(trades, threads));
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * trades.size()));
+    }
+
+    // Builder for a 10Y quarterly swap; range(0) = 0 empties SchedulePool
+    // before each one, so both schedules are generated again
+    void BM_SwapBuilder(benchmark::State& state) {
+        Market m;
+        SwapDescription d;
+        d.tenor = Period(10, Years);
+        d.floatFrequency = Quarterly;
+        const bool pooled = state.range(0) != 0;
+        for (auto _ : state) {
+            if (!pooled) {
+                state.PauseTiming();
+                SchedulePool::shared().clear();
+                state.ResumeTiming();
+            }
+            SwapBuilder builder(m.ts, d);
+            benchmark::DoNotOptimize(&builder.floatSchedule());
+        }
+        // Dates a builder stores itself without the pool
+        SwapBuilder builder(m.ts, d);
+        state.counters["schedule_dates"] = static_cast<double>(
+            builder.fixedSchedule().size() + builder.floatSchedule().size());
+    }
+
+    // The FD engines for HW and G2 size their own mesh; BK falls back to the
+    // tree on the supplied grid, so only it is swept on fdm.
+    void registerPricing() {
+        for (const char* engine : kEngines) {
+            for (const char* model : kModels) {
+                const std::string name = std::string("BM_Price/") + engine + "/" + model;
+                auto* bench = benchmark::RegisterBenchmark(
+                    name.c_str(),
+                    [engine = std::string(engine), model = std::string(model)](benchmark::State& s) {
+                        BM_Price(s, engine, model);
+                    });
+                bench->ArgName("steps")->Unit(benchmark::kMillisecond);
+                if (std::string(engine) == "fdm" && std::string(model) != "bk") {
+                    bench->Arg(kSteps[1]);
+                } else {
+                    for (int steps : kSteps)
+                        bench->Arg(steps);
+                }
+            }
+        }
+
+        const std::pair<const char*, const char*> batches[] = {
+            {"tree", "hw"}, {"hw-simd", "hw"}, {"tree", "g2"}, {"fdm-adi", "g2"}};
+        for (auto [engine, model] : batches) {
+            const std::string name = std::string("BM_PriceBatch/") + engine + "/" + model;
+            benchmark::RegisterBenchmark(
+                name.c_str(),
+                [engine = std::string(engine), model = std::string(model)](benchmark::State& s) {
+                    BM_PriceBatch(s, engine, model);
+                })
+                ->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+                ->Unit(benchmark::kMillisecond)->UseRealTime();
+        }
+    }
+
+}
+
+BENCHMARK_TEMPLATE(BM_Calibrate, HullWhite)
+    ->ArgName("threads")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Calibrate, G2)
+    ->ArgName("threads")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PriceTyped)
+    ->ArgName("steps")->Arg(25)->Arg(50)->Arg(100)->Arg(200)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_G2Adi)
+    ->ArgNames({"points", "threads"})
+    ->ArgsProduct({{100, 200, 400}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SurrogateQuote)
+    ->ArgName("nodes")->Arg(8)->Arg(12)->Arg(16)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_FairRate)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SwapBuilder)->ArgName("pooled")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv) {
+    registerPricing();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
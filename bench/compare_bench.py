@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Compare two bermudan_bench JSON runs and flag regressions.
+
+    ./build/bermudan_bench --benchmark_out=base.json --benchmark_out_format=json
+    ./build/bermudan_bench --benchmark_out=new.json  --benchmark_out_format=json
+    python3 bench/compare_bench.py base.json new.json --threshold 0.10
+
+Exits with status 1 when any benchmark present in both runs got slower by
+more than the threshold (relative). With --benchmark_repetitions the median
+aggregate is compared; otherwise the single iteration result.
+"""
+import argparse
+import json
+import sys
+
+UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    with open(path) as f:
+        data = json.load(f)
+    runs, medians = {}, {}
+    for b in data.get("benchmarks", []):
+        if b.get("error_occurred"):
+            continue
+        name = b.get("run_name", b["name"])
+        value = b[metric] * UNIT_NS[b.get("time_unit", "ns")]
+        if b.get("run_type") == "aggregate":
+            if b.get("aggregate_name") == "median":
+                medians[name] = value
+        else:
+            runs.setdefault(name, value)
+    runs.update(medians)
+    return runs
+
+
+def fmt(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return f"{ns / scale:.3f} {unit}"
+    return f"{ns:.1f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative slowdown that counts as a regression (default 0.05)")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time",
+                        help="real_time suits the multi-threaded benchmarks (default)")
+    args = parser.parse_args()
+
+    base = load(args.baseline, args.metric)
+    new = load(args.contender, args.metric)
+
+    regressions = []
+    width = max((len(n) for n in base), default=10)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'contender':>12}  {'change':>8}")
+    for name in sorted(base.keys() & new.keys()):
+        change = new[name] / base[name] - 1.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        print(f"{name:<{width}}  {fmt(base[name]):>12}  {fmt(new[name]):>12}  {change:+8.1%}{flag}")
+
+    for name in sorted(base.keys() - new.keys()):
+        print(f"{name:<{width}}  missing from contender")
+    for name in sorted(new.keys() - base.keys()):
+        print(f"{name:<{width}}  new")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) beyond {args.threshold:.0%}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,39 +1,164 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
-#include "YieldCurveBuilder.hpp"
-#include "SwapBuilder.hpp"
 #include "BermudanSwaptionPricer.hpp"
+#include "ChebyshevSurrogate.hpp"
+#include "MarketCache.hpp"
+#include "Metrics.hpp"
+#include "PricingService.hpp"
+#include "TradeCodes.hpp"
 
-#include <ql/settings.hpp>
-#include <ql/time/calendars/target.hpp>
-#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
-#include <ql/models/shortrate/twofactormodels/g2.hpp>
-#include <ql/models/shortrate/onefactormodels/blackkarasinski.hpp>
+#include <ql/time/date.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace py = pybind11;
 using namespace QuantLib;
 
 namespace {
 
-// Build a flat TS on the requested date
-Handle<YieldTermStructure> make_ts(const Date& today, double flat_rate) {
-    Settings::instance().evaluationDate() = today;
-    Calendar cal = TARGET();
-    Date settlement = cal.advance(today, 2, Days);
-    YieldCurveBuilder ycb(flat_rate);
-    return ycb.buildCurve(settlement);
-}
+    const Date::serial_type kUnixEpochSerial = Date(1, January, 1970).serialNumber();
 
-ext::shared_ptr<ShortRateModel>
-make_model(const std::string& name, const Handle<YieldTermStructure>& ts) {
-    if (name == "g2")  return ext::make_shared<G2>(ts);
-    if (name == "hw")  return ext::make_shared<HullWhite>(ts);
-    if (name == "bk")  return ext::make_shared<BlackKarasinski>(ts);
-    QL_FAIL("Unknown model: " << name << " (use 'g2' | 'hw' | 'bk')");
-}
+    // datetime64 arrays (any unit) become day counts since 1970-01-01;
+    // integer arrays are read as YYYYMMDD.
+    std::vector<Date> toDates(const py::array& dates) {
+        std::vector<Date> result;
+        if (dates.dtype().kind() == 'M') {
+            auto days = py::array_t<std::int64_t, py::array::c_style | py::array::forcecast>(
+                dates.attr("astype")("datetime64[D]").attr("astype")("int64"));
+            result.reserve(static_cast<std::size_t>(days.size()));
+            const std::int64_t* p = days.data();
+            for (py::ssize_t i = 0; i < days.size(); ++i)
+                result.emplace_back(static_cast<Date::serial_type>(kUnixEpochSerial + p[i]));
+            return result;
+        }
+        auto ymd = py::array_t<std::int64_t, py::array::c_style | py::array::forcecast>(dates);
+        result.reserve(static_cast<std::size_t>(ymd.size()));
+        const std::int64_t* p = ymd.data();
+        for (py::ssize_t i = 0; i < ymd.size(); ++i) {
+            const std::int64_t v = p[i];
+            result.emplace_back(static_cast<Day>(v % 100),
+                                static_cast<Month>((v / 100) % 100),
+                                static_cast<Year>(v / 10000));
+        }
+        return result;
+    }
+
+    BermudanTrade makeTrade(int year, int month, int day, double flatRate,
+                            const std::string& model, const std::string& engine,
+                            double strikeMultiplier, std::size_t mcPaths, double mcTolerance,
+                            double gridTolerance) {
+        BermudanTrade trade;
+        trade.evaluationDate = Date(day, static_cast<Month>(month), year);
+        trade.flatRate = flatRate;
+        trade.model = model;
+        trade.engine = engine;
+        trade.strikeMultiplier = strikeMultiplier;
+        if (mcPaths != 0)
+            trade.lsmc.maxPaths = mcPaths;
+        trade.lsmc.tolerance = mcTolerance;
+        trade.grid.tolerance = gridTolerance;
+        return trade;
+    }
+
+    template <std::size_t N>
+    const char* decode(const char* const (&names)[N], std::int64_t code, const char* what) {
+        if (code < 0 || static_cast<std::size_t>(code) >= N)
+            throw py::value_error(std::string("unknown ") + what + " code " + std::to_string(code));
+        return names[code];
+    }
+
+    // priority: "interactive" | "normal" | "batch"; timeout_ms <= 0: no deadline
+    JobOptions jobOptions(const std::string& priority, double timeoutMs) {
+        JobOptions options;
+        if (priority == "interactive")
+            options.priority = JobPriority::Interactive;
+        else if (priority == "normal")
+            options.priority = JobPriority::Normal;
+        else if (priority == "batch")
+            options.priority = JobPriority::Batch;
+        else
+            throw py::value_error("unknown priority " + priority);
+        if (timeoutMs > 0.0)
+            options.deadline = CancellationToken::Clock::now() +
+                std::chrono::duration_cast<CancellationToken::Clock::duration>(
+                    std::chrono::duration<double, std::milli>(timeoutMs));
+        return options;
+    }
+
+    using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+    using CodeArray = py::array_t<std::int64_t, py::array::c_style | py::array::forcecast>;
+
+    std::vector<BermudanTrade> makeBook(const py::array& dates, const DoubleArray& flat_rates,
+                                        const CodeArray& models, const CodeArray& engines,
+                                        const DoubleArray& strike_multipliers,
+                                        std::size_t mc_paths, double mc_tolerance,
+                                        double grid_tolerance) {
+        const std::vector<Date> evaluationDates = toDates(dates);
+        const std::size_t n = evaluationDates.size();
+        for (const py::array* a : {static_cast<const py::array*>(&flat_rates),
+                                   static_cast<const py::array*>(&models),
+                                   static_cast<const py::array*>(&engines),
+                                   static_cast<const py::array*>(&strike_multipliers)}) {
+            if (static_cast<std::size_t>(a->size()) != n)
+                throw py::value_error("price_bermudan_batch: all arrays must have the same length");
+        }
+
+        std::vector<BermudanTrade> trades(n);
+        const double* rate = flat_rates.data();
+        const std::int64_t* model = models.data();
+        const std::int64_t* engine = engines.data();
+        const double* mult = strike_multipliers.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            BermudanTrade& t = trades[i];
+            t.evaluationDate = evaluationDates[i];
+            t.flatRate = rate[i];
+            t.model = decode(kModelCodes, model[i], "model");
+            t.engine = decode(kEngineCodes, engine[i], "engine");
+            t.strikeMultiplier = mult[i];
+            if (mc_paths != 0)
+                t.lsmc.maxPaths = mc_paths;
+            t.lsmc.tolerance = mc_tolerance;
+            t.grid.tolerance = grid_tolerance;
+        }
+        return trades;
+    }
+
+    // Handle returned by submit_bermudan_batch
+    class BookJob {
+    public:
+        explicit BookJob(PricingJob<std::vector<double>> job)
+            : result_(job.result.share()), token_(std::move(job.token)) {}
+
+        py::array_t<double> result() const {
+            const std::vector<double>* npvs;
+            {
+                py::gil_scoped_release release;
+                npvs = &result_.get();
+            }
+            py::array_t<double> out(static_cast<py::ssize_t>(npvs->size()));
+            std::copy(npvs->begin(), npvs->end(), out.mutable_data());
+            return out;
+        }
+
+        bool done() const {
+            return result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        void cancel() const { PricingService::shared().cancel(token_); }
 
-} // namespace
+    private:
+        std::shared_future<std::vector<double>> result_;
+        std::shared_ptr<CancellationToken> token_;
+    };
+
+}
 
 PYBIND11_MODULE(bermudan_native, m) {
     m.doc() = "Pybind11 bindings for Bermudan swaption pricer (QuantLib 1.25 compatible)";
@@ -43,25 +168,289 @@ PYBIND11_MODULE(bermudan_native, m) {
         [](int year, int month, int day,
            double flat_rate,
            const std::string& model_name,
-           const std::string& engine,      // "tree" | "fdm"
-           double strike_multiplier) {     // 1.0=ATM, 1.2=OTM, 0.8=ITM
-            Date today(day, static_cast<Month>(month), year);
-            Handle<YieldTermStructure> ts = make_ts(today, flat_rate);
+           const std::string& engine,      // "tree" | "fdm" | "fdm-adi" | "hw-simd" | "lsmc"
+           double strike_multiplier,       // 1.0=ATM, 1.2=OTM, 0.8=ITM
+           std::size_t mc_paths,           // lsmc: pricing path cap (0 = default)
+           double mc_tolerance,            // lsmc: target standard error (0 = off)
+           double grid_tolerance,          // tree/fdm: target grid error (0 = fixed grid)
+           const std::string& priority,    // PricingService queue: "interactive" | "normal" | "batch"
+           double timeout_ms) {            // raise PricingCancelled past this (0 = no deadline)
+            auto job = PricingService::shared().submit(
+                makeTrade(year, month, day, flat_rate, model_name, engine, strike_multiplier,
+                          mc_paths, mc_tolerance, grid_tolerance),
+                jobOptions(priority, timeout_ms));
+            py::gil_scoped_release release;
+            return job.result.get();
+        },
+        py::arg("year"), py::arg("month"), py::arg("day"),
+        py::arg("flat_rate"),
+        py::arg("model_name"),
+        py::arg("engine"),
+        py::arg("strike_multiplier"),
+        py::arg("mc_paths") = 0,
+        py::arg("mc_tolerance") = 0.0,
+        py::arg("grid_tolerance") = 0.0,
+        py::arg("priority") = "interactive",
+        py::arg("timeout_ms") = 0.0
+    );
+
+    py::register_exception<PricingCancelled>(m, "PricingCancelled", PyExc_RuntimeError);
 
-            SwapBuilder sb(ts);
-            Rate atm = sb.fairRate();
-            ext::shared_ptr<VanillaSwap> swap = sb.buildSwap(atm * strike_multiplier);
+    py::dict modelCodes, engineCodes;
+    for (std::size_t i = 0; i < std::size(kModelCodes); ++i)
+        modelCodes[kModelCodes[i]] = i;
+    for (std::size_t i = 0; i < std::size(kEngineCodes); ++i)
+        engineCodes[kEngineCodes[i]] = i;
+    m.attr("MODEL_CODES") = modelCodes;
+    m.attr("ENGINE_CODES") = engineCodes;
+
+    // price_bermudan_batch(dates, flat_rates, models, engines, strike_multipliers)
+    //   -> numpy.ndarray[float64]
+    // dates: datetime64 or YYYYMMDD integers; models/engines: MODEL_CODES /
+    // ENGINE_CODES integers. Rows with the same market share one curve and
+    // model (BermudanSwaptionPricer::priceBook); pricing runs without the GIL,
+    // as one PricingService job at the given priority. keep_markets keeps
+    // those graphs in the process-wide MarketCache.
+    m.def("price_bermudan_batch",
+        [](const py::array& dates,
+           DoubleArray flat_rates,
+           CodeArray models,
+           CodeArray engines,
+           DoubleArray strike_multipliers,
+           std::size_t mc_paths,
+           double mc_tolerance,
+           double grid_tolerance,
+           std::size_t threads,
+           bool keep_markets,
+           const std::string& priority,
+           double timeout_ms) {
+            JobOptions options = jobOptions(priority, timeout_ms);
+            options.threads = threads;
+            options.markets = keep_markets ? &MarketCache::shared() : nullptr;
+            return BookJob(PricingService::shared().submitBook(
+                makeBook(dates, flat_rates, models, engines, strike_multipliers,
+                         mc_paths, mc_tolerance, grid_tolerance),
+                options)).result();
+        },
+        py::arg("dates"),
+        py::arg("flat_rates"),
+        py::arg("models"),
+        py::arg("engines"),
+        py::arg("strike_multipliers"),
+        py::arg("mc_paths") = 0,
+        py::arg("mc_tolerance") = 0.0,
+        py::arg("grid_tolerance") = 0.0,
+        py::arg("threads") = 0,
+        py::arg("keep_markets") = false,
+        py::arg("priority") = "normal",
+        py::arg("timeout_ms") = 0.0
+    );
 
-            ext::shared_ptr<ShortRateModel> model = make_model(model_name, ts);
+    py::class_<BookJob>(m, "BookJob")
+        .def("result", &BookJob::result)   // blocks without the GIL; raises the job's error
+        .def("done", &BookJob::done)
+        .def("cancel", &BookJob::cancel);
 
-            BermudanSwaptionPricer pricer(swap, model, engine);
-            return pricer.price();
+    // submit_bermudan_batch(...) -> BookJob
+    // price_bermudan_batch without waiting: the job is queued and result()
+    // collects it; cancel() drops its queued chunks and stops the running ones.
+    m.def("submit_bermudan_batch",
+        [](const py::array& dates,
+           DoubleArray flat_rates,
+           CodeArray models,
+           CodeArray engines,
+           DoubleArray strike_multipliers,
+           std::size_t mc_paths,
+           double mc_tolerance,
+           double grid_tolerance,
+           std::size_t threads,
+           bool keep_markets,
+           const std::string& priority,
+           double timeout_ms) {
+            JobOptions options = jobOptions(priority, timeout_ms);
+            options.threads = threads;
+            options.markets = keep_markets ? &MarketCache::shared() : nullptr;
+            std::vector<BermudanTrade> trades = makeBook(dates, flat_rates, models, engines,
+                                                         strike_multipliers, mc_paths,
+                                                         mc_tolerance, grid_tolerance);
+            py::gil_scoped_release release;
+            return BookJob(PricingService::shared().submitBook(std::move(trades), options));
+        },
+        py::arg("dates"),
+        py::arg("flat_rates"),
+        py::arg("models"),
+        py::arg("engines"),
+        py::arg("strike_multipliers"),
+        py::arg("mc_paths") = 0,
+        py::arg("mc_tolerance") = 0.0,
+        py::arg("grid_tolerance") = 0.0,
+        py::arg("threads") = 0,
+        py::arg("keep_markets") = false,
+        py::arg("priority") = "batch",
+        py::arg("timeout_ms") = 0.0
+    );
+
+    m.def("service_info", []() {
+        const PricingService& service = PricingService::shared();
+        py::dict info;
+        info["workers"] = service.workers();
+        info["queued"] = service.queued();
+        info["running"] = service.running();
+        return info;
+    });
+
+    m.def("market_cache_info", []() {
+        const MarketCache& cache = MarketCache::shared();
+        py::dict info;
+        info["size"] = cache.size();
+        info["hits"] = cache.hits();
+        info["misses"] = cache.misses();
+        return info;
+    });
+
+    m.def("clear_market_cache", []() {
+        py::gil_scoped_release release;
+        MarketCache::shared().clear();
+    });
+
+    // build_surrogate(...) -> {"checked_error", "tail_estimate", "error_estimate",
+    //                           "rate_nodes", "multiplier_nodes"}
+    // checked_error is the largest deviation on the check grid and
+    // tail_estimate the size of the last Chebyshev coefficients; their sum
+    // is an estimate, not a bound.
+    // Chebyshev surrogate of the shape (date, model, engine, accuracy
+    // settings) over flat rate x strike multiplier, priced offline on the
+    // thread pool and registered for quote_bermudan.
+    m.def("build_surrogate",
+        [](int year, int month, int day,
+           const std::string& model_name,
+           const std::string& engine,
+           double min_rate, double max_rate,
+           double min_multiplier, double max_multiplier,
+           std::size_t rate_nodes,
+           std::size_t multiplier_nodes,
+           std::size_t check_nodes,
+           double tolerance,
+           std::size_t mc_paths,
+           double mc_tolerance,
+           double grid_tolerance,
+           std::size_t threads) {
+            const BermudanTrade shape = makeTrade(year, month, day, 0.0, model_name, engine, 1.0,
+                                                  mc_paths, mc_tolerance, grid_tolerance);
+            SurrogateSettings settings;
+            settings.minRate = min_rate;
+            settings.maxRate = max_rate;
+            settings.minMultiplier = min_multiplier;
+            settings.maxMultiplier = max_multiplier;
+            settings.rateNodes = rate_nodes;
+            settings.multiplierNodes = multiplier_nodes;
+            settings.checkNodes = check_nodes;
+            settings.tolerance = tolerance;
+            settings.threads = threads;
+
+            std::shared_ptr<const ChebyshevSurrogate> surrogate;
+            {
+                py::gil_scoped_release release;
+                surrogate = SurrogateCache::shared().build(shape, settings);
+            }
+            py::dict info;
+            info["checked_error"] = surrogate->checkedError();
+            info["tail_estimate"] = surrogate->tailEstimate();
+            info["error_estimate"] = surrogate->errorEstimate();
+            info["rate_nodes"] = rate_nodes;
+            info["multiplier_nodes"] = multiplier_nodes;
+            return info;
+        },
+        py::arg("year"), py::arg("month"), py::arg("day"),
+        py::arg("model_name"),
+        py::arg("engine"),
+        py::arg("min_rate"), py::arg("max_rate"),
+        py::arg("min_multiplier"), py::arg("max_multiplier"),
+        py::arg("rate_nodes") = 12,
+        py::arg("multiplier_nodes") = 12,
+        py::arg("check_nodes") = 7,
+        py::arg("tolerance") = 0.0,
+        py::arg("mc_paths") = 0,
+        py::arg("mc_tolerance") = 0.0,
+        py::arg("grid_tolerance") = 0.0,
+        py::arg("threads") = 0
+    );
+
+    // quote_bermudan(...) -> (npv, from_surrogate)
+    // Same inputs as price_bermudan; answered by the shape's surrogate when
+    // one covers the point, by the full pricer otherwise (None instead with
+    // fallback=False).
+    m.def("quote_bermudan",
+        [](int year, int month, int day,
+           double flat_rate,
+           const std::string& model_name,
+           const std::string& engine,
+           double strike_multiplier,
+           std::size_t mc_paths,
+           double mc_tolerance,
+           double grid_tolerance,
+           bool fallback) -> py::object {
+            const BermudanTrade trade = makeTrade(year, month, day, flat_rate, model_name, engine,
+                                                  strike_multiplier, mc_paths, mc_tolerance,
+                                                  grid_tolerance);
+            if (!fallback) {
+                const std::optional<double> npv = SurrogateCache::shared().quote(trade);
+                if (!npv)
+                    return py::none();
+                return py::make_tuple(*npv, true);
+            }
+            bool fromSurrogate = false;
+            double npv;
+            {
+                py::gil_scoped_release release;
+                npv = SurrogateCache::shared().price(trade, &fromSurrogate);
+            }
+            return py::make_tuple(npv, fromSurrogate);
         },
         py::arg("year"), py::arg("month"), py::arg("day"),
         py::arg("flat_rate"),
         py::arg("model_name"),
         py::arg("engine"),
-        py::arg("strike_multiplier")
+        py::arg("strike_multiplier"),
+        py::arg("mc_paths") = 0,
+        py::arg("mc_tolerance") = 0.0,
+        py::arg("grid_tolerance") = 0.0,
+        py::arg("fallback") = true
     );
-}
 
+    m.def("surrogate_info", []() {
+        const SurrogateCache& cache = SurrogateCache::shared();
+        py::dict info;
+        info["size"] = cache.size();
+        info["hits"] = cache.hits();
+        info["fallbacks"] = cache.fallbacks();
+        return info;
+    });
+
+    m.def("clear_surrogates", []() { SurrogateCache::shared().clear(); });
+
+    // metrics() -> {"enabled": bool,
+    //               "stages": {name: {"calls", "total_seconds", "max_seconds"}},
+    //               "counters": {name: int}}
+    m.def("metrics", []() {
+        const MetricsSnapshot snapshot = Metrics::snapshot();
+        py::dict stages;
+        for (const auto& s : snapshot.stages) {
+            py::dict d;
+            d["calls"] = s.calls;
+            d["total_seconds"] = s.totalSeconds;
+            d["max_seconds"] = s.maxSeconds;
+            stages[py::str(s.name)] = d;
+        }
+        py::dict counters;
+        for (const auto& c : snapshot.counters)
+            counters[py::str(c.name)] = c.value;
+        py::dict result;
+        result["enabled"] = snapshot.enabled;
+        result["stages"] = stages;
+        result["counters"] = counters;
+        return result;
+    });
+
+    m.def("reset_metrics", &Metrics::reset);
+}
@@ -0,0 +1,36 @@
+#ifndef ALIGNED_ALLOCATOR_HPP
+#define ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Cache-line aligned storage so SIMD kernels can use aligned loads.
+template <class T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <class U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+#endif // ALIGNED_ALLOCATOR_HPP
@@ -0,0 +1,104 @@
+#ifndef BASIC_BERMUDAN_SWAPTION_PRICER_HPP
+#define BASIC_BERMUDAN_SWAPTION_PRICER_HPP
+
+#include "GridCache.hpp"
+#include "GridSettings.hpp"
+#include "LsmcSettings.hpp"
+#include "Metrics.hpp"
+#include "PricerPolicies.hpp"
+
+#include <ql/instruments/swaption.hpp>
+#include <ql/instruments/vanillaswap.hpp>
+#include <ql/time/date.hpp>
+#include <ql/timegrid.hpp>
+#include <cstddef>
+#include <vector>
+
+// Runtime interface over the typed pricers, for callers that choose model
+// and engine from strings (BermudanSwaptionPricer).
+class BermudanSwaptionPricerBase {
+public:
+    virtual ~BermudanSwaptionPricerBase() = default;
+
+    virtual double price() = 0;
+    virtual std::vector<double> priceStrikes(const std::vector<QuantLib::Rate>& strikes) const = 0;
+    virtual std::size_t gridSteps() const = 0;
+    virtual double gridError() const = 0;
+    virtual const std::vector<QuantLib::Date>& exerciseDates() const = 0;
+    virtual const QuantLib::ext::shared_ptr<QuantLib::Swaption>& swaption() const = 0;
+};
+
+// Bermudan swaption pricer with the model (HullWhite, G2, BlackKarasinski)
+// and engine policy (PricerPolicies.hpp) fixed at compile time. Nothing
+// after construction compares engine names or casts the model, and called
+// on the concrete type price() inlines down to the swaption's NPV().
+// Pairing an engine with a model it cannot price does not compile.
+// Explicitly instantiated for every supported pair in
+// BasicBermudanSwaptionPricer.cpp. Semantics as BermudanSwaptionPricer.
+template <class Model, class Engine>
+class BasicBermudanSwaptionPricer final : public BermudanSwaptionPricerBase {
+    static_assert(Engine::template supports<Model>,
+                  "this engine cannot price this model");
+
+public:
+    BasicBermudanSwaptionPricer(
+        const QuantLib::ext::shared_ptr<QuantLib::VanillaSwap>& swap,
+        const QuantLib::ext::shared_ptr<Model>& model,
+        const QuantLib::TimeGrid* grid = nullptr,
+        const LsmcSettings& lsmc = LsmcSettings(),
+        const GridSettings& gridSettings = GridSettings());
+
+    double price() override {
+        BERMUDAN_TIME_STAGE(Stage::Price);
+        if constexpr (Engine::convergenceOrder > 0) {
+            if (autoGrid_)
+                return priceOnAutoGrid();
+        }
+        return swaption_->NPV();
+    }
+
+    std::vector<double> priceStrikes(const std::vector<QuantLib::Rate>& strikes) const override;
+
+    std::size_t gridSteps() const override;
+    double gridError() const override;
+
+    const std::vector<QuantLib::Date>& exerciseDates() const override { return exerciseDates_; }
+    const QuantLib::ext::shared_ptr<QuantLib::Swaption>& swaption() const override { return swaption_; }
+
+private:
+    struct LatticeCache;
+    struct AutoGrid;
+
+    QuantLib::ext::shared_ptr<QuantLib::PricingEngine> makeEngine(std::size_t steps = 0) const;
+    QuantLib::ext::shared_ptr<QuantLib::VanillaSwap> swapWithStrike(QuantLib::Rate strike) const;
+    QuantLib::TimeGrid latticeGrid(std::size_t steps = 0) const;
+    void cacheDiscountTimes(std::size_t steps = 0) const;
+    double priceOnAutoGrid() const;
+    const AutoGrid& autoGrid() const;
+    GridCache::Shape gridShape() const;
+    double extrapolate(double coarse, double fine) const;
+
+    QuantLib::ext::shared_ptr<QuantLib::VanillaSwap> swap_;
+    QuantLib::ext::shared_ptr<Model> model_;
+    const QuantLib::TimeGrid* grid_;
+    LsmcSettings lsmc_;
+    GridSettings gridSettings_;
+    std::vector<QuantLib::Date> exerciseDates_;
+    QuantLib::ext::shared_ptr<QuantLib::Swaption> swaption_;
+    QuantLib::ext::shared_ptr<QuantLib::PricingEngine> engine_;
+    QuantLib::ext::shared_ptr<LatticeCache> ladderLattice_;
+    QuantLib::ext::shared_ptr<AutoGrid> autoGrid_;
+};
+
+extern template class BasicBermudanSwaptionPricer<QuantLib::HullWhite, TreeEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::G2, TreeEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::BlackKarasinski, TreeEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::ShortRateModel, TreeEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::HullWhite, FdEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::G2, FdEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::G2, G2AdiEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::HullWhite, HwSimdEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::HullWhite, LsmcEngine>;
+extern template class BasicBermudanSwaptionPricer<QuantLib::G2, LsmcEngine>;
+
+#endif // BASIC_BERMUDAN_SWAPTION_PRICER_HPP
@@ -0,0 +1,28 @@
+#ifndef BERMUDAN_GREEKS_HPP
+#define BERMUDAN_GREEKS_HPP
+
+#include <ql/time/period.hpp>
+#include <cstddef>
+#include <vector>
+
+struct GreeksSettings {
+    // Zero-rate spread nodes (from settlement), linearly interpolated in time
+    std::vector<QuantLib::Period> buckets = {
+        QuantLib::Period(1, QuantLib::Years), QuantLib::Period(2, QuantLib::Years),
+        QuantLib::Period(3, QuantLib::Years), QuantLib::Period(5, QuantLib::Years),
+        QuantLib::Period(7, QuantLib::Years), QuantLib::Period(10, QuantLib::Years)};
+    double curveShift = 1e-4;        // absolute zero-rate bump
+    double paramShift = 1e-4;        // absolute bump of each model parameter
+    bool adjoint = false;            // HW tree only: deltas by reverse mode
+    std::size_t threads = 0;         // 0 -> shared pool
+};
+
+struct BermudanGreeks {
+    double npv = 0.0;
+    std::vector<QuantLib::Period> buckets;
+    std::vector<double> deltas;      // NPV change per +curveShift on each bucket
+    std::vector<double> vegas;       // NPV change per +paramShift on each model->params() entry
+    double gamma = 0.0;              // V(+s) - 2 V + V(-s) for a parallel curveShift s
+};
+
+#endif // BERMUDAN_GREEKS_HPP
@@ -0,0 +1,33 @@
+#ifndef BERMUDAN_SCENARIOS_HPP
+#define BERMUDAN_SCENARIOS_HPP
+
+#include <ql/time/period.hpp>
+#include <cstddef>
+#include <vector>
+
+struct ScenarioSettings {
+    // Zero-rate spread nodes (from settlement) the scenario shifts apply to,
+    // linearly interpolated in time as for the Greeks
+    std::vector<QuantLib::Period> buckets = {
+        QuantLib::Period(1, QuantLib::Years), QuantLib::Period(2, QuantLib::Years),
+        QuantLib::Period(3, QuantLib::Years), QuantLib::Period(5, QuantLib::Years),
+        QuantLib::Period(7, QuantLib::Years), QuantLib::Period(10, QuantLib::Years)};
+    // Model parameters per trade, held fixed in every scenario (e.g. from
+    // SwaptionCalibrator). Empty, or an empty entry -> trade.modelParams.
+    std::vector<std::vector<double>> modelParams;
+    std::size_t threads = 0;         // 0 -> shared pool
+};
+
+struct ScenarioResults {
+    std::vector<double> base;                   // NPV per trade, no shift
+    std::vector<std::vector<double>> npvs;      // [scenario][trade]
+
+    // Book P&L per scenario against the base
+    std::vector<double> pnl() const;
+
+    // Historical VaR: the ceil((1 - confidence) N)-th worst of the N
+    // scenario losses, as a positive number
+    double valueAtRisk(double confidence) const;
+};
+
+#endif // BERMUDAN_SCENARIOS_HPP
@@ -1,35 +1,128 @@
 #ifndef BERMUDAN_SWAPTION_PRICER_HPP
 #define BERMUDAN_SWAPTION_PRICER_HPP
 
+#include "BermudanGreeks.hpp"
+#include "BermudanScenarios.hpp"
+#include "BermudanTrade.hpp"
+#include "GridSettings.hpp"
+#include "LsmcSettings.hpp"
+
+#include <ql/handle.hpp>
 #include <ql/instruments/swaption.hpp>
 #include <ql/time/date.hpp>
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
+class BermudanSwaptionPricerBase;
+class MarketCache;
+
 namespace QuantLib {
     class VanillaSwap;
     class ShortRateModel;
     class TimeGrid;
+    class YieldTermStructure;
 }
 
+// String-configured facade over BasicBermudanSwaptionPricer<Model, Engine>:
+// the constructor resolves the model type (HullWhite, G2, BlackKarasinski)
+// and engine name ("tree" | "fdm" | "fdm-adi" | "hw-simd" | "lsmc") once and forwards
+// every call to the typed pricer. Other short-rate models price on
+// "tree" as ShortRateModel. "fdm" on models without an FD engine (BK and
+// the fallback) prices on the tree.
 class BermudanSwaptionPricer {
 public:
     BermudanSwaptionPricer(
         const QuantLib::ext::shared_ptr<QuantLib::VanillaSwap>& swap,
         const QuantLib::ext::shared_ptr<QuantLib::ShortRateModel>& model,
         const std::string& engineType,
-        const QuantLib::TimeGrid* grid = nullptr
+        const QuantLib::TimeGrid* grid = nullptr,
+        const LsmcSettings& lsmc = LsmcSettings(),
+        const GridSettings& gridSettings = GridSettings()
     );
+    ~BermudanSwaptionPricer();
 
+    // Exercise, instrument and engine are built once in the constructor;
+    // price() only reruns the numerical rollback when QuantLib observers
+    // report a change in the curve, model or swap. The grid is captured at
+    // construction.
+    //
+    // With gridSettings.tolerance > 0 (tree and FD engines, no fixed grid)
+    // the first call picks the resolution instead: it prices at minSteps,
+    // 2 minSteps, ... until the Richardson-extrapolated price of the two
+    // finest grids moves by less than the tolerance, or takes the choice
+    // recorded in GridCache::shared() for the same trade shape. Later calls
+    // price at that resolution and its half and return the extrapolation.
     double price();
 
+    // Auto grid: finest time steps in use and the error estimate behind the
+    // choice (0 until the first price() / priceStrikes()).
+    std::size_t gridSteps() const;
+    double gridError() const;
+
+    // Prices the same schedule at several fixed rates. Tree pricing builds
+    // the short-rate lattice once and rolls every strike back over it; the
+    // fitted lattice is kept for later calls until the model or its curve
+    // changes. FD and LSMC engines fall back to one solve per strike. With a
+    // grid tolerance every strike is extrapolated from the resolution price()
+    // picks and its half.
+    std::vector<double> priceStrikes(const std::vector<QuantLib::Rate>& strikes) const;
+
+    const std::vector<QuantLib::Date>& exerciseDates() const;
+    const QuantLib::ext::shared_ptr<QuantLib::Swaption>& swaption() const;
+
+    // Serial reference path: sets the evaluation date, builds curve, swap and
+    // model for the trade and prices it.
+    static double priceTrade(const BermudanTrade& trade);
+
+    // Prices a book on a work-stealing pool (threads = 0 -> all cores).
+    // Results are bitwise identical to priceTrade() on each element. On a
+    // stock QuantLib build "fdm" trades price one at a time: QuantLib's FD
+    // swaption engines clone the index inside calculate(), so the whole solve
+    // runs under QuantLibSession::Guard. The other engines only build and
+    // drop their objects under it.
+    static std::vector<double> priceBatch(std::span<const BermudanTrade> trades,
+                                          std::size_t threads = 0);
+
+    // Prices a book that repeats market inputs. Rows agreeing on date, flat
+    // rate, model, engine, LSMC and grid settings share one curve, model and
+    // pricer, and their strikes go through priceStrikes() (one lattice per
+    // chunk of up to ladderChunk rows). Matches priceTrade() to rounding.
+    // With a MarketCache the graphs (and fitted lattices) outlive the call.
+    static std::vector<double> priceBook(std::span<const BermudanTrade> trades,
+                                         std::size_t threads = 0,
+                                         std::size_t ladderChunk = 64,
+                                         MarketCache* markets = nullptr);
+
+    // Curve-bucket deltas, model-parameter vegas and parallel gamma. One
+    // market graph per worker shares the trade's schedule and tree grid;
+    // bumps are quote/parameter changes on it, run in parallel. With
+    // settings.adjoint (HW on "tree"/"hw-simd") the deltas come from one
+    // reverse sweep through the fitted lattice instead of 2 x buckets prices.
+    // On a stock QuantLib build it runs as a PricingService::shared() job, so
+    // the global evaluation date never moves under another job.
+    static BermudanGreeks greeks(const BermudanTrade& trade,
+                                 const GreeksSettings& settings = GreeksSettings());
+
+    // Reprices a book under curve scenarios: shifts[s] holds one zero-rate
+    // shift per settings.buckets node. Each worker builds a trade's market
+    // graph once (strike, schedule, model parameters and tree grid fixed)
+    // and moves through its share of the scenarios by setting spread
+    // quotes, so only what a shift invalidates is recomputed.
+    static ScenarioResults scenarios(std::span<const BermudanTrade> trades,
+                                     const std::vector<std::vector<double>>& shifts,
+                                     const ScenarioSettings& settings = ScenarioSettings());
+
+    // "g2" | "hw" | "bk"
+    static QuantLib::ext::shared_ptr<QuantLib::ShortRateModel>
+    makeModel(const std::string& name,
+              const QuantLib::Handle<QuantLib::YieldTermStructure>& ts);
+
 private:
-    QuantLib::ext::shared_ptr<QuantLib::VanillaSwap>   swap_;
-    QuantLib::ext::shared_ptr<QuantLib::ShortRateModel> model_;
-    std::string engineType_;
-    const QuantLib::TimeGrid* grid_;
+    std::unique_ptr<QuantLib::TimeGrid> fallbackGrid_;     // "fdm" on BK: tree on TimeGrid(50, 50)
+    std::unique_ptr<BermudanSwaptionPricerBase> impl_;
 };
 
 #endif // BERMUDAN_SWAPTION_PRICER_HPP
-
@@ -0,0 +1,26 @@
+#ifndef BERMUDAN_TRADE_HPP
+#define BERMUDAN_TRADE_HPP
+
+#include "GridSettings.hpp"
+#include "LsmcSettings.hpp"
+#include "SwapDescription.hpp"
+
+#include <ql/time/date.hpp>
+#include <string>
+#include <vector>
+
+// Self-contained description of one Bermudan pricing request. Holds values
+// only, so trades can be handed to any thread and rebuilt there.
+struct BermudanTrade {
+    QuantLib::Date evaluationDate;
+    double flatRate = 0.0;
+    std::string model = "hw";        // "g2" | "hw" | "bk"
+    std::string engine = "tree";     // "tree" | "fdm" | "fdm-adi" | "hw-simd" | "lsmc"
+    double strikeMultiplier = 1.0;   // 1.0=ATM, 1.2=OTM, 0.8=ITM
+    SwapDescription swap;            // underlying; exercisable on its fixed dates
+    std::vector<double> modelParams; // model->params() to price with; empty -> defaults
+    LsmcSettings lsmc;               // path count / error target, "lsmc" only
+    GridSettings grid;               // grid error target, tree and FD engines
+};
+
+#endif // BERMUDAN_TRADE_HPP
@@ -0,0 +1,77 @@
+#ifndef BOOTSTRAPPED_CURVE_HPP
+#define BOOTSTRAPPED_CURVE_HPP
+
+#include <ql/patterns/lazyobject.hpp>
+#include <ql/termstructures/yield/ratehelpers.hpp>
+#include <ql/termstructures/yieldtermstructure.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Flat-forward (log-linear discount) nodes in contiguous arrays: index 0 is
+// the reference date, then one node per pillar. Immutable once published,
+// so pricing threads can read it while the curve rebootstraps.
+struct DiscountCurveSnapshot {
+    std::vector<double> times;
+    std::vector<double> logDiscounts;
+    std::vector<double> forwards;       // per segment, continuously compounded
+
+    double discount(double t) const;    // flat forward outside the nodes
+};
+
+// Discount curve bootstrapped pillar by pillar from QuantLib rate helpers
+// (same log-linear discount interpolation as PiecewiseYieldCurve<Discount,
+// LogLinear>). Unlike PiecewiseYieldCurve it tracks which helper notified:
+// a quote tick re-solves that helper's pillar, then only the later pillars
+// whose instruments read a discount factor that actually moved. A deposit
+// tick touches one pillar; a swap tick touches it and the longer swaps.
+class BootstrappedCurve : public QuantLib::YieldTermStructure,
+                          public QuantLib::LazyObject {
+public:
+    BootstrappedCurve(const QuantLib::Date& referenceDate,
+                      std::vector<QuantLib::ext::shared_ptr<QuantLib::RateHelper>> helpers,
+                      const QuantLib::DayCounter& dayCounter,
+                      double accuracy = 1e-12);
+    ~BootstrappedCurve() override;
+
+    QuantLib::Date maxDate() const override;
+    void update() override;
+
+    // Current nodes; rebootstraps first if a quote moved
+    std::shared_ptr<const DiscountCurveSnapshot> snapshot() const;
+
+    // Pillars re-solved by the last (re)bootstrap
+    std::size_t lastSolvedPillars() const { return lastSolved_; }
+
+private:
+    class HelperWatch;
+    struct Pillar {
+        QuantLib::ext::shared_ptr<QuantLib::RateHelper> helper;
+        QuantLib::Date date;
+        std::vector<QuantLib::Time> reads;      // times whose discount the helper reads
+        bool readsSpan = false;                 // reads every time in [reads.front(), reads.back()]
+        std::vector<std::size_t> dependents;    // later pillars reading this pillar's node
+    };
+
+    QuantLib::DiscountFactor discountImpl(QuantLib::Time t) const override;
+    void performCalculations() const override;
+
+    void helperChanged(std::size_t index);
+    void layout() const;
+    void solve(std::size_t pillar) const;
+    void setNode(std::size_t node, double logDiscount) const;
+
+    std::vector<QuantLib::ext::shared_ptr<QuantLib::RateHelper>> helpers_;
+    double accuracy_;
+    std::vector<QuantLib::ext::shared_ptr<HelperWatch>> watches_;
+    mutable std::vector<Pillar> pillars_;       // sorted by pillar date
+    mutable std::vector<std::size_t> position_; // helper index -> pillar
+    mutable std::vector<char> dirty_;           // by helper index
+    mutable DiscountCurveSnapshot nodes_;
+    mutable std::shared_ptr<const DiscountCurveSnapshot> published_;
+    mutable bool layoutDirty_ = true;
+    mutable bool bootstrapping_ = false;
+    mutable std::size_t lastSolved_ = 0;
+};
+
+#endif // BOOTSTRAPPED_CURVE_HPP
@@ -0,0 +1,37 @@
+#ifndef BOOTSTRAPPED_CURVE_BUILDER_HPP
+#define BOOTSTRAPPED_CURVE_BUILDER_HPP
+
+#include "BootstrappedCurve.hpp"
+
+#include <ql/handle.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/termstructures/yield/ratehelpers.hpp>
+#include <functional>
+#include <vector>
+
+// Deposit/FRA/swap quotes -> BootstrappedCurve. Conventions follow
+// SwapBuilder: Euribor deposits and FRAs (TARGET, ModifiedFollowing,
+// Actual/360, two fixing days) and swaps against 6M Euribor with an annual
+// 30/360 unadjusted fixed leg. Each add* returns the quote driving the
+// instrument; setting it rebootstraps only the pillars it affects. Every
+// build() gets its own helpers on the shared quotes.
+class BootstrappedCurveBuilder {
+public:
+    QuantLib::ext::shared_ptr<QuantLib::SimpleQuote>
+    addDeposit(const QuantLib::Period& tenor, QuantLib::Rate rate);
+
+    QuantLib::ext::shared_ptr<QuantLib::SimpleQuote>
+    addFra(QuantLib::Natural monthsToStart, QuantLib::Natural monthsToEnd, QuantLib::Rate rate);
+
+    QuantLib::ext::shared_ptr<QuantLib::SimpleQuote>
+    addSwap(const QuantLib::Period& tenor, QuantLib::Rate rate);
+
+    // Actual/365 Fixed, extrapolating flat forward beyond the last pillar
+    QuantLib::ext::shared_ptr<BootstrappedCurve> build(const QuantLib::Date& settlementDate) const;
+    QuantLib::Handle<QuantLib::YieldTermStructure> buildCurve(const QuantLib::Date& settlementDate) const;
+
+private:
+    std::vector<std::function<QuantLib::ext::shared_ptr<QuantLib::RateHelper>()>> factories_;
+};
+
+#endif // BOOTSTRAPPED_CURVE_BUILDER_HPP
@@ -0,0 +1,37 @@
+#ifndef CACHED_TREE_SWAPTION_ENGINE_HPP
+#define CACHED_TREE_SWAPTION_ENGINE_HPP
+
+#include "FittedLatticeCache.hpp"
+
+#include <ql/instruments/swaption.hpp>
+#include <ql/models/shortrate/onefactormodels/blackkarasinski.hpp>
+#include <ql/pricingengines/genericmodelengine.hpp>
+#include <ql/timegrid.hpp>
+
+// TreeSwaptionEngine for BlackKarasinski ("tree" on bk) with the fitted tree
+// taken from a FittedLatticeCache instead of refitted per calculation. Same
+// tree, same DiscretizedSwaption rollback, so prices are unchanged; the
+// cache lookup reads the curve on the grid, so a moved curve or new
+// parameters fit a new tree.
+class CachedTreeSwaptionEngine
+    : public QuantLib::GenericModelEngine<QuantLib::BlackKarasinski,
+                                          QuantLib::Swaption::arguments,
+                                          QuantLib::Swaption::results> {
+public:
+    // Grid built per calculation from the swaption's mandatory times
+    CachedTreeSwaptionEngine(const QuantLib::ext::shared_ptr<QuantLib::BlackKarasinski>& model,
+                             QuantLib::Size timeSteps,
+                             FittedLatticeCache& cache = FittedLatticeCache::shared());
+    CachedTreeSwaptionEngine(const QuantLib::ext::shared_ptr<QuantLib::BlackKarasinski>& model,
+                             const QuantLib::TimeGrid& grid,
+                             FittedLatticeCache& cache = FittedLatticeCache::shared());
+
+    void calculate() const override;
+
+private:
+    QuantLib::Size timeSteps_;
+    QuantLib::TimeGrid grid_;
+    FittedLatticeCache& cache_;
+};
+
+#endif // CACHED_TREE_SWAPTION_ENGINE_HPP
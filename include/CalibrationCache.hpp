@@ -0,0 +1,64 @@
+#ifndef CALIBRATION_CACHE_HPP
+#define CALIBRATION_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// FNV-1a over a canonical byte stream. Doubles are hashed by bit pattern
+// (with -0 folded into +0), so equal inputs always give equal keys.
+class SnapshotHash {
+public:
+    void add(double value);
+    void add(std::int64_t value);
+    void add(const std::string& value);
+    std::uint64_t value() const { return hash_; }
+
+private:
+    void bytes(const void* data, std::size_t size);
+    std::uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+
+// Calibrated model parameters by market snapshot key. Bounded in-memory
+// LRU; lookups share a reader lock and stamp recency atomically, so
+// concurrent readers never serialize. With a directory every insert is
+// also written there (one file per key) and misses fall back to disk, so
+// separate processes and restarts share fits.
+class CalibrationCache {
+public:
+    explicit CalibrationCache(std::size_t capacity = 256, std::string directory = "");
+
+    std::optional<std::vector<double>> find(std::uint64_t key);
+    void insert(std::uint64_t key, const std::vector<double>& parameters);
+
+    std::size_t size() const;
+    void clear();                       // memory only; files are kept
+
+    // Process-wide cache, memory only
+    static CalibrationCache& shared();
+
+private:
+    struct Entry {
+        std::vector<double> parameters;
+        std::atomic<std::uint64_t> lastUse{0};
+    };
+
+    void insertInMemory(std::uint64_t key, const std::vector<double>& parameters);
+    std::string pathFor(std::uint64_t key) const;
+    std::optional<std::vector<double>> load(std::uint64_t key) const;
+    void store(std::uint64_t key, const std::vector<double>& parameters) const;
+
+    std::size_t capacity_;
+    std::string directory_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::uint64_t, std::unique_ptr<Entry>> entries_;
+    std::atomic<std::uint64_t> clock_{0};
+};
+
+#endif // CALIBRATION_CACHE_HPP
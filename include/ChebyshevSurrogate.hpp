@@ -0,0 +1,101 @@
+#ifndef CHEBYSHEV_SURROGATE_HPP
+#define CHEBYSHEV_SURROGATE_HPP
+
+#include "BermudanTrade.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Domain and accuracy of a surrogate: the box of flat rates and strike
+// multipliers it answers for and the Chebyshev nodes per axis.
+struct SurrogateSettings {
+    double minRate = 0.005;
+    double maxRate = 0.08;
+    double minMultiplier = 0.5;
+    double maxMultiplier = 1.5;
+    std::size_t rateNodes = 12;
+    std::size_t multiplierNodes = 12;
+    std::size_t checkNodes = 7;      // per axis, uniform over the box (corners included)
+    double tolerance = 0.0;          // > 0: building fails when errorEstimate() exceeds it
+    std::size_t threads = 0;         // offline pricing; 0 -> shared pool
+};
+
+// NPV of one trade shape (everything in BermudanTrade but flatRate and
+// strikeMultiplier) as a Chebyshev tensor interpolant in those two inputs.
+// Built by pricing the node grid, and then a separate check grid, with the
+// full pricer (a Batch job on PricingService::shared()). The error is
+// estimated, not bounded: checkedError() is the largest deviation seen on
+// the check grid, tailEstimate() the magnitude of the highest-degree
+// coefficients on each axis (what the truncated series would add next), and
+// errorEstimate() their sum. Evaluation is two nested
+// Clenshaw recurrences over the coefficient table: no allocation, no
+// QuantLib objects, safe to call from any thread.
+class ChebyshevSurrogate {
+public:
+    static ChebyshevSurrogate build(const BermudanTrade& shape,
+                                    const SurrogateSettings& settings = SurrogateSettings());
+
+    bool contains(double flatRate, double strikeMultiplier) const;
+    // Surrogate NPV; nullopt outside the domain
+    std::optional<double> price(double flatRate, double strikeMultiplier) const;
+
+    double checkedError() const { return checkedError_; }
+    double tailEstimate() const { return tailEstimate_; }
+    double errorEstimate() const { return checkedError_ + tailEstimate_; }
+    const SurrogateSettings& settings() const { return settings_; }
+    const std::vector<double>& coefficients() const { return coefficients_; }
+
+private:
+    ChebyshevSurrogate() = default;
+
+    SurrogateSettings settings_;
+    std::vector<double> coefficients_;  // [rate degree][multiplier degree]
+    double checkedError_ = 0.0;
+    double tailEstimate_ = 0.0;
+};
+
+// Surrogates by trade shape, for the quoting path: price() answers from the
+// shape's surrogate when the trade lies in its domain and runs the full
+// pricer (an Interactive PricingService::shared() job) otherwise.
+class SurrogateCache {
+public:
+    // Builds (offline, in parallel) and registers a surrogate for the shape,
+    // replacing any previous one
+    std::shared_ptr<const ChebyshevSurrogate>
+    build(const BermudanTrade& shape, const SurrogateSettings& settings = SurrogateSettings());
+
+    std::shared_ptr<const ChebyshevSurrogate> find(const BermudanTrade& trade) const;
+
+    // Surrogate NPV, or nullopt (counted as a fallback) when no surrogate
+    // covers the trade
+    std::optional<double> quote(const BermudanTrade& trade);
+    // quote(), else the full pricer; fromSurrogate, if given, reports which
+    double price(const BermudanTrade& trade, bool* fromSurrogate = nullptr);
+
+    std::size_t size() const;
+    void clear();
+    std::uint64_t hits() const;
+    std::uint64_t fallbacks() const;
+
+    static SurrogateCache& shared();
+
+private:
+    using Key = std::tuple<QuantLib::Date, std::string, std::string, SwapDescription,
+                           std::vector<double>, std::size_t, std::size_t, double, std::size_t,
+                           std::uint64_t, double, std::size_t, std::size_t, bool>;
+    static Key keyOf(const BermudanTrade& trade);
+
+    mutable std::mutex mutex_;
+    std::map<Key, std::shared_ptr<const ChebyshevSurrogate>> surrogates_;
+    std::uint64_t hits_ = 0;
+    std::uint64_t fallbacks_ = 0;
+};
+
+#endif // CHEBYSHEV_SURROGATE_HPP
@@ -0,0 +1,55 @@
+#ifndef FITTED_LATTICE_CACHE_HPP
+#define FITTED_LATTICE_CACHE_HPP
+
+#include <ql/shared_ptr.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace QuantLib {
+    class BlackKarasinski;
+    class Lattice;
+    class TimeGrid;
+}
+
+// Fitted Black-Karasinski trees (trinomial branching, node spacing,
+// probabilities and the per-step drift found by root search), keyed by what
+// the fit reads: model parameters, grid times and the curve's discount
+// factors on the grid. Trades on equal curves, parameters and grids share
+// one tree whatever objects they were built from, and a quote or parameter
+// change gives a new key, so a stale tree is never returned (it ages out of
+// the LRU). Trees are fitted against a private copy of those discounts and
+// their state prices completed before they are handed out, so a cached tree
+// references no caller objects and is read-only on every thread.
+class FittedLatticeCache {
+public:
+    explicit FittedLatticeCache(std::size_t capacity = 64);
+
+    QuantLib::ext::shared_ptr<QuantLib::Lattice>
+    tree(const QuantLib::BlackKarasinski& model, const QuantLib::TimeGrid& grid);
+
+    std::size_t size() const;
+    void clear();
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+    static FittedLatticeCache& shared();
+
+private:
+    struct Entry {
+        QuantLib::ext::shared_ptr<QuantLib::Lattice> lattice;
+        std::uint64_t lastUse = 0;
+    };
+    using Key = std::vector<double>;    // a, sigma, grid times, discounts
+
+    std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::map<Key, Entry> entries_;
+    std::uint64_t clock_ = 0;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+#endif // FITTED_LATTICE_CACHE_HPP
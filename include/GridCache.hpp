@@ -0,0 +1,72 @@
+#ifndef GRID_CACHE_HPP
+#define GRID_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Resolutions picked by the pricer's tolerance-driven grid search, keyed by
+// trade shape: engine, model type and (rounded) parameters, exercise count,
+// maturity, strike and the accuracy settings. Later trades of the same shape
+// price straight on the cached grid. Strikes and maturities make the shapes
+// of a live book open-ended, so the least recently used beyond capacity are
+// dropped.
+class GridCache {
+public:
+    explicit GridCache(std::size_t capacity = 1024);
+
+    struct Shape {
+        std::string engine;
+        std::string model;
+        std::vector<long> params;       // model parameters, 1e-4 buckets
+        std::size_t exercises = 0;
+        long maturityDays = 0;
+        long strikeBp = 0;
+        double tolerance = 0.0;
+        std::size_t minSteps = 0;
+        std::size_t maxSteps = 0;
+        bool richardson = true;
+
+        bool operator<(const Shape& o) const {
+            return std::tie(engine, model, params, exercises, maturityDays, strikeBp,
+                            tolerance, minSteps, maxSteps, richardson) <
+                   std::tie(o.engine, o.model, o.params, o.exercises, o.maturityDays,
+                            o.strikeBp, o.tolerance, o.minSteps, o.maxSteps, o.richardson);
+        }
+    };
+
+    struct Choice {
+        std::size_t steps = 0;          // finest resolution priced
+        double error = 0.0;             // error estimate when it was chosen
+    };
+
+    std::optional<Choice> find(const Shape& shape) const;
+    void insert(const Shape& shape, const Choice& choice);
+
+    std::size_t size() const;
+    void clear();
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+    static GridCache& shared();
+
+private:
+    struct Entry {
+        Choice choice;
+        std::uint64_t lastUse = 0;
+    };
+
+    std::size_t capacity_;
+    mutable std::mutex mutex_;
+    mutable std::map<Shape, Entry> choices_;
+    mutable std::uint64_t clock_ = 0;
+    mutable std::uint64_t hits_ = 0;
+    mutable std::uint64_t misses_ = 0;
+};
+
+#endif // GRID_CACHE_HPP
@@ -0,0 +1,56 @@
+#ifndef GRID_DISCOUNT_CURVE_HPP
+#define GRID_DISCOUNT_CURVE_HPP
+
+#include <ql/handle.hpp>
+#include <ql/patterns/lazyobject.hpp>
+#include <ql/termstructures/yieldtermstructure.hpp>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Discount factors of another curve, evaluated once on a set of times (the
+// pricing TimeGrid, exercise and payment times) and kept in flat arrays.
+// Lattice fitting and engines asking for one of those times get the cached
+// value; any other time goes to the underlying curve. Values are exactly the
+// underlying ones, so prices do not change. Observes the underlying handle:
+// a quote change drops the arrays and notifies the model on top. Meant for
+// curves whose discount is costly (interpolated, spread); an analytic curve
+// such as FlatForward is cheaper to evaluate than to look up.
+class GridDiscountCurve : public QuantLib::YieldTermStructure,
+                          public QuantLib::LazyObject {
+public:
+    explicit GridDiscountCurve(const QuantLib::Handle<QuantLib::YieldTermStructure>& curve);
+
+    // Adds times to the cached set (merged, sorted, deduplicated). Cached
+    // values stay valid, so observers are not notified.
+    void cacheTimes(const std::vector<QuantLib::Time>& times);
+
+    // Flat views over the cached set; recalculated first if the curve moved
+    const std::vector<QuantLib::Time>& times() const { return times_; }
+    const std::vector<QuantLib::DiscountFactor>& discounts() const;
+
+    std::size_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::size_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    QuantLib::DayCounter dayCounter() const override { return curve_->dayCounter(); }
+    QuantLib::Calendar calendar() const override { return curve_->calendar(); }
+    QuantLib::Natural settlementDays() const override { return curve_->settlementDays(); }
+    const QuantLib::Date& referenceDate() const override { return curve_->referenceDate(); }
+    QuantLib::Date maxDate() const override { return curve_->maxDate(); }
+    QuantLib::Time maxTime() const override { return curve_->maxTime(); }
+
+    void update() override;
+
+private:
+    QuantLib::DiscountFactor discountImpl(QuantLib::Time t) const override;
+    void performCalculations() const override;
+
+    QuantLib::Handle<QuantLib::YieldTermStructure> curve_;
+    std::vector<QuantLib::Time> times_;
+    mutable std::vector<QuantLib::DiscountFactor> discounts_;
+    // Read from any thread (metrics, tests) while a pricing thread counts
+    mutable std::atomic<std::size_t> hits_{0};
+    mutable std::atomic<std::size_t> misses_{0};
+};
+
+#endif // GRID_DISCOUNT_CURVE_HPP
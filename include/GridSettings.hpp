@@ -0,0 +1,18 @@
+#ifndef GRID_SETTINGS_HPP
+#define GRID_SETTINGS_HPP
+
+#include <cstddef>
+
+// Accuracy/latency knobs of the tree and FD engines. With tolerance > 0 the
+// pricer doubles the resolution from minSteps until the (Richardson
+// extrapolated) price moves by less than tolerance, and remembers the choice
+// per model and trade shape in GridCache::shared().
+struct GridSettings {
+    double tolerance = 0.0;        // target absolute NPV error; 0 -> fixed default grids
+    std::size_t minSteps = 16;     // coarsest time steps tried (FD: also space points)
+    std::size_t maxSteps = 1024;   // finest time steps tried
+    bool richardson = true;        // extrapolate the two finest prices
+    bool cache = true;             // reuse / record the chosen resolution
+};
+
+#endif // GRID_SETTINGS_HPP
@@ -0,0 +1,97 @@
+#ifndef HULL_WHITE_SOA_LATTICE_HPP
+#define HULL_WHITE_SOA_LATTICE_HPP
+
+#include "AlignedAllocator.hpp"
+#include "SwaptionCashflows.hpp"
+
+#include <ql/methods/lattices/lattice1d.hpp>
+#include <ql/models/shortrate/onefactormodel.hpp>
+#include <ql/time/daycounter.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace QuantLib {
+    class HullWhite;
+}
+
+// Structure-of-arrays copy of a fitted one-factor short-rate tree. Per step it
+// keeps node discounts, the three branch probabilities and the first
+// descendant index in contiguous 64-byte aligned arrays, and rolls assets
+// back with an AVX-512/AVX2 gather kernel picked at runtime (scalar
+// otherwise). Being a Lattice, QuantLib's discretized assets run on it as-is.
+class PricingWorkspace;
+
+class HullWhiteSoaLattice : public QuantLib::TreeLattice1D<HullWhiteSoaLattice> {
+public:
+    // A Bermudan swaption as grid indices: the underlying's coupons in
+    // SwaptionCashflow form, ordered by reset, and the exercise steps,
+    // ascending. The NPV is read at the first exercise.
+    struct Bermudan {
+        struct Coupon {
+            QuantLib::Size reset;
+            QuantLib::Size pay;
+            QuantLib::Real fixedPart;
+            QuantLib::Real bondPart;
+        };
+        std::vector<Coupon> coupons;
+        std::vector<QuantLib::Size> exercises;
+    };
+
+    explicit HullWhiteSoaLattice(
+        const QuantLib::ext::shared_ptr<QuantLib::OneFactorModel::ShortRateTree>& tree);
+
+    // Fits the tree with HullWhite::tree() and repacks it.
+    static QuantLib::ext::shared_ptr<HullWhiteSoaLattice>
+    build(const QuantLib::HullWhite& model, const QuantLib::TimeGrid& grid);
+
+    QuantLib::Size size(QuantLib::Size i) const { return sizes_[i]; }
+    QuantLib::DiscountFactor discount(QuantLib::Size i, QuantLib::Size index) const {
+        return steps_[i].discount[index];
+    }
+    QuantLib::Size descendant(QuantLib::Size i, QuantLib::Size index, QuantLib::Size branch) const {
+        return static_cast<QuantLib::Size>(steps_[i].base[index]) + branch;
+    }
+    QuantLib::Real probability(QuantLib::Size i, QuantLib::Size index, QuantLib::Size branch) const {
+        return steps_[i].prob[branch][index];
+    }
+    QuantLib::Real underlying(QuantLib::Size i, QuantLib::Size index) const {
+        return source_->underlying(i, index);
+    }
+
+    void stepback(QuantLib::Size i, const QuantLib::Array& values, QuantLib::Array& newValues) const;
+    void rollback(QuantLib::DiscretizedAsset& asset, QuantLib::Time to) const override;
+    void partialRollback(QuantLib::DiscretizedAsset& asset, QuantLib::Time to) const override;
+
+    // Maps cashflows and the exercise dates from referenceDate on onto the
+    // grid, reusing the storage of bermudan; false when one of their times
+    // is not a grid point.
+    bool locate(const std::vector<SwaptionCashflow>& cashflows,
+                const std::vector<QuantLib::Date>& exerciseDates,
+                const QuantLib::Date& referenceDate, const QuantLib::DayCounter& dayCounter,
+                Bermudan& bermudan) const;
+
+    // Backward induction of the underlying, the option and the discount
+    // bonds still owed by unreset coupons, as DiscretizedSwaption does it but
+    // on flat buffers from the workspace. Matches the TreeSwaptionEngine NPV
+    // to rounding; once the workspace has held the largest tree, no heap
+    // allocation.
+    QuantLib::Real value(const Bermudan& bermudan, PricingWorkspace& workspace) const;
+
+    // "avx512" | "avx2" | "scalar"
+    static const char* kernelName();
+
+private:
+    void stepback(QuantLib::Size i, const double* values, double* newValues) const;
+
+    struct Step {
+        AlignedVector<QuantLib::Real> discount;
+        AlignedVector<QuantLib::Real> prob[3];
+        AlignedVector<std::int32_t> base;
+    };
+
+    QuantLib::ext::shared_ptr<QuantLib::OneFactorModel::ShortRateTree> source_;
+    std::vector<QuantLib::Size> sizes_;
+    std::vector<Step> steps_;
+};
+
+#endif // HULL_WHITE_SOA_LATTICE_HPP
@@ -0,0 +1,55 @@
+#ifndef HULL_WHITE_TREE_ADJOINT_HPP
+#define HULL_WHITE_TREE_ADJOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reverse-mode differentiation of a Bermudan swaption on a fitted trinomial
+// short-rate tree. The tree geometry (node growth factors, branch
+// probabilities, descendants) is fixed; the curve enters only through the
+// drift fitting, D_ij = g_ij * P(t_{i+1}) / sum_j Q_ij g_ij. One forward
+// fitting sweep, one backward induction and one reverse sweep give the NPV
+// and dNPV/d ln P(0, t_i) at every grid time.
+class HullWhiteTreeAdjoint {
+public:
+    // Transition from grid index i to i + 1
+    struct Step {
+        std::vector<double> growth;            // exp(-x_ij dt_i)
+        std::vector<double> prob[3];
+        std::vector<std::int32_t> base;        // first descendant at i + 1
+    };
+
+    // At resetIndex the underlying receives fixedPart + bondPart * B(reset, pay)
+    struct Cashflow {
+        std::size_t resetIndex;
+        std::size_t payIndex;
+        double fixedPart;
+        double bondPart;
+    };
+
+    HullWhiteTreeAdjoint(std::vector<Step> steps, std::vector<std::size_t> sizes);
+
+    // discounts[i] = P(0, t_i) for every grid index. Exercise indices must be
+    // on or after valuationIndex; the NPV is read at valuationIndex.
+    double calculate(const std::vector<double>& discounts,
+                     const std::vector<Cashflow>& cashflows,
+                     const std::vector<std::size_t>& exerciseIndices,
+                     std::size_t valuationIndex);
+
+    // dNPV / d ln P(0, t_i); entry 0 is always zero.
+    const std::vector<double>& logDiscountSensitivities() const { return sensitivities_; }
+
+private:
+    using Values = std::vector<double>;
+
+    void rollback(std::size_t i, const Values& next, Values& continuation, Values& out) const;
+    void rollbackAdjoint(std::size_t i, const Values& adjoint, Values& nextAdjoint) const;
+
+    std::vector<Step> steps_;
+    std::vector<std::size_t> sizes_;
+    std::vector<Values> discount_;
+    std::vector<double> sensitivities_;
+};
+
+#endif // HULL_WHITE_TREE_ADJOINT_HPP
@@ -0,0 +1,18 @@
+#ifndef LSMC_SETTINGS_HPP
+#define LSMC_SETTINGS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Accuracy/latency knobs of the "lsmc" engine. Pricing stops at maxPaths or
+// as soon as the standard error is at or below tolerance, whichever is first.
+struct LsmcSettings {
+    std::size_t calibrationPaths = 8192;   // regression (exercise boundary) pass
+    std::size_t maxPaths = 65536;          // pricing pass cap
+    double tolerance = 0.0;                // target standard error; 0 -> run maxPaths
+    std::size_t blockSize = 1024;          // paths per task
+    std::uint64_t seed = 42;
+    std::size_t threads = 0;               // 0 -> shared pool
+};
+
+#endif // LSMC_SETTINGS_HPP
@@ -0,0 +1,73 @@
+#ifndef MARKET_CACHE_HPP
+#define MARKET_CACHE_HPP
+
+#include "BermudanTrade.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+class BermudanSwaptionPricer;
+
+// Hot pricing graphs for a long-running service: curve, ATM swap, model and
+// pricer per market (evaluation date, flat rate, model and its parameters,
+// engine, underlying swap description, LSMC and grid settings). A repeated market skips
+// curve/swap/model construction and reuses the pricer's fitted strike-ladder
+// lattice. Bounded LRU; an entry
+// serves one caller at a time and acquire() blocks while it is leased.
+// In session builds graphs are also keyed by thread, since a QuantLib
+// object graph belongs to the session that built it.
+class MarketCache {
+    struct Entry;
+
+public:
+    class Lease {
+    public:
+        BermudanSwaptionPricer& pricer() const;
+        double atmRate() const;         // fixed rate of the cached swap
+
+    private:
+        friend class MarketCache;
+        std::shared_ptr<Entry> entry_;
+        std::unique_lock<std::mutex> lock_;
+    };
+
+    explicit MarketCache(std::size_t capacity = 64);
+    ~MarketCache();
+
+    MarketCache(const MarketCache&) = delete;
+    MarketCache& operator=(const MarketCache&) = delete;
+
+    // Assumes trade.evaluationDate is set for the calling session. The
+    // trade's strike multiplier is ignored; graphs are struck at the money.
+    Lease acquire(const BermudanTrade& trade);
+
+    std::size_t size() const;
+    void clear();
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+    // Process-wide cache used by the Python service
+    static MarketCache& shared();
+
+private:
+    using Key = std::tuple<std::thread::id, QuantLib::Date, double, std::string, std::string,
+                           SwapDescription, std::vector<double>, std::size_t, std::size_t, double, std::size_t, std::uint64_t,
+                           std::size_t, double, std::size_t, std::size_t, bool>;
+    static Key keyOf(const BermudanTrade& trade);
+
+    std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::map<Key, std::shared_ptr<Entry>> entries_;
+    std::uint64_t clock_ = 0;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+#endif // MARKET_CACHE_HPP
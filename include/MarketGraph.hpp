@@ -0,0 +1,85 @@
+#ifndef MARKET_GRAPH_HPP
+#define MARKET_GRAPH_HPP
+
+#include "BermudanSwaptionPricer.hpp"
+#include "BermudanTrade.hpp"
+#include "GridDiscountCurve.hpp"
+
+#include <ql/instruments/vanillaswap.hpp>
+#include <ql/math/array.hpp>
+#include <ql/models/shortrate/shortratemodel.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/timegrid.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Trade objects on top of the flat curve plus bucket and parallel zero
+// spreads. Every bump or scenario is a quote or parameter change on this
+// graph, so observers do the invalidation and nothing is rebuilt between
+// repricings. Built and torn down under the session guard. Shared by the
+// Greeks and the scenario engine.
+class MarketGraph {
+public:
+    struct Bump {
+        enum Kind { Bucket, Parallel, Param } kind;
+        std::size_t index;
+        double shift;
+    };
+
+    // strike: fixed rate of the swap (none -> fairRate * strikeMultiplier).
+    // params: model parameters to price with (empty -> trade.modelParams).
+    MarketGraph(const BermudanTrade& trade, const std::vector<QuantLib::Period>& buckets,
+                std::optional<QuantLib::Rate> strike,
+                const std::vector<double>& params = std::vector<double>());
+    ~MarketGraph();
+
+    MarketGraph(const MarketGraph&) = delete;
+    MarketGraph& operator=(const MarketGraph&) = delete;
+
+    // grid must outlive the graph; null lets the engine pick its own
+    void attach(const QuantLib::TimeGrid* grid);
+
+    QuantLib::Rate strike() const { return strike_; }
+    QuantLib::Size parameterCount() const { return params_.size(); }
+
+    double price();
+
+    // Prices with one bump applied and reverts it
+    double price(const Bump& bump);
+
+    // Prices with the bucket spreads set to spreads (one per bucket); they
+    // stay set, so consecutive scenarios only notify what changed.
+    double price(const std::vector<double>& spreads);
+
+    // Mandatory times of the swaption with the default tree steps per
+    // period: the grid TreeSwaptionEngine(model, steps) would build on each
+    // call.
+    QuantLib::TimeGrid treeGrid() const;
+
+    // Bucket deltas from one reverse sweep through the fitted HW lattice.
+    // Only the drift fitting depends on the curve, so the tree geometry
+    // is built once and reused for every bucket.
+    std::vector<double> adjointDeltas(const QuantLib::TimeGrid& grid, double curveShift,
+                                      QuantLib::Real& npv) const;
+
+private:
+    void shift(const Bump& bump, double amount);
+    void release();
+
+    std::string engine_;
+    LsmcSettings lsmc_;
+    std::vector<QuantLib::ext::shared_ptr<QuantLib::SimpleQuote>> spreads_;
+    std::vector<QuantLib::Date> dates_;
+    QuantLib::ext::shared_ptr<QuantLib::SimpleQuote> parallel_;
+    QuantLib::Handle<QuantLib::YieldTermStructure> curve_;
+    QuantLib::ext::shared_ptr<GridDiscountCurve> modelCurve_;
+    QuantLib::Rate strike_ = 0.0;
+    QuantLib::ext::shared_ptr<QuantLib::VanillaSwap> swap_;
+    QuantLib::ext::shared_ptr<QuantLib::ShortRateModel> model_;
+    QuantLib::Array params_;
+    std::unique_ptr<BermudanSwaptionPricer> pricer_;
+};
+
+#endif // MARKET_GRAPH_HPP
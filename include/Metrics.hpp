@@ -0,0 +1,106 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Process-wide per-stage timers and counters for the pricing hot path.
+// Recording compiles to nothing unless BERMUDAN_METRICS is defined (CMake
+// option BERMUDAN_ENABLE_METRICS); the read side is always available and
+// reports zeros in a disabled build. Updates are relaxed atomic adds, so
+// concurrent pricers can record without locking.
+//
+// Stages run inside QuantLib's own engines (TreeSwaptionEngine, FD) are
+// only visible as part of Stage::Price; lattice build and rollback are
+// split out where this library drives them (priceStrikes, hw-simd).
+enum class Stage : std::size_t {
+    CurveBuild,             // YieldCurveBuilder::buildCurve
+    SwapBuild,              // SwapBuilder construction and buildSwap
+    FairRate,               // SwapBuilder::fairRate
+    ScheduleWalk,           // exercise dates from the fixed leg
+    EngineSetup,            // pricing engine and instrument construction
+    LatticeBuild,           // short-rate tree fit (and SoA repack)
+    Rollback,               // backward induction over a built lattice
+    Price,                  // BermudanSwaptionPricer::price, end to end
+    Calibration,            // SwaptionCalibrator::calibrateModel, end to end
+    Count
+};
+
+enum class Counter : std::size_t {
+    LatticeNodes,           // nodes summed over all steps of built lattices
+    LatticeSteps,           // time steps of built lattices
+    OptimizerEvaluations,   // calibration cost function evaluations
+    OptimizerGradients,     // calibration gradient evaluations
+    CalibrationCacheHits,
+    LatticeCacheHits,       // fitted trees served by FittedLatticeCache
+    Count
+};
+
+struct StageMetrics {
+    std::string name;
+    std::uint64_t calls = 0;
+    double totalSeconds = 0.0;
+    double maxSeconds = 0.0;
+};
+
+struct CounterMetrics {
+    std::string name;
+    std::uint64_t value = 0;
+};
+
+struct MetricsSnapshot {
+    bool enabled = false;
+    std::vector<StageMetrics> stages;
+    std::vector<CounterMetrics> counters;
+};
+
+class Metrics {
+public:
+    static constexpr bool enabled() {
+#ifdef BERMUDAN_METRICS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void record(Stage stage, std::chrono::nanoseconds elapsed);
+    static void add(Counter counter, std::uint64_t n);
+
+    static MetricsSnapshot snapshot();
+    static void reset();
+
+    static const char* name(Stage stage);
+    static const char* name(Counter counter);
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Stage stage)
+            : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() { record(stage_, std::chrono::steady_clock::now() - start_); }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Stage stage_;
+        std::chrono::steady_clock::time_point start_;
+    };
+};
+
+#define BERMUDAN_METRICS_CAT2(a, b) a##b
+#define BERMUDAN_METRICS_CAT(a, b) BERMUDAN_METRICS_CAT2(a, b)
+
+#ifdef BERMUDAN_METRICS
+#define BERMUDAN_TIME_STAGE(stage) \
+    ::Metrics::ScopedTimer BERMUDAN_METRICS_CAT(metricsTimer_, __LINE__)(stage)
+#define BERMUDAN_COUNT(counter, n) \
+    ::Metrics::add(counter, static_cast<std::uint64_t>(n))
+#else
+#define BERMUDAN_TIME_STAGE(stage) static_cast<void>(0)
+#define BERMUDAN_COUNT(counter, n) static_cast<void>(0)
+#endif
+
+#endif // METRICS_HPP
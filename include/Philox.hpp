@@ -0,0 +1,54 @@
+#ifndef PHILOX_HPP
+#define PHILOX_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// Philox4x32-10 counter-based generator (Salmon et al., SC'11). The output
+// is a pure function of (counter, key): a Monte Carlo path that encodes its
+// own index in the counter draws the same numbers on any thread, in any
+// order, with no generator state to share or skip ahead.
+class Philox4x32 {
+public:
+    using Counter = std::array<std::uint32_t, 4>;
+    using Key = std::array<std::uint32_t, 2>;
+
+    static Counter generate(Counter c, Key k) {
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                k[0] += 0x9E3779B9u;
+                k[1] += 0xBB67AE85u;
+            }
+            const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * c[0];
+            const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * c[2];
+            c = {std::uint32_t(p1 >> 32) ^ c[1] ^ k[0], std::uint32_t(p1),
+                 std::uint32_t(p0 >> 32) ^ c[3] ^ k[1], std::uint32_t(p0)};
+        }
+        return c;
+    }
+
+    // Two independent standard normals (Box-Muller on two 53-bit uniforms)
+    static void normals(const Counter& c, const Key& k, double& z0, double& z1) {
+        const Counter r = generate(c, k);
+        const double u0 = uniform(r[0], r[1]);
+        const double u1 = uniform(r[2], r[3]);
+        const double radius = std::sqrt(-2.0 * std::log(u0));
+        const double angle = 6.283185307179586 * u1;
+        z0 = radius * std::cos(angle);
+        z1 = radius * std::sin(angle);
+    }
+
+    static Key key(std::uint64_t seed) {
+        return {std::uint32_t(seed), std::uint32_t(seed >> 32)};
+    }
+
+private:
+    // in (0, 1): never 0, so the log above is finite
+    static double uniform(std::uint32_t hi, std::uint32_t lo) {
+        const std::uint64_t bits = ((std::uint64_t(hi) << 32) | lo) >> 11;
+        return (double(bits) + 0.5) * 0x1.0p-53;
+    }
+};
+
+#endif // PHILOX_HPP
@@ -0,0 +1,121 @@
+#ifndef PORTFOLIO_STREAM_HPP
+#define PORTFOLIO_STREAM_HPP
+
+#include "BermudanTrade.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// One row of a portfolio file
+struct PortfolioRow {
+    std::uint64_t id = 0;
+    BermudanTrade trade;
+};
+
+// Row of the binary format, stored as laid out here (little-endian hosts).
+// Also the trade layout of the shared-memory book (ShardedPricing.hpp).
+struct PortfolioRecord {
+    std::uint64_t id;
+    double flatRate;
+    double strikeMultiplier;
+    double notional;
+    std::int32_t evaluationDate;        // QuantLib serial number
+    std::int32_t forwardStart;
+    std::int32_t tenor;
+    std::int16_t fixedFrequency;        // QuantLib::Frequency
+    std::int16_t floatFrequency;
+    std::uint8_t forwardStartUnits;     // QuantLib::TimeUnit
+    std::uint8_t tenorUnits;
+    std::uint8_t model;                 // index into kModelCodes (TradeCodes.hpp)
+    std::uint8_t engine;                // index into kEngineCodes
+    std::int8_t type;                   // QuantLib::Swap::Type
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(PortfolioRecord) == 56, "portfolio record layout changed");
+static_assert(std::is_trivially_copyable_v<PortfolioRecord>);
+
+// Throws for a model or engine the format has no code for
+PortfolioRecord encodeRecord(const PortfolioRow& row);
+// Overwrites the fields the record stores; the rest of row.trade is kept
+void decodeRecord(const PortfolioRecord& record, PortfolioRow& row);
+
+// Sequential reader over a portfolio file. Two formats:
+//  - CSV with a header naming its columns: id, evaluation_date (ISO),
+//    flat_rate, model, engine, strike_multiplier, forward_start, tenor,
+//    fixed_frequency, float_frequency (periods such as "1Y", "6M"),
+//    notional, type ("payer" | "receiver"). evaluation_date and flat_rate
+//    are required; missing columns keep the defaults trade's values and a
+//    missing id is the row index.
+//  - Binary: a 16-byte header ("BSPF" magic, version, row count) followed by
+//    fixed 56-byte records, mapped read-only and released behind the cursor
+//    so resident memory stays flat. Written by BinaryPortfolioWriter.
+// Calendar, day counts, roll conventions, LSMC and grid settings always
+// come from the defaults trade.
+class PortfolioReader {
+public:
+    virtual ~PortfolioReader() = default;
+
+    // Fills row and returns true, or returns false at the end of the file
+    virtual bool next(PortfolioRow& row) = 0;
+
+    // Picks the format from the file's leading bytes
+    static std::unique_ptr<PortfolioReader> open(const std::string& path,
+                                                 const BermudanTrade& defaults = BermudanTrade());
+};
+
+class BinaryPortfolioWriter {
+public:
+    explicit BinaryPortfolioWriter(const std::string& path);
+    ~BinaryPortfolioWriter();
+
+    BinaryPortfolioWriter(const BinaryPortfolioWriter&) = delete;
+    BinaryPortfolioWriter& operator=(const BinaryPortfolioWriter&) = delete;
+
+    void write(const PortfolioRow& row);
+    void close();                       // patches the row count; idempotent
+
+private:
+    std::ofstream out_;
+    std::uint64_t count_ = 0;
+};
+
+// Result lines of the portfolio modes: header, then "id,npv,error" per
+// trade (NaN and a quoted message for a failed trade)
+inline constexpr const char* kPortfolioResultHeader = "id,npv,error";
+void writePortfolioResult(std::ostream& out, std::uint64_t id, double npv,
+                          const std::string& error);
+
+struct StreamSettings {
+    std::size_t window = 1024;          // trades in flight between reader and writer
+    std::size_t buildThreads = 1;       // curve/swap/model construction
+    std::size_t priceThreads = 0;       // 0 -> hardware_concurrency
+};
+
+struct StreamStats {
+    std::size_t trades = 0;
+    std::size_t failed = 0;
+    double seconds = 0.0;
+
+    double tradesPerSecond() const { return seconds > 0.0 ? trades / seconds : 0.0; }
+};
+
+// Prices a portfolio of any size in bounded memory. Parse, build (curve,
+// swap and model) and price run on their own threads connected by queues.
+// The reader blocks while settings.window trades are in flight (back-pressure
+// from the slowest stage), and the caller's thread writes "id,npv,error"
+// lines to out in input order. A trade that
+// fails to build or price gets NaN and its error; a malformed file throws.
+// Each NPV is bitwise identical to BermudanSwaptionPricer::priceTrade().
+//
+// On a stock QuantLib build the evaluation date is global, so the pipeline
+// drains whenever it changes between consecutive rows. Session builds set it
+// per thread and build each trade on the thread that prices it.
+StreamStats streamPortfolio(PortfolioReader& reader, std::ostream& out,
+                            const StreamSettings& settings = StreamSettings());
+
+#endif // PORTFOLIO_STREAM_HPP
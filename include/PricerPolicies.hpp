@@ -0,0 +1,120 @@
+#ifndef PRICER_POLICIES_HPP
+#define PRICER_POLICIES_HPP
+
+#include "LsmcSettings.hpp"
+
+#include <ql/shared_ptr.hpp>
+#include <cstddef>
+#include <type_traits>
+
+namespace QuantLib {
+    class BlackKarasinski;
+    class G2;
+    class HullWhite;
+    class Lattice;
+    class PricingEngine;
+    class ShortRateModel;
+    class TimeGrid;
+}
+
+// Engine policies of BasicBermudanSwaptionPricer. Each one names the engine,
+// lists the models it prices (checked when the pricer is instantiated) and
+// builds the QuantLib engine: steps = 0 is the engine's default grid (or the
+// caller's fixed grid), otherwise the auto-grid resolution. Lattice engines
+// also fit the lattice the strike ladder rolls back on. convergenceOrder is
+// the order Richardson extrapolation assumes in the step count; 0 means the
+// engine has no grid to refine.
+
+// TreeSwaptionEngine; Black-Karasinski trees come from
+// FittedLatticeCache::shared() (CachedTreeSwaptionEngine). ShortRateModel
+// is the facade's fallback for any other model with a tree; strike ladders
+// on it need a term-structure consistent model.
+struct TreeEngine {
+    static constexpr const char* name = "tree";
+    static constexpr bool usesLattice = true;
+    static constexpr int convergenceOrder = 1;
+
+    template <class Model>
+    static constexpr bool supports = std::is_same_v<Model, QuantLib::HullWhite> ||
+                                     std::is_same_v<Model, QuantLib::G2> ||
+                                     std::is_same_v<Model, QuantLib::BlackKarasinski> ||
+                                     std::is_same_v<Model, QuantLib::ShortRateModel>;
+
+    template <class Model>
+    static QuantLib::ext::shared_ptr<QuantLib::PricingEngine>
+    engine(const QuantLib::ext::shared_ptr<Model>& model, std::size_t steps,
+           const QuantLib::TimeGrid* grid, const LsmcSettings& lsmc);
+
+    template <class Model>
+    static QuantLib::ext::shared_ptr<QuantLib::Lattice>
+    lattice(const Model& model, const QuantLib::TimeGrid& grid);
+};
+
+// FdHullWhiteSwaptionEngine / FdG2SwaptionEngine; space points scale with
+// the steps (HW steps, G2 steps / 2 per factor). A fixed TimeGrid is ignored.
+struct FdEngine {
+    static constexpr const char* name = "fdm";
+    static constexpr bool usesLattice = false;
+    static constexpr int convergenceOrder = 2;
+
+    template <class Model>
+    static constexpr bool supports = std::is_same_v<Model, QuantLib::HullWhite> ||
+                                     std::is_same_v<Model, QuantLib::G2>;
+
+    template <class Model>
+    static QuantLib::ext::shared_ptr<QuantLib::PricingEngine>
+    engine(const QuantLib::ext::shared_ptr<Model>& model, std::size_t steps,
+           const QuantLib::TimeGrid* grid, const LsmcSettings& lsmc);
+};
+
+// HullWhiteSimdSwaptionEngine on HullWhiteSoaLattice
+struct HwSimdEngine {
+    static constexpr const char* name = "hw-simd";
+    static constexpr bool usesLattice = true;
+    static constexpr int convergenceOrder = 1;
+
+    template <class Model>
+    static constexpr bool supports = std::is_same_v<Model, QuantLib::HullWhite>;
+
+    template <class Model>
+    static QuantLib::ext::shared_ptr<QuantLib::PricingEngine>
+    engine(const QuantLib::ext::shared_ptr<Model>& model, std::size_t steps,
+           const QuantLib::TimeGrid* grid, const LsmcSettings& lsmc);
+
+    template <class Model>
+    static QuantLib::ext::shared_ptr<QuantLib::Lattice>
+    lattice(const Model& model, const QuantLib::TimeGrid& grid);
+};
+
+// G2AdiSwaptionEngine: G2++ PDE with the ADI sweeps spread over the thread
+// pool; space points scale with the steps (steps / 2 per factor).
+struct G2AdiEngine {
+    static constexpr const char* name = "fdm-adi";
+    static constexpr bool usesLattice = false;
+    static constexpr int convergenceOrder = 2;
+
+    template <class Model>
+    static constexpr bool supports = std::is_same_v<Model, QuantLib::G2>;
+
+    template <class Model>
+    static QuantLib::ext::shared_ptr<QuantLib::PricingEngine>
+    engine(const QuantLib::ext::shared_ptr<Model>& model, std::size_t steps,
+           const QuantLib::TimeGrid* grid, const LsmcSettings& lsmc);
+};
+
+struct LsmcEngine {
+    static constexpr const char* name = "lsmc";
+    static constexpr bool usesLattice = false;
+    static constexpr int convergenceOrder = 0;
+
+    template <class Model>
+    static constexpr bool supports = std::is_same_v<Model, QuantLib::HullWhite> ||
+                                     std::is_same_v<Model, QuantLib::G2>;
+
+    template <class Model>
+    static QuantLib::ext::shared_ptr<QuantLib::PricingEngine>
+    engine(const QuantLib::ext::shared_ptr<Model>& model, std::size_t steps,
+           const QuantLib::TimeGrid* grid, const LsmcSettings& lsmc);
+};
+
+#endif // PRICER_POLICIES_HPP
@@ -0,0 +1,74 @@
+#ifndef PRICING_CANCELLATION_HPP
+#define PRICING_CANCELLATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace QuantLib {
+    class DiscretizedAsset;
+}
+
+// Raised at a checkpoint once the running job was cancelled or missed its
+// deadline; the job's future carries it.
+class PricingCancelled : public std::runtime_error {
+public:
+    enum Reason { Cancelled, DeadlineExpired };
+
+    explicit PricingCancelled(Reason reason);
+    Reason reason() const { return reason_; }
+
+private:
+    Reason reason_;
+};
+
+// Cooperative cancellation of one pricing job. The job's thread installs its
+// token with a Scope; ThreadPool::parallelFor carries it into the tasks it
+// runs, and the pricing loops call checkpoint() between rollback steps, LSMC
+// blocks and book chunks. Outside a job checkpoint() is a thread-local load.
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CancellationToken(Clock::time_point deadline = Clock::time_point::max())
+        : deadline_(deadline) {}
+
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+    Clock::time_point deadline() const { return deadline_; }
+
+    // Throws PricingCancelled when cancelled or past the deadline
+    void check() const;
+
+    class Scope {
+    public:
+        explicit Scope(const CancellationToken* token) : previous_(current_) { current_ = token; }
+        ~Scope() { current_ = previous_; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const CancellationToken* previous_;
+    };
+
+    // Token of the job running on this thread; nullptr outside jobs
+    static const CancellationToken* current() { return current_; }
+
+    static void checkpoint() {
+        if (const CancellationToken* token = current_)
+            token->check();
+    }
+
+private:
+    std::atomic<bool> cancelled_{false};
+    Clock::time_point deadline_;
+    static thread_local const CancellationToken* current_;
+};
+
+// asset.rollback(to) one lattice step at a time with a checkpoint before
+// each step. Adjustments happen at the same times in the same order, so the
+// values are identical.
+void rollbackWithCheckpoints(QuantLib::DiscretizedAsset& asset, double to);
+
+#endif // PRICING_CANCELLATION_HPP
@@ -0,0 +1,131 @@
+#ifndef PRICING_SERVICE_HPP
+#define PRICING_SERVICE_HPP
+
+#include "BermudanTrade.hpp"
+#include "PricingCancellation.hpp"
+
+#include <ql/time/date.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+class MarketCache;
+
+// Dispatch order: every queued Interactive job before any Normal one, and
+// Normal before Batch
+enum class JobPriority { Interactive, Normal, Batch };
+
+struct JobOptions {
+    JobPriority priority = JobPriority::Normal;
+    // A job still queued at its deadline fails without running; a running
+    // one fails at its next checkpoint. Within a priority, earlier deadlines
+    // go first.
+    CancellationToken::Clock::time_point deadline = CancellationToken::Clock::time_point::max();
+    // Book jobs: pool threads per chunk (0 -> ThreadPool::shared()) and an
+    // optional MarketCache, as in BermudanSwaptionPricer::priceBook
+    std::size_t threads = 0;
+    MarketCache* markets = nullptr;
+};
+
+struct ServiceSettings {
+    std::size_t workers = 0;               // 0 -> hardware_concurrency
+    std::size_t reservedInteractive = 1;   // workers that never start Normal/Batch jobs
+    std::size_t bookChunk = 64;            // rows per queue item of a book job
+};
+
+class PricingService;
+
+// Handle on a submitted job. cancel() drops it from the queue, or stops it
+// at its next checkpoint; either way result throws PricingCancelled.
+template <class T>
+struct PricingJob {
+    std::future<T> result;
+    std::shared_ptr<CancellationToken> token;
+    PricingService* service = nullptr;
+
+    void cancel() const;
+};
+
+// Pricing jobs on a fixed set of worker threads, shared by the CLI, the
+// Python bindings and the API through shared(). Jobs are dispatched by
+// priority, then deadline, then submission order. A book is queued as
+// chunks of bookChunk rows of one evaluation date, each priced with
+// BermudanSwaptionPricer::priceBook, so an interactive quote waits for at
+// most one chunk of a running batch, and never when a reserved worker is
+// free. Results are those of priceTrade() / priceBook().
+//
+// On a stock QuantLib build the evaluation date is global: a job starts only
+// while the running jobs share its date, and the first job on a new date
+// waits for them to finish. Session builds run any mix of dates at once.
+class PricingService {
+public:
+    explicit PricingService(const ServiceSettings& settings = ServiceSettings());
+    // Fails queued jobs and cancels running ones, then joins the workers
+    ~PricingService();
+
+    PricingService(const PricingService&) = delete;
+    PricingService& operator=(const PricingService&) = delete;
+
+    PricingJob<double> submit(const BermudanTrade& trade,
+                              const JobOptions& options = JobOptions());
+    PricingJob<std::vector<double>> submitBook(std::vector<BermudanTrade> trades,
+                                               const JobOptions& options = JobOptions());
+    // Any other work on one evaluation date, dispatched and date-gated like
+    // a trade (the global date is already set when it runs on a stock build)
+    PricingJob<void> submitTask(const QuantLib::Date& date, std::function<void()> work,
+                                const JobOptions& options = JobOptions());
+
+    // Cancels every job holding the token; queued chunks fail right away
+    void cancel(const std::shared_ptr<CancellationToken>& token);
+
+    std::size_t workers() const { return threads_.size(); }
+    std::size_t queued() const;
+    std::size_t running() const;
+
+    static PricingService& shared();
+    // True on a worker thread while it runs a job
+    static bool inJob();
+
+private:
+    struct Task;
+    struct Order {
+        bool operator()(const std::shared_ptr<Task>& a, const std::shared_ptr<Task>& b) const;
+    };
+
+    void push(std::shared_ptr<Task> task);
+    std::shared_ptr<Task> next();
+    void take(const std::shared_ptr<Task>& task);
+    void failExpired();
+    void workerLoop();
+
+    ServiceSettings settings_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::set<std::shared_ptr<Task>, Order> queue_;
+    std::multimap<CancellationToken::Clock::time_point, std::shared_ptr<Task>> deadlines_;
+    std::set<const Task*> active_;
+    std::size_t backgroundSlots_ = 0;      // workers minus the interactive reserve
+    std::size_t activeBackground_ = 0;     // running Normal/Batch tasks
+    QuantLib::Date activeDate_;            // stock builds: date of the running tasks
+    std::uint64_t sequence_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_;
+};
+
+template <class T>
+void PricingJob<T>::cancel() const {
+    if (service)
+        service->cancel(token);
+    else
+        token->cancel();
+}
+
+#endif // PRICING_SERVICE_HPP
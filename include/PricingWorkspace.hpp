@@ -0,0 +1,75 @@
+#ifndef PRICING_WORKSPACE_HPP
+#define PRICING_WORKSPACE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Per-thread scratch for repeated pricing (node values, rollback buffers,
+// FD vectors). A bump arena: take() hands out 64-byte aligned spans, a Scope
+// gives them back on exit, and the blocks stay with the thread. When a pass
+// needed more than one block they are merged into one at the end of the
+// outermost scope, so once a thread has priced its largest trade, repricing
+// performs no heap allocation here.
+class PricingWorkspace {
+public:
+    static constexpr std::size_t alignment = 64;
+
+    class Scope {
+    public:
+        explicit Scope(PricingWorkspace& workspace);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PricingWorkspace& workspace_;
+        std::size_t block_;
+        std::size_t used_;
+    };
+
+    PricingWorkspace() = default;
+    PricingWorkspace(const PricingWorkspace&) = delete;
+    PricingWorkspace& operator=(const PricingWorkspace&) = delete;
+
+    // Uninitialized storage for n objects, valid until the enclosing Scope ends
+    template <class T>
+    std::span<T> take(std::size_t n) {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                      "workspace buffers hold plain values");
+        static_assert(alignof(T) <= alignment);
+        return {static_cast<T*>(allocate(n * sizeof(T))), n};
+    }
+
+    std::size_t capacity() const;      // bytes over all blocks
+    std::size_t blockCount() const { return blocks_.size(); }
+
+    // Frees every block; only outside a Scope
+    void release();
+
+    // The calling thread's workspace
+    static PricingWorkspace& local();
+
+private:
+    struct Free {
+        void operator()(std::byte* p) const { ::operator delete(p, std::align_val_t(alignment)); }
+    };
+    struct Block {
+        std::unique_ptr<std::byte, Free> data;
+        std::size_t size;
+    };
+
+    void* allocate(std::size_t bytes);
+    void rewind(std::size_t block, std::size_t used);
+
+    std::vector<Block> blocks_;
+    std::size_t current_ = 0;          // block take() carves from
+    std::size_t used_ = 0;             // bytes used in it
+    std::size_t depth_ = 0;            // open scopes
+};
+
+#endif // PRICING_WORKSPACE_HPP
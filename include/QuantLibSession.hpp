@@ -0,0 +1,39 @@
+#ifndef QUANTLIB_SESSION_HPP
+#define QUANTLIB_SESSION_HPP
+
+#include <ql/qldefines.hpp>
+#include <mutex>
+
+// QuantLib keeps Settings, IndexManager and the observer registries in
+// process-global singletons. With a sessions-enabled QuantLib build
+// (BERMUDAN_ENABLE_SESSIONS=ON) every thread gets its own copy and pricing
+// threads are fully isolated. On a stock build the object graph of a trade is
+// still confined to one thread, but anything that registers with or notifies
+// a global observable (building indexes/coupons, tearing them down, FD
+// engines that clone the index) must run under Guard.
+class QuantLibSession {
+public:
+    static constexpr bool isolated() {
+#if defined(QL_ENABLE_SESSIONS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Scoped lock on QuantLib global state; a no-op in session builds.
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    private:
+        bool locked_;
+    };
+
+private:
+    static std::recursive_mutex& globalMutex();
+};
+
+#endif // QUANTLIB_SESSION_HPP
@@ -0,0 +1,56 @@
+#ifndef SCHEDULE_POOL_HPP
+#define SCHEDULE_POOL_HPP
+
+#include <ql/time/schedule.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+// Interned coupon schedules. A book of Bermudans shares a handful of
+// calendars, tenors and roll conventions, so most trades resolve to a
+// schedule another trade already generated; builders hold the shared,
+// immutable copy instead of generating and storing their own. What this
+// saves is the date generation (calendar adjustments) per builder and the
+// builders' copies: each VanillaSwap still copies both schedules and builds
+// its own coupons, so per-swap memory is unchanged. Start dates move with
+// the evaluation date, so the least recently used beyond capacity are
+// dropped.
+class SchedulePool {
+public:
+    explicit SchedulePool(std::size_t capacity = 1024);
+
+    QuantLib::ext::shared_ptr<const QuantLib::Schedule>
+    schedule(const QuantLib::Date& start, const QuantLib::Date& maturity,
+             const QuantLib::Period& tenor, const QuantLib::Calendar& calendar,
+             QuantLib::BusinessDayConvention convention,
+             QuantLib::DateGeneration::Rule rule, bool endOfMonth);
+
+    std::size_t size() const;
+    void clear();
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+    static SchedulePool& shared();
+
+private:
+    using Key = std::tuple<QuantLib::Date, QuantLib::Date, QuantLib::Integer, QuantLib::TimeUnit,
+                           std::string, QuantLib::BusinessDayConvention,
+                           QuantLib::DateGeneration::Rule, bool>;
+
+    struct Entry {
+        QuantLib::ext::shared_ptr<const QuantLib::Schedule> schedule;
+        std::uint64_t lastUse = 0;
+    };
+
+    std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::map<Key, Entry> schedules_;
+    std::uint64_t clock_ = 0;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+#endif // SCHEDULE_POOL_HPP
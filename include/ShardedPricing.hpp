@@ -0,0 +1,49 @@
+#ifndef SHARDED_PRICING_HPP
+#define SHARDED_PRICING_HPP
+
+#include "PortfolioStream.hpp"
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Market data published once for every worker: calibrated parameters by
+// model name ("hw", "g2", "bk"), used by every trade on that model. Curves
+// travel with the trades (flat rate per row).
+struct MarketSnapshot {
+    std::map<std::string, std::vector<double>> modelParams;
+};
+
+struct ShardSettings {
+    std::size_t workers = 0;            // processes; 0 -> hardware_concurrency
+    std::size_t threadsPerWorker = 1;   // priceBook() threads inside a worker
+    // Set: the program posix_spawn()ed as "EXE --worker SEGMENT INDEX COUNT
+    // THREADS", which has to call runShardWorker() for that command line.
+    // Empty: fork() the workers, which the children only get the calling
+    // thread for, so it is refused once ThreadPool::shared() is running.
+    std::string workerExecutable;
+};
+
+// Multi-process pricing of a portfolio file (PortfolioReader formats). The
+// coordinator writes the snapshot and every trade once into a POSIX
+// shared-memory book, starts the workers, which map it read-only and price
+// a contiguous shard each through priceBook() with no market setup of
+// their own, and merges their results into "id,npv,error" lines in input
+// order. NPVs match priceTrade() to rounding; a worker writes the error
+// text of a failed trade, truncated to 255 characters, next to its result.
+//
+// The book is position-independent (a header, then offsets into the
+// segment), so the same bytes could be shipped to a remote worker over a
+// socket instead of being mapped.
+StreamStats priceSharded(const std::string& portfolio, std::ostream& out,
+                         const MarketSnapshot& market = MarketSnapshot(),
+                         const ShardSettings& settings = ShardSettings());
+
+// Worker side: prices shard index of count of the named book and writes the
+// results back into the book's result segment.
+void runShardWorker(const std::string& segment, std::size_t index, std::size_t count,
+                    std::size_t threads);
+
+#endif // SHARDED_PRICING_HPP
@@ -1,27 +1,34 @@
 #ifndef SWAP_BUILDER_HPP
 #define SWAP_BUILDER_HPP
 
+#include "SwapDescription.hpp"
+
 #include <ql/handle.hpp>
 #include <ql/indexes/ibor/euribor.hpp>
 #include <ql/instruments/vanillaswap.hpp>
 #include <ql/time/schedule.hpp>
 
+// Swaps of one description on one curve. Schedules come from
+// SchedulePool::shared(), so builders for the same dates share them (the
+// swaps built from them take their own copies).
 class SwapBuilder {
 public:
-    explicit SwapBuilder(const QuantLib::Handle<QuantLib::YieldTermStructure>& termStructure);
+    explicit SwapBuilder(const QuantLib::Handle<QuantLib::YieldTermStructure>& termStructure,
+                         const SwapDescription& description = SwapDescription());
 
     QuantLib::ext::shared_ptr<QuantLib::VanillaSwap> buildSwap(QuantLib::Rate fixedRate) const;
 
     QuantLib::Rate fairRate() const;
-    QuantLib::Schedule fixedSchedule() const;
-    QuantLib::Schedule floatSchedule() const;
+    const QuantLib::Schedule& fixedSchedule() const { return *fixedSchedule_; }
+    const QuantLib::Schedule& floatSchedule() const { return *floatSchedule_; }
+    const SwapDescription& description() const { return description_; }
 
 private:
     QuantLib::Handle<QuantLib::YieldTermStructure> termStructure_;
-    QuantLib::ext::shared_ptr<QuantLib::Euribor6M> indexSixMonths_;
-    QuantLib::Schedule fixedSchedule_;
-    QuantLib::Schedule floatSchedule_;
+    SwapDescription description_;
+    QuantLib::ext::shared_ptr<QuantLib::Euribor> index_;
+    QuantLib::ext::shared_ptr<const QuantLib::Schedule> fixedSchedule_;
+    QuantLib::ext::shared_ptr<const QuantLib::Schedule> floatSchedule_;
 };
 
 #endif // SWAP_BUILDER_HPP
-
@@ -0,0 +1,47 @@
+#ifndef SWAP_DESCRIPTION_HPP
+#define SWAP_DESCRIPTION_HPP
+
+#include <ql/instruments/swap.hpp>
+#include <ql/time/businessdayconvention.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <ql/time/daycounters/thirty360.hpp>
+#include <ql/time/dategenerationrule.hpp>
+#include <ql/time/period.hpp>
+#include <string>
+#include <tuple>
+
+// Underlying of a Bermudan: fixed vs Euribor swap starting forwardStart
+// after the curve reference date and running for tenor. The float leg
+// fixes on the Euribor index of its own frequency. Defaults are the
+// 1Y-forward 5Y annual 30/360 vs semiannual Euribor payer on 1000.
+struct SwapDescription {
+    QuantLib::Period forwardStart = QuantLib::Period(1, QuantLib::Years);
+    QuantLib::Period tenor = QuantLib::Period(5, QuantLib::Years);
+    QuantLib::Frequency fixedFrequency = QuantLib::Annual;
+    QuantLib::Frequency floatFrequency = QuantLib::Semiannual;
+    QuantLib::DayCounter fixedDayCounter = QuantLib::Thirty360(QuantLib::Thirty360::European);
+    QuantLib::DayCounter floatDayCounter = QuantLib::Actual360();
+    QuantLib::Calendar calendar = QuantLib::TARGET();
+    QuantLib::BusinessDayConvention fixedConvention = QuantLib::Unadjusted;
+    QuantLib::BusinessDayConvention floatConvention = QuantLib::ModifiedFollowing;
+    QuantLib::DateGeneration::Rule rule = QuantLib::DateGeneration::Forward;
+    bool endOfMonth = false;
+    QuantLib::Real notional = 1000.0;
+    QuantLib::Swap::Type type = QuantLib::Swap::Payer;
+
+    bool operator==(const SwapDescription& o) const { return tie() == o.tie(); }
+    bool operator!=(const SwapDescription& o) const { return !(*this == o); }
+    bool operator<(const SwapDescription& o) const { return tie() < o.tie(); }
+
+private:
+    auto tie() const {
+        return std::make_tuple(forwardStart.length(), forwardStart.units(), tenor.length(),
+                               tenor.units(), fixedFrequency, floatFrequency,
+                               fixedDayCounter.name(), floatDayCounter.name(), calendar.name(),
+                               fixedConvention, floatConvention, rule, endOfMonth, notional,
+                               type);
+    }
+};
+
+#endif // SWAP_DESCRIPTION_HPP
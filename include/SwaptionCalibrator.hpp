@@ -1,32 +1,86 @@
 #ifndef SWAPTION_CALIBRATOR_HPP
 #define SWAPTION_CALIBRATOR_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
 #include <vector>
+#include <ql/handle.hpp>
+#include <ql/math/array.hpp>
+#include <ql/math/optimization/endcriteria.hpp>
 #include <ql/models/shortrate/calibrationhelpers/swaptionhelper.hpp>
 
 namespace QuantLib {
     class CalibratedModel;      // declares calibrate(...)
     class OptimizationMethod;   // forward-declare
     class BlackCalibrationHelper;
+    class YieldTermStructure;
 }
 
+class CalibrationCache;
+
+struct CalibrationSettings {
+    QuantLib::Size maxIterations = 400;
+    QuantLib::Size maxStationaryIterations = 100;
+    QuantLib::Real rootEpsilon = 1e-8;
+    QuantLib::Real functionEpsilon = 1e-8;
+    QuantLib::Real gradientNormEpsilon = 1e-8;
+    std::vector<double> initialGuess;   // explicit start, overrides the warm start
+    bool warmStart = true;              // start from this calibrator's last fit of the same model type
+    std::size_t threads = 0;            // helper repricing: 0 -> shared pool, 1 -> serial
+    // Opt-in result cache (e.g. &CalibrationCache::shared()). cacheTag must
+    // name whatever else the fit depends on, typically the helper engines.
+    CalibrationCache* cache = nullptr;
+    std::string cacheTag;
+};
+
+struct CalibrationResult {
+    QuantLib::Array parameters;
+    QuantLib::EndCriteria::Type endCriteria = QuantLib::EndCriteria::None;
+    QuantLib::Size evaluations = 0;     // cost function evaluations
+    bool fromCache = false;
+    bool parallel = false;              // helpers were repriced on a pool
+};
+
 class SwaptionCalibrator {
 public:
     SwaptionCalibrator(
         const std::vector<QuantLib::ext::shared_ptr<QuantLib::BlackCalibrationHelper>>& swaptions,
         const std::vector<double>& marketVols,
-        const std::vector<int>& swapLengths
+        const std::vector<int>& swapLengths,
+        const QuantLib::Handle<QuantLib::YieldTermStructure>& curve =
+            QuantLib::Handle<QuantLib::YieldTermStructure>()
     );
 
+    // Same problem as CalibratedModel::calibrate, and the model's
+    // endCriteria(), problemValues() and functionEvaluation() are set as
+    // calibrate() sets them (cleared on a cache hit). Unless settings.threads
+    // is 1, each cost evaluation (and so each finite-difference Jacobian
+    // column) reprices the helpers in parallel; the columns themselves stay
+    // serial, as they all move the one model's parameters. Helpers sharing a
+    // pricing engine instance (one engine set on every helper) or priced by
+    // the FD swaption engines (which clone the index) are repriced serially
+    // whatever the setting.
     // QL 1.25 requires non-const OptimizationMethod&
-    void calibrateModel(const QuantLib::ext::shared_ptr<QuantLib::CalibratedModel>& model,
-                        QuantLib::OptimizationMethod& method);
+    CalibrationResult calibrateModel(const QuantLib::ext::shared_ptr<QuantLib::CalibratedModel>& model,
+                                     QuantLib::OptimizationMethod& method,
+                                     const CalibrationSettings& settings = CalibrationSettings());
+
+    // Canonical key of everything the fit depends on: evaluation date, the
+    // curve (sampled on fixed pillars), marketVols_, swapLengths_, helper
+    // market values, model type, optimizer type, end criteria, initial guess
+    // and cacheTag. Thread count and warm starts do not enter it.
+    std::uint64_t snapshotKey(const QuantLib::CalibratedModel& model,
+                              const QuantLib::OptimizationMethod& method,
+                              const CalibrationSettings& settings) const;
 
 private:
     std::vector<QuantLib::ext::shared_ptr<QuantLib::BlackCalibrationHelper>> swaptions_;
     std::vector<double> marketVols_;
     std::vector<int> swapLengths_;
+    QuantLib::Handle<QuantLib::YieldTermStructure> curve_;
+    std::map<std::string, QuantLib::Array> warmStarts_;   // by model type
 };
 
 #endif // SWAPTION_CALIBRATOR_HPP
-
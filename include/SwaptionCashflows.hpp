@@ -0,0 +1,31 @@
+#ifndef SWAPTION_CASHFLOWS_HPP
+#define SWAPTION_CASHFLOWS_HPP
+
+#include <ql/instruments/swaption.hpp>
+#include <vector>
+
+// One coupon of a swaption's underlying, seen from its reset date: it is
+// worth fixedPart + bondPart * P(reset, pay) there (floating coupons as
+// N - N P + spread accrual, fixed coupons as -c P, signs for a payer swap
+// flipped for a receiver). This is the linear form DiscretizedSwap rolls
+// back; models with analytic bonds can value the underlying directly.
+struct SwaptionCashflow {
+    QuantLib::Date resetDate;
+    QuantLib::Date payDate;
+    QuantLib::Real fixedPart;
+    QuantLib::Real bondPart;
+};
+
+// Reset dates in the week before an exercise date are moved onto it, as
+// DiscretizedSwaption does. Coupons resetting before referenceDate are
+// dropped: no remaining exercise date can enter them.
+std::vector<SwaptionCashflow>
+swaptionCashflows(const QuantLib::Swaption::arguments& args,
+                  const QuantLib::Date& referenceDate);
+
+// Same, into cashflows (reusing its storage)
+void swaptionCashflows(const QuantLib::Swaption::arguments& args,
+                       const QuantLib::Date& referenceDate,
+                       std::vector<SwaptionCashflow>& cashflows);
+
+#endif // SWAPTION_CASHFLOWS_HPP
@@ -0,0 +1,77 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing pool: every worker owns a deque, pops its own tasks LIFO and
+// steals FIFO from the others when it runs dry. Threads blocked in wait() or
+// parallelFor() help execute queued tasks, so nested use does not deadlock.
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads = 0);   // 0 -> hardware_concurrency
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const { return threads_.size(); }
+
+    void submit(std::function<void()> task);
+
+    template <class F>
+    auto async(F&& f) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        submit([task]() { (*task)(); });
+        return result;
+    }
+
+    // Runs body(i) for i in [0, n) in chunks of `grain` and rethrows the first
+    // exception raised by any iteration. Chunks run under the calling thread's
+    // CancellationToken and check it before starting.
+    void parallelFor(std::size_t n,
+                     const std::function<void(std::size_t)>& body,
+                     std::size_t grain = 1);
+
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    // Process-wide pool sized to the hardware.
+    static ThreadPool& shared();
+
+    // Whether shared() has started its threads (PricingService::shared()
+    // does too), after which fork() is no longer safe.
+    static bool sharedStarted();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool tryRunOne(std::size_t self);
+    void workerLoop(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> next_{0};
+    std::atomic<bool> stop_{false};
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,11 @@
+#ifndef TRADE_CODES_HPP
+#define TRADE_CODES_HPP
+
+// Integer codes of BermudanTrade model and engine names: the index into
+// these tables. Binary portfolios (PortfolioRecord) store them and the
+// Python batch API exports them as MODEL_CODES / ENGINE_CODES, so new names
+// are appended, never reordered.
+inline constexpr const char* kModelCodes[] = {"hw", "g2", "bk"};
+inline constexpr const char* kEngineCodes[] = {"tree", "fdm", "hw-simd", "lsmc", "fdm-adi"};
+
+#endif // TRADE_CODES_HPP
@@ -0,0 +1,32 @@
+#ifndef TRADE_OBJECTS_HPP
+#define TRADE_OBJECTS_HPP
+
+#include "BermudanTrade.hpp"
+
+#include <ql/handle.hpp>
+#include <ql/instruments/vanillaswap.hpp>
+#include <ql/models/shortrate/shortratemodel.hpp>
+#include <ql/termstructures/yieldtermstructure.hpp>
+
+// QuantLib object graph for one trade: flat curve, swap struck at
+// fairRate * strikeMultiplier, and the short-rate model on the curve (its
+// analytic discount needs no GridDiscountCurve in between). Building and
+// tearing it down registers/unregisters coupons and indexes with global
+// observables, so both happen under the session guard; pricing in between
+// does not.
+struct TradeObjects {
+    QuantLib::Handle<QuantLib::YieldTermStructure> ts;
+    QuantLib::ext::shared_ptr<QuantLib::VanillaSwap> swap;
+    QuantLib::ext::shared_ptr<QuantLib::ShortRateModel> model;
+
+    explicit TradeObjects(const BermudanTrade& trade);
+    ~TradeObjects();
+
+    TradeObjects(const TradeObjects&) = delete;
+    TradeObjects& operator=(const TradeObjects&) = delete;
+
+private:
+    void release();
+};
+
+#endif // TRADE_OBJECTS_HPP
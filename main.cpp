@@ -1,16 +1,35 @@
 #include "YieldCurveBuilder.hpp"
 #include "SwapBuilder.hpp"
 #include "BermudanSwaptionPricer.hpp"
+#include "PortfolioStream.hpp"
+#include "PricingService.hpp"
+#include "ShardedPricing.hpp"
 
 #include <ql/settings.hpp>
+#include <ql/utilities/dataparsers.hpp>
 #include <ql/time/calendars/target.hpp>
 #include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 using namespace QuantLib;
 
-int main() {
-    try {
+namespace {
+
+    const char* const kUsage =
+        "usage: bermudan_main                      ATM/OTM/ITM demo ladder\n"
+        "       bermudan_main PORTFOLIO [--out FILE] [--window N]\n"
+        "                     [--build-threads N] [--price-threads N]\n"
+        "       bermudan_main PORTFOLIO --workers N [--threads-per-worker N]\n"
+        "                     [--params MODEL=P1,P2,...]... [--out FILE]\n"
+        "       bermudan_main --quote YYYY-MM-DD RATE MODEL ENGINE MULT [--deadline-ms N]\n"
+        "       bermudan_main --convert CSV BINARY\n";
+
+    int demo() {
         Date today(15, July, 2025);
         Settings::instance().evaluationDate() = today;
 
@@ -24,22 +43,145 @@ int main() {
         Rate atm = sb.fairRate();
 
         auto atmSwap = sb.buildSwap(atm);
-        auto otmSwap = sb.buildSwap(atm * 1.2);
-        auto itmSwap = sb.buildSwap(atm * 0.8);
-
         auto hw = ext::make_shared<HullWhite>(ts);
 
-        BermudanSwaptionPricer pATM(atmSwap, hw, "tree");
-        BermudanSwaptionPricer pOTM(otmSwap, hw, "tree");
-        BermudanSwaptionPricer pITM(itmSwap, hw, "tree");
+        // One lattice for the whole ladder
+        BermudanSwaptionPricer pricer(atmSwap, hw, "tree");
+        std::vector<double> npvs = pricer.priceStrikes({atm, atm * 1.2, atm * 0.8});
+
+        std::cout << "ATM: " << npvs[0] << "\n";
+        std::cout << "OTM: " << npvs[1] << "\n";
+        std::cout << "ITM: " << npvs[2] << "\n";
+        return 0;
+    }
 
-        std::cout << "ATM: " << pATM.price() << "\n";
-        std::cout << "OTM: " << pOTM.price() << "\n";
-        std::cout << "ITM: " << pITM.price() << "\n";
+    int convert(const std::string& from, const std::string& to) {
+        auto reader = PortfolioReader::open(from);
+        BinaryPortfolioWriter writer(to);
+        PortfolioRow row;
+        std::size_t rows = 0;
+        for (; reader->next(row); ++rows)
+            writer.write(row);
+        writer.close();
+        std::cerr << "Wrote " << rows << " trades to " << to << "\n";
         return 0;
+    }
+
+    // One interactive job on the shared PricingService
+    int quote(const std::vector<std::string>& args) {
+        QL_REQUIRE(args.size() == 6 || (args.size() == 8 && args[6] == "--deadline-ms"), kUsage);
+        BermudanTrade trade;
+        trade.evaluationDate = DateParser::parseISO(args[1]);
+        trade.flatRate = std::stod(args[2]);
+        trade.model = args[3];
+        trade.engine = args[4];
+        trade.strikeMultiplier = std::stod(args[5]);
+
+        JobOptions options;
+        options.priority = JobPriority::Interactive;
+        if (args.size() == 8)
+            options.deadline = CancellationToken::Clock::now() +
+                               std::chrono::milliseconds(std::stol(args[7]));
+        std::cout << PricingService::shared().submit(trade, options).result.get() << "\n";
+        return 0;
+    }
+
+    // "MODEL=P1,P2,..."
+    void parseParams(const std::string& value, MarketSnapshot& market) {
+        const auto eq = value.find('=');
+        QL_REQUIRE(eq != std::string::npos && eq > 0, "Expected MODEL=P1,P2,... in " << value);
+        std::vector<double>& params = market.modelParams[value.substr(0, eq)];
+        params.clear();
+        std::size_t pos = eq + 1;
+        while (pos <= value.size()) {
+            std::size_t comma = value.find(',', pos);
+            if (comma == std::string::npos)
+                comma = value.size();
+            params.push_back(std::stod(value.substr(pos, comma - pos)));
+            pos = comma + 1;
+        }
+    }
+
+    int report(const StreamStats& stats) {
+        std::cerr << "Priced " << stats.trades << " trades (" << stats.failed << " failed) in "
+                  << stats.seconds << " s: " << stats.tradesPerSecond() << " trades/sec\n";
+        return stats.failed == 0 ? 0 : 2;
+    }
+
+    int stream(const std::string& path, const std::string& outPath,
+               const StreamSettings& settings, const MarketSnapshot& market,
+               const ShardSettings* shards) {
+        std::ofstream file;
+        if (!outPath.empty()) {
+            file.open(outPath);
+            QL_REQUIRE(file, "Cannot create " << outPath);
+        }
+        std::ostream& out = outPath.empty() ? std::cout : file;
+
+        if (shards)
+            return report(priceSharded(path, out, market, *shards));
+        QL_REQUIRE(market.modelParams.empty(), "--params needs --workers");
+        auto reader = PortfolioReader::open(path);
+        return report(streamPortfolio(*reader, out, settings));
+    }
+
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::vector<std::string> args(argv + 1, argv + argc);
+        if (args.empty())
+            return demo();
+        if (args[0] == "--convert") {
+            QL_REQUIRE(args.size() == 3, kUsage);
+            return convert(args[1], args[2]);
+        }
+        if (args[0] == "--quote")
+            return quote(args);
+        if (args[0] == "--worker") {
+            // Started by priceSharded(): SEGMENT INDEX COUNT THREADS
+            QL_REQUIRE(args.size() == 5, kUsage);
+            runShardWorker(args[1], std::stoul(args[2]), std::stoul(args[3]),
+                           std::stoul(args[4]));
+            return 0;
+        }
+        if (args[0] == "-h" || args[0] == "--help") {
+            std::cout << kUsage;
+            return 0;
+        }
+
+        StreamSettings settings;
+        MarketSnapshot market;
+        ShardSettings shards;
+        shards.workerExecutable = argv[0];
+        bool sharded = false;
+        std::string outPath;
+        for (std::size_t i = 1; i < args.size(); i += 2) {
+            QL_REQUIRE(i + 1 < args.size(), kUsage);
+            const std::string& flag = args[i];
+            const std::string& value = args[i + 1];
+            if (flag == "--out")
+                outPath = value;
+            else if (flag == "--window")
+                settings.window = std::stoul(value);
+            else if (flag == "--build-threads")
+                settings.buildThreads = std::stoul(value);
+            else if (flag == "--price-threads")
+                settings.priceThreads = std::stoul(value);
+            else if (flag == "--workers") {
+                shards.workers = std::stoul(value);
+                sharded = true;
+            }
+            else if (flag == "--threads-per-worker")
+                shards.threadsPerWorker = std::stoul(value);
+            else if (flag == "--params")
+                parseParams(value, market);
+            else
+                QL_FAIL(kUsage);
+        }
+        return stream(args[0], outPath, settings, market, sharded ? &shards : nullptr);
     } catch (std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
         return 1;
     }
 }
-
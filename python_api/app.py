@@ -1,32 +1,231 @@
-from fastapi import FastAPI, Query
+import asyncio
+import os
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import asynccontextmanager
+
+import numpy as np
+from fastapi import FastAPI, HTTPException, Query
 from pydantic import BaseModel, Field
 import bermudan_native  # built by CMake; ensure PYTHONPATH includes build dir
 
-app = FastAPI(title="Bermudan Swaption Pricer API", version="1.0.0")
+# Micro-batching: concurrent /price requests arriving within the window are
+# priced by one native batch call, off the event loop.
+BATCH_WINDOW_MS = float(os.environ.get("BERMUDAN_BATCH_WINDOW_MS", "2"))
+BATCH_MAX = int(os.environ.get("BERMUDAN_BATCH_MAX", "256"))
+BATCH_WORKERS = int(os.environ.get("BERMUDAN_BATCH_WORKERS", "2"))
+# Native PricingService deadline for /price batches (0 = none); an expired
+# quote answers 504 instead of holding a worker
+QUOTE_TIMEOUT_MS = float(os.environ.get("BERMUDAN_QUOTE_TIMEOUT_MS", "0"))
 
 class PriceRequest(BaseModel):
     date: str = Field(..., description="YYYY-MM-DD, e.g. 2025-07-15")
     flat_rate: float = Field(..., ge=0, le=1, description="Flat curve rate, e.g. 0.035")
     model: str = Field(..., pattern="^(g2|hw|bk)$")
-    engine: str = Field(..., pattern="^(tree|fdm)$")
+    engine: str = Field(..., pattern="^(tree|fdm|fdm-adi|hw-simd|lsmc)$")
     strike_multiplier: float = Field(..., gt=0, description="1.0=ATM, 1.2=OTM, 0.8=ITM")
+    mc_paths: int = Field(0, ge=0, description="lsmc: pricing path cap (0 = engine default)")
+    mc_tolerance: float = Field(0.0, ge=0, description="lsmc: stop once the standard error is below this")
+    grid_tolerance: float = Field(0.0, ge=0, description="tree/fdm: pick the grid for this NPV error (0 = fixed grid)")
+    surrogate: bool = Field(False, description="answer from a built surrogate when one covers the inputs")
 
-def parse_date(s: str):
-    y, m, d = map(int, s.split("-"))
-    return y, m, d
+class SurrogateRequest(BaseModel):
+    date: str = Field(..., description="YYYY-MM-DD, e.g. 2025-07-15")
+    model: str = Field(..., pattern="^(g2|hw|bk)$")
+    engine: str = Field(..., pattern="^(tree|fdm|fdm-adi|hw-simd|lsmc)$")
+    min_rate: float = Field(0.005, ge=0, le=1)
+    max_rate: float = Field(0.08, ge=0, le=1)
+    min_multiplier: float = Field(0.5, gt=0)
+    max_multiplier: float = Field(1.5, gt=0)
+    rate_nodes: int = Field(12, ge=2, le=64)
+    multiplier_nodes: int = Field(12, ge=2, le=64)
+    check_nodes: int = Field(7, ge=2, le=64)
+    tolerance: float = Field(0.0, ge=0, description="fail the build if the error estimate exceeds this (0 = off)")
+    mc_paths: int = Field(0, ge=0)
+    mc_tolerance: float = Field(0.0, ge=0)
+    grid_tolerance: float = Field(0.0, ge=0)
+
+class BatchRequest(BaseModel):
+    trades: list[PriceRequest] = Field(..., min_length=1)
+
+def price_rows(rows: list[PriceRequest], priority: str = "interactive") -> list[float]:
+    """One native batch call per distinct (mc_paths, mc_tolerance,
+    grid_tolerance), queued on the native PricingService at the given
+    priority. Market graphs stay cached in the native module between calls."""
+    timeout_ms = QUOTE_TIMEOUT_MS if priority == "interactive" else 0.0
+    npvs = [0.0] * len(rows)
+    groups: dict[tuple[int, float, float], list[int]] = {}
+    for i, r in enumerate(rows):
+        groups.setdefault((r.mc_paths, r.mc_tolerance, r.grid_tolerance), []).append(i)
+    for (paths, tolerance, grid_tolerance), idx in groups.items():
+        sel = [rows[i] for i in idx]
+        n = len(sel)
+        out = bermudan_native.price_bermudan_batch(
+            np.array([r.date for r in sel], dtype="datetime64[D]"),
+            np.fromiter((r.flat_rate for r in sel), dtype=np.float64, count=n),
+            np.fromiter((bermudan_native.MODEL_CODES[r.model] for r in sel), dtype=np.int64, count=n),
+            np.fromiter((bermudan_native.ENGINE_CODES[r.engine] for r in sel), dtype=np.int64, count=n),
+            np.fromiter((r.strike_multiplier for r in sel), dtype=np.float64, count=n),
+            mc_paths=paths, mc_tolerance=tolerance, grid_tolerance=grid_tolerance,
+            keep_markets=True, priority=priority, timeout_ms=timeout_ms,
+        )
+        for i, npv in zip(idx, out.tolist()):
+            npvs[i] = npv
+    return npvs
+
+class MicroBatcher:
+    def __init__(self, window_ms: float, max_batch: int, workers: int):
+        self.window = window_ms / 1000.0
+        self.max_batch = max_batch
+        self.executor = ThreadPoolExecutor(max_workers=workers, thread_name_prefix="bermudan-batch")
+        self.queue: asyncio.Queue | None = None
+        self.task: asyncio.Task | None = None
+        self.pending: set[asyncio.Task] = set()
+        self.stats = {"requests": 0, "batches": 0, "max_batch": 0}
+
+    def start(self):
+        self.queue = asyncio.Queue()
+        self.task = asyncio.create_task(self._collect())
+
+    async def stop(self):
+        if self.task:
+            self.task.cancel()
+            try:
+                await self.task
+            except asyncio.CancelledError:
+                pass
+        if self.pending:
+            await asyncio.gather(*self.pending, return_exceptions=True)
+        self.executor.shutdown(wait=True)
+
+    async def submit(self, req: PriceRequest) -> float:
+        fut = asyncio.get_running_loop().create_future()
+        await self.queue.put((req, fut))
+        return await fut
+
+    async def run(self, rows: list[PriceRequest], priority: str = "interactive") -> list[float]:
+        return await asyncio.get_running_loop().run_in_executor(
+            self.executor, price_rows, rows, priority)
+
+    async def _collect(self):
+        loop = asyncio.get_running_loop()
+        while True:
+            batch = [await self.queue.get()]
+            deadline = loop.time() + self.window
+            while len(batch) < self.max_batch:
+                timeout = deadline - loop.time()
+                if timeout <= 0:
+                    break
+                try:
+                    batch.append(await asyncio.wait_for(self.queue.get(), timeout))
+                except asyncio.TimeoutError:
+                    break
+            self.stats["requests"] += len(batch)
+            self.stats["batches"] += 1
+            self.stats["max_batch"] = max(self.stats["max_batch"], len(batch))
+            # Collect the next batch while this one prices
+            task = asyncio.create_task(self._price(batch))
+            self.pending.add(task)
+            task.add_done_callback(self.pending.discard)
+
+    async def _price(self, batch):
+        try:
+            npvs = await self.run([req for req, _ in batch])
+        except bermudan_native.PricingCancelled as e:
+            # Past the deadline: repricing row by row would only be later
+            for _, fut in batch:
+                if not fut.done():
+                    fut.set_exception(e)
+            return
+        except Exception:
+            # Reprice one by one so a bad row fails only its own request
+            for req, fut in batch:
+                try:
+                    npv = (await self.run([req]))[0]
+                    if not fut.done():
+                        fut.set_result(npv)
+                except Exception as e:
+                    if not fut.done():
+                        fut.set_exception(e)
+            return
+        for (_, fut), npv in zip(batch, npvs):
+            if not fut.done():
+                fut.set_result(npv)
+
+batcher = MicroBatcher(BATCH_WINDOW_MS, BATCH_MAX, BATCH_WORKERS)
+
+@asynccontextmanager
+async def lifespan(_: FastAPI):
+    batcher.start()
+    yield
+    await batcher.stop()
+
+app = FastAPI(title="Bermudan Swaption Pricer API", version="1.0.0", lifespan=lifespan)
 
 @app.get("/healthz")
 def health():
     return {"status": "ok"}
 
+@app.get("/metrics")
+def metrics(reset: bool = Query(False, description="zero the counters after reading")):
+    snapshot = bermudan_native.metrics()
+    snapshot["market_cache"] = bermudan_native.market_cache_info()
+    snapshot["surrogates"] = bermudan_native.surrogate_info()
+    snapshot["service"] = bermudan_native.service_info()
+    snapshot["batcher"] = dict(batcher.stats, window_ms=BATCH_WINDOW_MS, max_size=BATCH_MAX)
+    if reset:
+        bermudan_native.reset_metrics()
+    return snapshot
+
+def ymd(date: str) -> tuple[int, int, int]:
+    y, m, d = (int(p) for p in date.split("-"))
+    return y, m, d
+
 @app.post("/price")
-def price(req: PriceRequest):
-    y, m, d = parse_date(req.date)
-    npv = bermudan_native.price_bermudan(
-        y, m, d, req.flat_rate, req.model, req.engine, req.strike_multiplier
-    )
+async def price(req: PriceRequest):
+    if req.surrogate:
+        # Microseconds when a surrogate covers the inputs; otherwise the
+        # request joins the batcher like any other
+        quoted = bermudan_native.quote_bermudan(
+            *ymd(req.date), req.flat_rate, req.model, req.engine, req.strike_multiplier,
+            mc_paths=req.mc_paths, mc_tolerance=req.mc_tolerance,
+            grid_tolerance=req.grid_tolerance, fallback=False,
+        )
+        if quoted is not None:
+            return {"npv": quoted[0], "surrogate": True, "inputs": req.model_dump()}
+    try:
+        npv = await batcher.submit(req)
+    except bermudan_native.PricingCancelled as e:
+        raise HTTPException(status_code=504, detail=str(e))
     return {
         "npv": npv,
+        "surrogate": False,
         "inputs": req.model_dump()
     }
 
+@app.post("/surrogate")
+async def build_surrogate(req: SurrogateRequest):
+    """Prices the Chebyshev node and check grids for the shape (a batch job
+    on the native PricingService) and registers the surrogate for /price.
+    Waits on its own thread, not one of the micro-batcher's. The answer's
+    checked_error (largest deviation on the check grid) plus tail_estimate
+    (size of the last Chebyshev coefficients) is error_estimate: an
+    estimate of the surrogate's error, not a bound."""
+    info = await asyncio.to_thread(
+        lambda: bermudan_native.build_surrogate(
+            *ymd(req.date), req.model, req.engine,
+            req.min_rate, req.max_rate, req.min_multiplier, req.max_multiplier,
+            rate_nodes=req.rate_nodes, multiplier_nodes=req.multiplier_nodes,
+            check_nodes=req.check_nodes, tolerance=req.tolerance,
+            mc_paths=req.mc_paths, mc_tolerance=req.mc_tolerance,
+            grid_tolerance=req.grid_tolerance,
+        ),
+    )
+    return dict(info, inputs=req.model_dump())
+
+@app.post("/price/batch")
+async def price_batch(req: BatchRequest):
+    # Batch priority: queued /price quotes go first, and at most one chunk of
+    # this book runs ahead of them. Waits on its own thread, so books never
+    # hold the micro-batcher's workers.
+    npvs = await asyncio.to_thread(price_rows, req.trades, "batch")
+    return {"npvs": npvs}
@@ -0,0 +1,508 @@
+#include "BasicBermudanSwaptionPricer.hpp"
+#include "CachedTreeSwaptionEngine.hpp"
+#include "FittedLatticeCache.hpp"
+#include "G2AdiSwaptionEngine.hpp"
+#include "GridDiscountCurve.hpp"
+#include "HullWhiteSimdSwaptionEngine.hpp"
+#include "HullWhiteSoaLattice.hpp"
+#include "LsmcSwaptionEngine.hpp"
+#include "PricingCancellation.hpp"
+#include "QuantLibSession.hpp"
+#include "SwaptionCashflows.hpp"
+
+#include <ql/cashflows/coupon.hpp>
+#include <ql/settings.hpp>
+#include <ql/pricingengines/swaption/discretizedswaption.hpp>
+#include <ql/pricingengines/swaption/treeswaptionengine.hpp>
+#include <ql/pricingengines/swaption/fdhullwhiteswaptionengine.hpp>
+#include <ql/pricingengines/swaption/fdg2swaptionengine.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/models/shortrate/twofactormodels/g2.hpp>
+#include <ql/models/shortrate/onefactormodels/blackkarasinski.hpp>
+#include <ql/models/shortrate/twofactormodel.hpp>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <typeinfo>
+#include <vector>
+
+using namespace QuantLib;
+
+namespace {
+
+    // Strike swaps and swaptions built for a ladder. Their coupons register
+    // with the global evaluation date, so on stock builds the caller creates
+    // them under QuantLibSession::Guard and they are dropped under it here,
+    // also when pricing throws.
+    class LadderObjects {
+    public:
+        LadderObjects() = default;
+        LadderObjects(const LadderObjects&) = delete;
+        LadderObjects& operator=(const LadderObjects&) = delete;
+        ~LadderObjects() {
+            QuantLibSession::Guard guard;
+            objects_.clear();
+        }
+
+        template <class T>
+        ext::shared_ptr<T> keep(const ext::shared_ptr<T>& object) {
+            objects_.push_back(object);
+            return object;
+        }
+
+    private:
+        std::vector<ext::shared_ptr<void>> objects_;
+    };
+
+    // The fallback ShortRateModel may not be fitted to a curve
+    template <class Model>
+    const Handle<YieldTermStructure>& termStructureOf(const Model& model) {
+        if constexpr (std::is_base_of_v<TermStructureConsistentModel, Model>) {
+            return model.termStructure();
+        } else {
+            auto tsModel = dynamic_cast<const TermStructureConsistentModel*>(&model);
+            QL_REQUIRE(tsModel, "Tree pricing requires a term-structure consistent model");
+            return tsModel->termStructure();
+        }
+    }
+
+    template <class Model>
+    void recordLattice(const ext::shared_ptr<Lattice>& lattice, const TimeGrid& grid) {
+#ifdef BERMUDAN_METRICS
+        using Tree = std::conditional_t<std::is_base_of_v<OneFactorModel, Model>,
+                                        OneFactorModel::ShortRateTree,
+                                        TwoFactorModel::ShortRateTree>;
+        BERMUDAN_COUNT(Counter::LatticeSteps, grid.size() - 1);
+        if (auto tree = ext::dynamic_pointer_cast<Tree>(lattice)) {
+            Size nodes = 0;
+            for (Size i = 0; i < grid.size(); ++i)
+                nodes += tree->size(i);
+            BERMUDAN_COUNT(Counter::LatticeNodes, nodes);
+        }
+#else
+        static_cast<void>(lattice);
+        static_cast<void>(grid);
+#endif
+    }
+
+}
+
+template <class Model>
+ext::shared_ptr<PricingEngine> TreeEngine::engine(const ext::shared_ptr<Model>& model,
+                                                  std::size_t steps, const TimeGrid* grid,
+                                                  const LsmcSettings&) {
+    // Black-Karasinski fits its drift numerically: share fitted trees
+    using Engine = std::conditional_t<std::is_same_v<Model, BlackKarasinski>,
+                                      CachedTreeSwaptionEngine, TreeSwaptionEngine>;
+    if (steps)
+        return ext::make_shared<Engine>(model, steps);
+    if (grid)
+        return ext::make_shared<Engine>(model, *grid);
+    return ext::make_shared<Engine>(model, 50);
+}
+
+template <class Model>
+ext::shared_ptr<Lattice> TreeEngine::lattice(const Model& model, const TimeGrid& grid) {
+    if constexpr (std::is_same_v<Model, BlackKarasinski>) {
+        return FittedLatticeCache::shared().tree(model, grid);
+    } else {
+        BERMUDAN_TIME_STAGE(Stage::LatticeBuild);
+        ext::shared_ptr<Lattice> lattice = model.tree(grid);
+        recordLattice<Model>(lattice, grid);
+        return lattice;
+    }
+}
+
+template <class Model>
+ext::shared_ptr<PricingEngine> FdEngine::engine(const ext::shared_ptr<Model>& model,
+                                                std::size_t steps, const TimeGrid*,
+                                                const LsmcSettings&) {
+    if constexpr (std::is_same_v<Model, G2>) {
+        if (steps)
+            return ext::make_shared<FdG2SwaptionEngine>(model, steps, steps / 2, steps / 2);
+        return ext::make_shared<FdG2SwaptionEngine>(model);
+    } else {
+        if (steps)
+            return ext::make_shared<FdHullWhiteSwaptionEngine>(model, steps, steps);
+        return ext::make_shared<FdHullWhiteSwaptionEngine>(model);
+    }
+}
+
+template <class Model>
+ext::shared_ptr<PricingEngine> G2AdiEngine::engine(const ext::shared_ptr<Model>& model,
+                                                   std::size_t steps, const TimeGrid*,
+                                                   const LsmcSettings&) {
+    if (steps)
+        return ext::make_shared<G2AdiSwaptionEngine>(model, steps, steps / 2, steps / 2);
+    return ext::make_shared<G2AdiSwaptionEngine>(model);
+}
+
+template <class Model>
+ext::shared_ptr<PricingEngine> HwSimdEngine::engine(const ext::shared_ptr<Model>& model,
+                                                    std::size_t steps, const TimeGrid* grid,
+                                                    const LsmcSettings&) {
+    if (steps)
+        return ext::make_shared<HullWhiteSimdSwaptionEngine>(model, steps);
+    if (grid)
+        return ext::make_shared<HullWhiteSimdSwaptionEngine>(model, *grid);
+    return ext::make_shared<HullWhiteSimdSwaptionEngine>(model, 50);
+}
+
+template <class Model>
+ext::shared_ptr<Lattice> HwSimdEngine::lattice(const Model& model, const TimeGrid& grid) {
+    return HullWhiteSoaLattice::build(model, grid);
+}
+
+template <class Model>
+ext::shared_ptr<PricingEngine> LsmcEngine::engine(const ext::shared_ptr<Model>& model,
+                                                  std::size_t, const TimeGrid*,
+                                                  const LsmcSettings& lsmc) {
+    return ext::make_shared<LsmcSwaptionEngine>(model, lsmc);
+}
+
+// Strike-ladder lattice, dropped when the model (or the curve it observes) changes
+template <class Model, class Engine>
+struct BasicBermudanSwaptionPricer<Model, Engine>::LatticeCache : public Observer {
+    ext::shared_ptr<Lattice> lattice;
+    ext::shared_ptr<Lattice> coarse;    // half resolution, auto grid only
+    void update() override {
+        lattice.reset();
+        coarse.reset();
+    }
+};
+
+// Resolution picked for the grid tolerance, with engines and swaptions at
+// it and at half of it (priced lazily, like swaption_)
+template <class Model, class Engine>
+struct BasicBermudanSwaptionPricer<Model, Engine>::AutoGrid {
+    std::size_t steps = 0;
+    double error = 0.0;
+    ext::shared_ptr<PricingEngine> fineEngine, coarseEngine;
+    ext::shared_ptr<Swaption> fine, coarse;
+};
+
+template <class Model, class Engine>
+BasicBermudanSwaptionPricer<Model, Engine>::BasicBermudanSwaptionPricer(
+    const ext::shared_ptr<VanillaSwap>& swap,
+    const ext::shared_ptr<Model>& model,
+    const TimeGrid* grid,
+    const LsmcSettings& lsmc,
+    const GridSettings& gridSettings)
+    : swap_(swap),
+      model_(model),
+      grid_(grid),
+      lsmc_(lsmc),
+      gridSettings_(gridSettings) {
+    QL_REQUIRE(swap_, "Null swap");
+    QL_REQUIRE(model_, "Null model");
+    if (gridSettings_.tolerance > 0.0) {
+        QL_REQUIRE(Engine::convergenceOrder > 0,
+                   "grid tolerance applies to tree and FD engines (lsmc: LsmcSettings::tolerance)");
+        QL_REQUIRE(!grid_, "a fixed TimeGrid and a grid tolerance are mutually exclusive");
+        QL_REQUIRE(gridSettings_.minSteps >= 2 && gridSettings_.maxSteps >= 2 * gridSettings_.minSteps,
+                   "grid search needs minSteps >= 2 and maxSteps >= 2 * minSteps");
+        autoGrid_ = ext::make_shared<AutoGrid>();
+    }
+
+    {
+        BERMUDAN_TIME_STAGE(Stage::ScheduleWalk);
+        const auto& leg = swap_->fixedLeg();
+        exerciseDates_.reserve(leg.size());
+        for (const auto& cf : leg) {
+            auto cpn = ext::dynamic_pointer_cast<Coupon>(cf);
+            if (cpn)
+                exerciseDates_.push_back(cpn->accrualStartDate());
+        }
+    }
+
+    BERMUDAN_TIME_STAGE(Stage::EngineSetup);
+    swaption_ = ext::make_shared<Swaption>(
+        swap_, ext::make_shared<BermudanExercise>(exerciseDates_));
+    cacheDiscountTimes();
+    engine_ = makeEngine();
+    swaption_->setPricingEngine(engine_);
+
+    ladderLattice_ = ext::make_shared<LatticeCache>();
+    ladderLattice_->registerWith(model_);
+}
+
+template <class Model, class Engine>
+ext::shared_ptr<PricingEngine>
+BasicBermudanSwaptionPricer<Model, Engine>::makeEngine(std::size_t steps) const {
+    return Engine::engine(model_, steps, grid_, lsmc_);
+}
+
+// The grid TreeSwaptionEngine rolls back on (and priceStrikes() fits once)
+template <class Model, class Engine>
+TimeGrid BasicBermudanSwaptionPricer<Model, Engine>::latticeGrid(std::size_t steps) const {
+    if (steps == 0) {
+        if (grid_)
+            return *grid_;
+        steps = 50;
+    }
+    Swaption::arguments args;
+    swaption_->setupArguments(&args);
+    args.validate();
+    const Handle<YieldTermStructure>& ts = termStructureOf(*model_);
+    DiscretizedSwaption asset(args, ts->referenceDate(), ts->dayCounter());
+    std::vector<Time> times = asset.mandatoryTimes();
+    return TimeGrid(times.begin(), times.end(), steps);
+}
+
+// Fills the model's GridDiscountCurve, if it has one, with every time the
+// engine reads off the curve: lattice grid (tree fitting), exercise, reset
+// and payment times (LSMC). Other engines just miss the cache.
+template <class Model, class Engine>
+void BasicBermudanSwaptionPricer<Model, Engine>::cacheDiscountTimes(std::size_t steps) const {
+    auto tsModel = dynamic_cast<const TermStructureConsistentModel*>(model_.get());
+    if (!tsModel)
+        return;
+    auto cache = ext::dynamic_pointer_cast<GridDiscountCurve>(tsModel->termStructure().currentLink());
+    if (!cache)
+        return;
+
+    const Date referenceDate = cache->referenceDate();
+    Swaption::arguments args;
+    swaption_->setupArguments(&args);
+    args.validate();
+
+    std::vector<Time> times;
+    for (const Date& d : exerciseDates_)
+        if (d >= referenceDate)
+            times.push_back(cache->timeFromReference(d));
+    for (const SwaptionCashflow& cf : swaptionCashflows(args, referenceDate)) {
+        times.push_back(cache->timeFromReference(cf.resetDate));
+        times.push_back(cache->timeFromReference(cf.payDate));
+    }
+    if constexpr (Engine::usesLattice) {
+        const TimeGrid grid = latticeGrid(steps);
+        times.insert(times.end(), grid.begin(), grid.end());
+    }
+    cache->cacheTimes(times);
+}
+
+template <class Model, class Engine>
+double BasicBermudanSwaptionPricer<Model, Engine>::priceOnAutoGrid() const {
+    const AutoGrid& grid = autoGrid();
+    return extrapolate(grid.coarse->NPV(), grid.fine->NPV());
+}
+
+template <class Model, class Engine>
+std::size_t BasicBermudanSwaptionPricer<Model, Engine>::gridSteps() const {
+    return autoGrid_ ? autoGrid_->steps : 0;
+}
+
+template <class Model, class Engine>
+double BasicBermudanSwaptionPricer<Model, Engine>::gridError() const {
+    return autoGrid_ ? autoGrid_->error : 0.0;
+}
+
+// Trees converge roughly as 1/N, the FD schemes as 1/N^2; Richardson on a
+// doubling removes that leading term.
+template <class Model, class Engine>
+double BasicBermudanSwaptionPricer<Model, Engine>::extrapolate(double coarse, double fine) const {
+    if constexpr (Engine::convergenceOrder == 0) {
+        static_cast<void>(coarse);
+        return fine;
+    } else {
+        if (!gridSettings_.richardson)
+            return fine;
+        constexpr double scale = (1 << Engine::convergenceOrder) - 1;
+        return fine + (fine - coarse) / scale;
+    }
+}
+
+template <class Model, class Engine>
+GridCache::Shape BasicBermudanSwaptionPricer<Model, Engine>::gridShape() const {
+    const Date today = Settings::instance().evaluationDate();
+    GridCache::Shape shape;
+    shape.engine = Engine::name;
+    shape.model = typeid(*model_).name();
+    for (Real p : model_->params())
+        shape.params.push_back(std::lround(p * 1e4));
+    shape.exercises = static_cast<std::size_t>(
+        std::count_if(exerciseDates_.begin(), exerciseDates_.end(),
+                      [&](const Date& d) { return d >= today; }));
+    shape.maturityDays = swap_->maturityDate() - today;
+    shape.strikeBp = std::lround(swap_->fixedRate() * 1e4);
+    shape.tolerance = gridSettings_.tolerance;
+    shape.minSteps = gridSettings_.minSteps;
+    shape.maxSteps = gridSettings_.maxSteps;
+    shape.richardson = gridSettings_.richardson;
+    return shape;
+}
+
+// Doubles the resolution until the estimate settles: with Richardson the
+// extrapolated prices of consecutive doublings (three grids at least),
+// otherwise the fine price's own error (fine - coarse) / (2^order - 1).
+// The finest resolution priced becomes the grid; maxSteps caps the search
+// and gridError() then reports what was reached (the fine price's error
+// when maxSteps allowed a single doubling).
+template <class Model, class Engine>
+const typename BasicBermudanSwaptionPricer<Model, Engine>::AutoGrid&
+BasicBermudanSwaptionPricer<Model, Engine>::autoGrid() const {
+    AutoGrid& grid = *autoGrid_;
+    if (grid.steps != 0)
+        return grid;
+
+    const GridSettings& settings = gridSettings_;
+    auto level = [&](std::size_t steps, ext::shared_ptr<PricingEngine>& engine,
+                     ext::shared_ptr<Swaption>& swaption) {
+        engine = makeEngine(steps);
+        swaption = ext::make_shared<Swaption>(swap_, swaption_->exercise());
+        swaption->setPricingEngine(engine);
+    };
+
+    const GridCache::Shape shape = gridShape();
+    std::optional<GridCache::Choice> cached;
+    if (settings.cache)
+        cached = GridCache::shared().find(shape);
+
+    if (cached) {
+        grid.steps = cached->steps;
+        grid.error = cached->error;
+        level(grid.steps, grid.fineEngine, grid.fine);
+        level(grid.steps / 2, grid.coarseEngine, grid.coarse);
+    } else {
+        std::size_t steps = settings.minSteps;
+        level(steps, grid.fineEngine, grid.fine);
+        double error = QL_MAX_REAL;
+        std::optional<double> previous;
+        while (2 * steps <= settings.maxSteps) {
+            grid.coarseEngine = grid.fineEngine;
+            grid.coarse = grid.fine;
+            steps *= 2;
+            level(steps, grid.fineEngine, grid.fine);
+
+            const double coarse = grid.coarse->NPV();
+            const double fine = grid.fine->NPV();
+            const double estimate = extrapolate(coarse, fine);
+            // Richardson's first level has no earlier estimate to compare:
+            // it records the fine price's own error, but never stops there
+            const bool first = settings.richardson && !previous;
+            if (settings.richardson && previous)
+                error = std::fabs(estimate - *previous);
+            else
+                error = std::fabs(fine - coarse) / ((1 << Engine::convergenceOrder) - 1);
+            previous = estimate;
+            if (!first && error <= settings.tolerance)
+                break;
+        }
+        grid.steps = steps;
+        grid.error = error;
+        if (settings.cache)
+            GridCache::shared().insert(shape, {grid.steps, grid.error});
+    }
+
+    cacheDiscountTimes(grid.steps);
+    cacheDiscountTimes(grid.steps / 2);
+    return grid;
+}
+
+template <class Model, class Engine>
+ext::shared_ptr<VanillaSwap>
+BasicBermudanSwaptionPricer<Model, Engine>::swapWithStrike(Rate strike) const {
+    return ext::make_shared<VanillaSwap>(
+        swap_->type(), swap_->nominal(),
+        swap_->fixedSchedule(), strike, swap_->fixedDayCount(),
+        swap_->floatingSchedule(), swap_->iborIndex(), swap_->spread(),
+        swap_->floatingDayCount(), swap_->paymentConvention());
+}
+
+template <class Model, class Engine>
+std::vector<double>
+BasicBermudanSwaptionPricer<Model, Engine>::priceStrikes(const std::vector<Rate>& strikes) const {
+    std::vector<double> npvs;
+    npvs.reserve(strikes.size());
+    if (strikes.empty())
+        return npvs;
+
+    auto exercise = swaption_->exercise();
+
+    if constexpr (!Engine::usesLattice) {
+        for (Rate k : strikes) {
+            LadderObjects held;
+            ext::shared_ptr<Swaption> s, coarse;
+            {
+                QuantLibSession::Guard guard;
+                const ext::shared_ptr<VanillaSwap> swap = held.keep(swapWithStrike(k));
+                s = held.keep(ext::make_shared<Swaption>(swap, exercise));
+                if (autoGrid_)
+                    coarse = held.keep(ext::make_shared<Swaption>(swap, exercise));
+            }
+            if (!autoGrid_) {
+                s->setPricingEngine(engine_);
+                npvs.push_back(s->NPV());
+                continue;
+            }
+            const AutoGrid& grid = autoGrid();
+            s->setPricingEngine(grid.fineEngine);
+            coarse->setPricingEngine(grid.coarseEngine);
+            npvs.push_back(extrapolate(coarse->NPV(), s->NPV()));
+        }
+        return npvs;
+    } else {
+        const Handle<YieldTermStructure>& ts = termStructureOf(*model_);
+        const Date referenceDate = ts->referenceDate();
+        const DayCounter dayCounter = ts->dayCounter();
+
+        // Same stopping times as TreeSwaptionEngine::calculate()
+        std::vector<Time> stoppingTimes(exercise->dates().size());
+        for (Size i = 0; i < stoppingTimes.size(); ++i)
+            stoppingTimes[i] = dayCounter.yearFraction(referenceDate, exercise->date(i));
+        const auto next = std::find_if(stoppingTimes.begin(), stoppingTimes.end(),
+                                       [](Time t) { return t >= 0.0; });
+        QL_REQUIRE(next != stoppingTimes.end(), "no exercise date left");
+        const Time nextExercise = *next;
+
+        // Declared first, so the ladder (whose arguments point at the swaps)
+        // goes before the swaps are dropped
+        LadderObjects held;
+        std::vector<ext::shared_ptr<DiscretizedSwaption>> ladder;
+        ladder.reserve(strikes.size());
+        {
+            QuantLibSession::Guard guard;
+            for (Rate k : strikes) {
+                Swaption s(held.keep(swapWithStrike(k)), exercise);
+                Swaption::arguments args;
+                s.setupArguments(&args);
+                args.validate();
+                ladder.push_back(
+                    ext::make_shared<DiscretizedSwaption>(args, referenceDate, dayCounter));
+            }
+        }
+
+        // Every strike shares the schedule, hence the mandatory times, hence the
+        // lattice: fit it once (state prices are cached inside) and reuse it.
+        const std::size_t steps = autoGrid_ ? autoGrid().steps : 0;
+        ext::shared_ptr<Lattice>& lattice = ladderLattice_->lattice;
+        ext::shared_ptr<Lattice>& coarse = ladderLattice_->coarse;
+        if (!lattice)
+            lattice = Engine::lattice(*model_, latticeGrid(steps));
+        if (autoGrid_ && !coarse)
+            coarse = Engine::lattice(*model_, latticeGrid(steps / 2));
+
+        BERMUDAN_TIME_STAGE(Stage::Rollback);
+        auto rollback = [&](DiscretizedSwaption& asset, const ext::shared_ptr<Lattice>& on) {
+            asset.initialize(on, stoppingTimes.back());
+            rollbackWithCheckpoints(asset, nextExercise);
+            return asset.presentValue();
+        };
+        for (auto& asset : ladder) {
+            const double fine = rollback(*asset, lattice);
+            npvs.push_back(autoGrid_ ? extrapolate(rollback(*asset, coarse), fine) : fine);
+        }
+        return npvs;
+    }
+}
+
+template class BasicBermudanSwaptionPricer<HullWhite, TreeEngine>;
+template class BasicBermudanSwaptionPricer<G2, TreeEngine>;
+template class BasicBermudanSwaptionPricer<BlackKarasinski, TreeEngine>;
+template class BasicBermudanSwaptionPricer<ShortRateModel, TreeEngine>;
+template class BasicBermudanSwaptionPricer<HullWhite, FdEngine>;
+template class BasicBermudanSwaptionPricer<G2, FdEngine>;
+template class BasicBermudanSwaptionPricer<G2, G2AdiEngine>;
+template class BasicBermudanSwaptionPricer<HullWhite, HwSimdEngine>;
+template class BasicBermudanSwaptionPricer<HullWhite, LsmcEngine>;
+template class BasicBermudanSwaptionPricer<G2, LsmcEngine>;
@@ -0,0 +1,115 @@
+#include "BermudanSwaptionPricer.hpp"
+#include "MarketGraph.hpp"
+#include "PricingService.hpp"
+#include "QuantLibSession.hpp"
+#include "ThreadPool.hpp"
+
+#include <ql/settings.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+
+using namespace QuantLib;
+
+namespace {
+
+    using Bump = MarketGraph::Bump;
+
+}
+
+BermudanGreeks BermudanSwaptionPricer::greeks(const BermudanTrade& trade,
+                                              const GreeksSettings& settings) {
+    QL_REQUIRE(!settings.buckets.empty(), "no curve buckets given");
+
+    if (!QuantLibSession::isolated() && !PricingService::inJob()) {
+        // Stock build: the evaluation date is global, so run as a service
+        // job, whose date gating keeps jobs on other dates off it
+        BermudanGreeks result;
+        PricingService::shared()
+            .submitTask(trade.evaluationDate, [&] { result = greeks(trade, settings); })
+            .result.get();
+        return result;
+    }
+    std::optional<SavedSettings> backup;
+    if (QuantLibSession::isolated()) {
+        backup.emplace();
+        Settings::instance().evaluationDate() = trade.evaluationDate;
+    } else {
+        QL_REQUIRE(Date(Settings::instance().evaluationDate()) == trade.evaluationDate,
+                   "greeks for " << trade.evaluationDate << " inside a job on "
+                   << Settings::instance().evaluationDate());
+    }
+
+    std::optional<ThreadPool> ownPool;
+    if (settings.threads != 0)
+        ownPool.emplace(settings.threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    // The base graph fixes the strike and the tree grid; every worker graph
+    // reprices exactly that trade on exactly that grid.
+    std::vector<std::unique_ptr<MarketGraph>> graphs;
+    graphs.push_back(std::make_unique<MarketGraph>(trade, settings.buckets, std::nullopt));
+    MarketGraph& base = *graphs.front();
+    std::optional<TimeGrid> grid;
+    if (trade.engine == "tree" || trade.engine == "hw-simd") {
+        base.attach(nullptr);
+        grid = base.treeGrid();
+    }
+    const TimeGrid* sharedGrid = grid ? &*grid : nullptr;
+    base.attach(sharedGrid);
+
+    BermudanGreeks greeks;
+    greeks.buckets = settings.buckets;
+    greeks.npv = base.price();
+
+    const double curveShift = settings.curveShift;
+    std::vector<Bump> bumps;
+    if (settings.adjoint) {
+        QL_REQUIRE(grid, "adjoint Greeks require a tree engine");
+        Real npv = 0.0;
+        greeks.deltas = base.adjointDeltas(*grid, curveShift, npv);
+        QL_ENSURE(std::fabs(npv - greeks.npv) <= 1e-8 * std::max(1.0, std::fabs(greeks.npv)),
+                  "adjoint tree NPV " << npv << " does not match engine NPV " << greeks.npv);
+    } else {
+        for (std::size_t k = 0; k < settings.buckets.size(); ++k) {
+            bumps.push_back({Bump::Bucket, k, curveShift});
+            bumps.push_back({Bump::Bucket, k, -curveShift});
+        }
+    }
+    const std::size_t firstParallel = bumps.size();
+    bumps.push_back({Bump::Parallel, 0, curveShift});
+    bumps.push_back({Bump::Parallel, 0, -curveShift});
+    const std::size_t firstParam = bumps.size();
+    for (Size p = 0; p < base.parameterCount(); ++p) {
+        bumps.push_back({Bump::Param, p, settings.paramShift});
+        bumps.push_back({Bump::Param, p, -settings.paramShift});
+    }
+
+    // One graph per slot, built lazily on the worker; slot 0 reuses the base.
+    std::vector<double> values(bumps.size());
+    const std::size_t slots = std::max<std::size_t>(1, std::min(pool.size(), bumps.size()));
+    graphs.resize(slots);
+    const Rate strike = base.strike();
+    pool.parallelFor(slots, [&](std::size_t slot) {
+        if (QuantLibSession::isolated())
+            Settings::instance().evaluationDate() = trade.evaluationDate;
+        if (!graphs[slot]) {
+            graphs[slot] = std::make_unique<MarketGraph>(trade, settings.buckets, strike);
+            graphs[slot]->attach(sharedGrid);
+        }
+        for (std::size_t k = slot; k < bumps.size(); k += slots)
+            values[k] = graphs[slot]->price(bumps[k]);
+    });
+
+    if (!settings.adjoint) {
+        greeks.deltas.resize(settings.buckets.size());
+        for (std::size_t k = 0; k < greeks.deltas.size(); ++k)
+            greeks.deltas[k] = 0.5 * (values[2 * k] - values[2 * k + 1]);
+    }
+    greeks.gamma = values[firstParallel] - 2.0 * greeks.npv + values[firstParallel + 1];
+    greeks.vegas.resize(base.parameterCount());
+    for (std::size_t p = 0; p < greeks.vegas.size(); ++p)
+        greeks.vegas[p] = 0.5 * (values[firstParam + 2 * p] - values[firstParam + 2 * p + 1]);
+    return greeks;
+}
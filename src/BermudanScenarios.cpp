@@ -0,0 +1,117 @@
+#include "BermudanSwaptionPricer.hpp"
+#include "MarketGraph.hpp"
+#include "QuantLibSession.hpp"
+#include "ThreadPool.hpp"
+
+#include <ql/settings.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <optional>
+
+using namespace QuantLib;
+
+std::vector<double> ScenarioResults::pnl() const {
+    std::vector<double> result;
+    result.reserve(npvs.size());
+    for (const std::vector<double>& scenario : npvs) {
+        double total = 0.0;
+        for (std::size_t i = 0; i < scenario.size(); ++i)
+            total += scenario[i] - base[i];
+        result.push_back(total);
+    }
+    return result;
+}
+
+double ScenarioResults::valueAtRisk(double confidence) const {
+    QL_REQUIRE(confidence > 0.0 && confidence < 1.0,
+               "VaR confidence must be in (0, 1), got " << confidence);
+    std::vector<double> sorted = pnl();
+    QL_REQUIRE(!sorted.empty(), "no scenarios priced");
+    std::sort(sorted.begin(), sorted.end());
+    const double tail = std::ceil((1.0 - confidence) * sorted.size() - 1e-9);
+    const std::size_t k = std::min(sorted.size(), std::max<std::size_t>(1, std::size_t(tail))) - 1;
+    return -sorted[k];
+}
+
+ScenarioResults BermudanSwaptionPricer::scenarios(std::span<const BermudanTrade> trades,
+                                                  const std::vector<std::vector<double>>& shifts,
+                                                  const ScenarioSettings& settings) {
+    QL_REQUIRE(!settings.buckets.empty(), "no curve buckets given");
+    QL_REQUIRE(settings.modelParams.empty() || settings.modelParams.size() == trades.size(),
+               settings.modelParams.size() << " model parameter sets for "
+               << trades.size() << " trades");
+    for (std::size_t s = 0; s < shifts.size(); ++s)
+        QL_REQUIRE(shifts[s].size() == settings.buckets.size(),
+                   "scenario " << s << " has " << shifts[s].size() << " shifts for "
+                   << settings.buckets.size() << " buckets");
+
+    // Column 0 is the unshifted market, column s + 1 scenario s
+    const std::vector<double> unshifted(settings.buckets.size(), 0.0);
+    const std::size_t columns = shifts.size() + 1;
+    auto spreads = [&](std::size_t k) -> const std::vector<double>& {
+        return k == 0 ? unshifted : shifts[k - 1];
+    };
+    std::vector<std::vector<double>> values(trades.size(), std::vector<double>(columns));
+    const std::vector<double> noParams;
+
+    std::optional<ThreadPool> ownPool;
+    if (settings.threads != 0)
+        ownPool.emplace(settings.threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    SavedSettings backup;
+
+    // Few trades: split each trade's columns over several graphs so every
+    // worker has one. Graphs of a trade agree exactly (same strike from the
+    // unshifted curve, same grid), so the split does not change results.
+    auto run = [&](const std::vector<std::size_t>& rows) {
+        const std::size_t slots = std::clamp<std::size_t>(
+            (pool.size() + rows.size() - 1) / rows.size(), 1, columns);
+        pool.parallelFor(rows.size() * slots, [&](std::size_t task) {
+            const std::size_t i = rows[task / slots];
+            const std::size_t slot = task % slots;
+            const BermudanTrade& trade = trades[i];
+            if (QuantLibSession::isolated())
+                Settings::instance().evaluationDate() = trade.evaluationDate;
+
+            std::optional<TimeGrid> grid;      // outlives the graph's pricer
+            MarketGraph graph(trade, settings.buckets, std::nullopt,
+                              settings.modelParams.empty() ? noParams : settings.modelParams[i]);
+            if (trade.engine == "tree" || trade.engine == "hw-simd") {
+                graph.attach(nullptr);
+                grid = graph.treeGrid();
+            }
+            graph.attach(grid ? &*grid : nullptr);
+            for (std::size_t k = slot; k < columns; k += slots)
+                values[i][k] = graph.price(spreads(k));
+        });
+    };
+
+    if (QuantLibSession::isolated()) {
+        std::vector<std::size_t> rows(trades.size());
+        std::iota(rows.begin(), rows.end(), std::size_t(0));
+        if (!rows.empty())
+            run(rows);
+    } else {
+        // Shared Settings: one parallel pass per distinct evaluation date
+        std::map<Date, std::vector<std::size_t>> byDate;
+        for (std::size_t i = 0; i < trades.size(); ++i)
+            byDate[trades[i].evaluationDate].push_back(i);
+        for (const auto& entry : byDate) {
+            Settings::instance().evaluationDate() = entry.first;
+            run(entry.second);
+        }
+    }
+
+    ScenarioResults results;
+    results.base.resize(trades.size());
+    results.npvs.assign(shifts.size(), std::vector<double>(trades.size()));
+    for (std::size_t i = 0; i < trades.size(); ++i) {
+        results.base[i] = values[i][0];
+        for (std::size_t s = 0; s < shifts.size(); ++s)
+            results.npvs[s][i] = values[i][s + 1];
+    }
+    return results;
+}
@@ -1,62 +1,320 @@
 #include "BermudanSwaptionPricer.hpp"
+#include "BasicBermudanSwaptionPricer.hpp"
+#include "MarketCache.hpp"
+#include "QuantLibSession.hpp"
+#include "ThreadPool.hpp"
+#include "TradeObjects.hpp"
 
-#include <ql/cashflows/coupon.hpp>
-#include <ql/pricingengines/swaption/treeswaptionengine.hpp>
-#include <ql/pricingengines/swaption/fdhullwhiteswaptionengine.hpp>
-#include <ql/pricingengines/swaption/fdg2swaptionengine.hpp>
+#include <ql/settings.hpp>
 #include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
 #include <ql/models/shortrate/twofactormodels/g2.hpp>
 #include <ql/models/shortrate/onefactormodels/blackkarasinski.hpp>
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <tuple>
 
 using namespace QuantLib;
 
+namespace {
+
+    template <class Engine, class Model>
+    std::unique_ptr<BermudanSwaptionPricerBase>
+    typed(const ext::shared_ptr<VanillaSwap>& swap, const ext::shared_ptr<Model>& model,
+          const TimeGrid* grid, const LsmcSettings& lsmc, const GridSettings& gridSettings) {
+        return std::make_unique<BasicBermudanSwaptionPricer<Model, Engine>>(
+            swap, model, grid, lsmc, gridSettings);
+    }
+
+    // Assigning the date notifies every observer even when it is unchanged;
+    // skipping that lets concurrent jobs on one date (PricingService) leave
+    // the shared Settings alone
+    void setEvaluationDate(const Date& date) {
+        if (Date(Settings::instance().evaluationDate()) != date)
+            Settings::instance().evaluationDate() = date;
+    }
+
+    // Rows priceBook() may price off one market graph
+    bool sameMarket(const BermudanTrade& a, const BermudanTrade& b) {
+        const LsmcSettings& x = a.lsmc;
+        const LsmcSettings& y = b.lsmc;
+        return a.evaluationDate == b.evaluationDate && a.flatRate == b.flatRate &&
+               a.model == b.model && a.engine == b.engine && a.swap == b.swap &&
+               a.modelParams == b.modelParams &&
+               x.calibrationPaths == y.calibrationPaths && x.maxPaths == y.maxPaths &&
+               x.tolerance == y.tolerance && x.blockSize == y.blockSize &&
+               x.seed == y.seed && x.threads == y.threads &&
+               a.grid.tolerance == b.grid.tolerance && a.grid.minSteps == b.grid.minSteps &&
+               a.grid.maxSteps == b.grid.maxSteps && a.grid.richardson == b.grid.richardson;
+    }
+
+    bool marketLess(const BermudanTrade& a, const BermudanTrade& b) {
+        const LsmcSettings& x = a.lsmc;
+        const LsmcSettings& y = b.lsmc;
+        return std::tie(a.evaluationDate, a.flatRate, a.model, a.engine, a.swap, a.modelParams,
+                        x.calibrationPaths, x.maxPaths, x.tolerance, x.blockSize,
+                        x.seed, x.threads, a.grid.tolerance, a.grid.minSteps,
+                        a.grid.maxSteps, a.grid.richardson) <
+               std::tie(b.evaluationDate, b.flatRate, b.model, b.engine, b.swap, b.modelParams,
+                        y.calibrationPaths, y.maxPaths, y.tolerance, y.blockSize,
+                        y.seed, y.threads, b.grid.tolerance, b.grid.minSteps,
+                        b.grid.maxSteps, b.grid.richardson);
+    }
+
+    std::vector<double> priceLadder(BermudanSwaptionPricer& pricer, const std::string& engine,
+                                    const std::vector<Rate>& strikes) {
+        if (engine == "fdm") {
+            // FD engines rebuild the swap with a cloned index inside calculate()
+            QuantLibSession::Guard guard;
+            return pricer.priceStrikes(strikes);
+        }
+        return pricer.priceStrikes(strikes);
+    }
+
+    // Assumes the evaluation date is already set for the calling session.
+    // Prices trades[rows] (same market) as one strike ladder, on a cached
+    // graph when a MarketCache is given.
+    void priceLadderAtEvaluationDate(std::span<const BermudanTrade> trades,
+                                     std::span<const std::size_t> rows,
+                                     MarketCache* markets,
+                                     std::vector<double>& results) {
+        BermudanTrade atm = trades[rows.front()];
+        atm.strikeMultiplier = 1.0;
+
+        auto strikesFrom = [&](Rate fair) {
+            std::vector<Rate> strikes;
+            strikes.reserve(rows.size());
+            for (std::size_t i : rows)
+                strikes.push_back(fair * trades[i].strikeMultiplier);
+            return strikes;
+        };
+
+        std::vector<double> npvs;
+        if (markets) {
+            MarketCache::Lease lease = markets->acquire(atm);
+            npvs = priceLadder(lease.pricer(), atm.engine, strikesFrom(lease.atmRate()));
+        } else {
+            TradeObjects objects(atm);
+            BermudanSwaptionPricer pricer(objects.swap, objects.model, atm.engine,
+                                          nullptr, atm.lsmc, atm.grid);
+            npvs = priceLadder(pricer, atm.engine, strikesFrom(objects.swap->fixedRate()));
+        }
+        for (std::size_t k = 0; k < rows.size(); ++k)
+            results[rows[k]] = npvs[k];
+    }
+
+    // Assumes the evaluation date is already set for the calling session.
+    double priceAtEvaluationDate(const BermudanTrade& trade) {
+        TradeObjects objects(trade);
+        BermudanSwaptionPricer pricer(objects.swap, objects.model, trade.engine,
+                                      nullptr, trade.lsmc, trade.grid);
+        if (trade.engine == "fdm") {
+            // FD engines rebuild the swap with a cloned index inside calculate()
+            QuantLibSession::Guard guard;
+            return pricer.price();
+        }
+        return pricer.price();
+    }
+
+}
+
 BermudanSwaptionPricer::BermudanSwaptionPricer(
     const ext::shared_ptr<VanillaSwap>& swap,
     const ext::shared_ptr<ShortRateModel>& model,
     const std::string& engineType,
-    const TimeGrid* grid)
-    : swap_(swap),
-      model_(model),
-      engineType_(engineType),
-      grid_(grid) {
-    QL_REQUIRE(swap_, "Null swap");
-    QL_REQUIRE(model_, "Null model");
-}
+    const TimeGrid* grid,
+    const LsmcSettings& lsmc,
+    const GridSettings& gridSettings) {
+    QL_REQUIRE(swap, "Null swap");
+    QL_REQUIRE(model, "Null model");
 
-double BermudanSwaptionPricer::price() {
-    std::vector<Date> bermudanDates;
-    const auto& leg = swap_->fixedLeg();
-    bermudanDates.reserve(leg.size());
-    for (const auto& cf : leg) {
-        auto cpn = ext::dynamic_pointer_cast<Coupon>(cf);
-        if (cpn)
-            bermudanDates.push_back(cpn->accrualStartDate());
-    }
-
-    auto exercise = ext::make_shared<BermudanExercise>(bermudanDates);
-    Swaption bermudan(swap_, exercise);
-
-    auto modelG2 = ext::dynamic_pointer_cast<G2>(model_);
-    auto modelHW = ext::dynamic_pointer_cast<HullWhite>(model_);
-    auto modelBK = ext::dynamic_pointer_cast<BlackKarasinski>(model_);
-
-    if (engineType_ == "fdm") {
-        if (modelG2) {
-            bermudan.setPricingEngine(ext::make_shared<FdG2SwaptionEngine>(modelG2));
-        } else if (modelHW) {
-            bermudan.setPricingEngine(ext::make_shared<FdHullWhiteSwaptionEngine>(modelHW));
+    auto hw = ext::dynamic_pointer_cast<HullWhite>(model);
+    auto g2 = ext::dynamic_pointer_cast<G2>(model);
+    auto bk = ext::dynamic_pointer_cast<BlackKarasinski>(model);
+
+    if (engineType == "tree") {
+        if (hw)
+            impl_ = typed<TreeEngine>(swap, hw, grid, lsmc, gridSettings);
+        else if (g2)
+            impl_ = typed<TreeEngine>(swap, g2, grid, lsmc, gridSettings);
+        else if (bk)
+            impl_ = typed<TreeEngine>(swap, bk, grid, lsmc, gridSettings);
+        else
+            impl_ = typed<TreeEngine>(swap, model, grid, lsmc, gridSettings);
+    } else if (engineType == "fdm") {
+        if (hw) {
+            impl_ = typed<FdEngine>(swap, hw, grid, lsmc, gridSettings);
+        } else if (g2) {
+            impl_ = typed<FdEngine>(swap, g2, grid, lsmc, gridSettings);
         } else {
-            bermudan.setPricingEngine(ext::make_shared<TreeSwaptionEngine>(
-                model_, grid_ ? *grid_ : TimeGrid(50, 50)));
+            if (!grid && gridSettings.tolerance <= 0.0) {
+                fallbackGrid_ = std::make_unique<TimeGrid>(50.0, 50);
+                grid = fallbackGrid_.get();
+            }
+            if (bk)
+                impl_ = typed<TreeEngine>(swap, bk, grid, lsmc, gridSettings);
+            else
+                impl_ = typed<TreeEngine>(swap, model, grid, lsmc, gridSettings);
         }
+    } else if (engineType == "fdm-adi") {
+        QL_REQUIRE(g2, "fdm-adi engine requires a G2 model");
+        impl_ = typed<G2AdiEngine>(swap, g2, grid, lsmc, gridSettings);
+    } else if (engineType == "hw-simd") {
+        QL_REQUIRE(hw, "hw-simd engine requires a HullWhite model");
+        impl_ = typed<HwSimdEngine>(swap, hw, grid, lsmc, gridSettings);
+    } else if (engineType == "lsmc") {
+        QL_REQUIRE(hw || g2, "lsmc engine requires a G2 or HullWhite model");
+        if (hw)
+            impl_ = typed<LsmcEngine>(swap, hw, grid, lsmc, gridSettings);
+        else
+            impl_ = typed<LsmcEngine>(swap, g2, grid, lsmc, gridSettings);
     } else {
-        if (grid_) {
-            bermudan.setPricingEngine(ext::make_shared<TreeSwaptionEngine>(model_, *grid_));
-        } else {
-            bermudan.setPricingEngine(ext::make_shared<TreeSwaptionEngine>(model_, 50));
-        }
+        QL_FAIL("Unknown engine: " << engineType
+                << " (use 'tree' | 'fdm' | 'fdm-adi' | 'hw-simd' | 'lsmc')");
+    }
+}
+
+BermudanSwaptionPricer::~BermudanSwaptionPricer() = default;
+
+// The swaption observes the swap and engine, which in turn observe the model
+// and curve, so quote or parameter changes mark it dirty. A repeated price()
+// with unchanged inputs is a cache hit; otherwise only calculate() reruns.
+double BermudanSwaptionPricer::price() {
+    return impl_->price();
+}
+
+std::size_t BermudanSwaptionPricer::gridSteps() const {
+    return impl_->gridSteps();
+}
+
+double BermudanSwaptionPricer::gridError() const {
+    return impl_->gridError();
+}
+
+std::vector<double>
+BermudanSwaptionPricer::priceStrikes(const std::vector<Rate>& strikes) const {
+    return impl_->priceStrikes(strikes);
+}
+
+const std::vector<Date>& BermudanSwaptionPricer::exerciseDates() const {
+    return impl_->exerciseDates();
+}
+
+const ext::shared_ptr<Swaption>& BermudanSwaptionPricer::swaption() const {
+    return impl_->swaption();
+}
+
+double BermudanSwaptionPricer::priceTrade(const BermudanTrade& trade) {
+    setEvaluationDate(trade.evaluationDate);
+    return priceAtEvaluationDate(trade);
+}
+
+std::vector<double> BermudanSwaptionPricer::priceBatch(
+    std::span<const BermudanTrade> trades,
+    std::size_t threads) {
+
+    std::vector<double> results(trades.size());
+    if (trades.empty())
+        return results;
+
+    std::optional<ThreadPool> ownPool;
+    if (threads != 0)
+        ownPool.emplace(threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    SavedSettings backup;
+
+    if (QuantLibSession::isolated()) {
+        // Every worker thread owns its Settings; set the date per trade.
+        pool.parallelFor(trades.size(), [&](std::size_t i) {
+            setEvaluationDate(trades[i].evaluationDate);
+            results[i] = priceAtEvaluationDate(trades[i]);
+        });
+        return results;
+    }
+
+    // Shared Settings: the evaluation date may only change while no worker
+    // is pricing, so run one parallel pass per distinct date.
+    std::map<Date, std::vector<std::size_t>> byDate;
+    for (std::size_t i = 0; i < trades.size(); ++i)
+        byDate[trades[i].evaluationDate].push_back(i);
+
+    for (const auto& entry : byDate) {
+        const std::vector<std::size_t>& indices = entry.second;
+        setEvaluationDate(entry.first);
+        pool.parallelFor(indices.size(), [&](std::size_t k) {
+            const std::size_t i = indices[k];
+            results[i] = priceAtEvaluationDate(trades[i]);
+        });
     }
+    return results;
+}
 
-    return bermudan.NPV();
+ext::shared_ptr<ShortRateModel>
+BermudanSwaptionPricer::makeModel(const std::string& name,
+                                  const Handle<YieldTermStructure>& ts) {
+    if (name == "g2")  return ext::make_shared<G2>(ts);
+    if (name == "hw")  return ext::make_shared<HullWhite>(ts);
+    if (name == "bk")  return ext::make_shared<BlackKarasinski>(ts);
+    QL_FAIL("Unknown model: " << name << " (use 'g2' | 'hw' | 'bk')");
 }
 
+std::vector<double> BermudanSwaptionPricer::priceBook(
+    std::span<const BermudanTrade> trades,
+    std::size_t threads,
+    std::size_t ladderChunk,
+    MarketCache* markets) {
+
+    QL_REQUIRE(ladderChunk > 0, "ladderChunk must be positive");
+    std::vector<double> results(trades.size());
+    if (trades.empty())
+        return results;
+
+    // Sort row indices by market so every group is a contiguous run, then
+    // cut the runs into ladder chunks.
+    std::vector<std::size_t> order(trades.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return marketLess(trades[a], trades[b]);
+    });
+
+    std::vector<std::span<const std::size_t>> chunks;
+    for (std::size_t begin = 0; begin < order.size();) {
+        std::size_t end = begin + 1;
+        while (end < order.size() && end - begin < ladderChunk &&
+               sameMarket(trades[order[begin]], trades[order[end]]))
+            ++end;
+        chunks.emplace_back(order.data() + begin, end - begin);
+        begin = end;
+    }
+
+    std::optional<ThreadPool> ownPool;
+    if (threads != 0)
+        ownPool.emplace(threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    SavedSettings backup;
+
+    if (QuantLibSession::isolated()) {
+        pool.parallelFor(chunks.size(), [&](std::size_t c) {
+            setEvaluationDate(trades[chunks[c].front()].evaluationDate);
+            priceLadderAtEvaluationDate(trades, chunks[c], markets, results);
+        });
+        return results;
+    }
+
+    // Chunks are sorted by date: one parallel pass per distinct date.
+    for (std::size_t begin = 0; begin < chunks.size();) {
+        const Date date = trades[chunks[begin].front()].evaluationDate;
+        std::size_t end = begin + 1;
+        while (end < chunks.size() && trades[chunks[end].front()].evaluationDate == date)
+            ++end;
+        setEvaluationDate(date);
+        pool.parallelFor(end - begin, [&](std::size_t k) {
+            priceLadderAtEvaluationDate(trades, chunks[begin + k], markets, results);
+        });
+        begin = end;
+    }
+    return results;
+}
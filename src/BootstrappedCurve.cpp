@@ -0,0 +1,211 @@
+#include "BootstrappedCurve.hpp"
+#include "Metrics.hpp"
+
+#include <ql/math/solvers1d/brent.hpp>
+#include <ql/settings.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace QuantLib;
+
+// Forwards a helper's notification (quote tick, date roll) with its index
+class BootstrappedCurve::HelperWatch : public Observer {
+public:
+    HelperWatch(BootstrappedCurve* curve, std::size_t index, const ext::shared_ptr<RateHelper>& helper)
+        : curve_(curve), index_(index) {
+        registerWith(helper);
+    }
+    void update() override { curve_->helperChanged(index_); }
+
+private:
+    BootstrappedCurve* curve_;
+    std::size_t index_;
+};
+
+double DiscountCurveSnapshot::discount(double t) const {
+    const std::size_t last = times.size() - 1;
+    const auto above = static_cast<std::size_t>(
+        std::upper_bound(times.begin(), times.end(), t) - times.begin());
+    // Before the first node: extrapolate the first segment backwards
+    const std::size_t s = above == 0 ? 0 : above - 1;
+    if (s >= last)
+        return std::exp(logDiscounts[last] - forwards[last - 1] * (t - times[last]));
+    return std::exp(logDiscounts[s] - forwards[s] * (t - times[s]));
+}
+
+BootstrappedCurve::BootstrappedCurve(const Date& referenceDate,
+                                     std::vector<ext::shared_ptr<RateHelper>> helpers,
+                                     const DayCounter& dayCounter,
+                                     double accuracy)
+    : YieldTermStructure(referenceDate, Calendar(), dayCounter),
+      helpers_(std::move(helpers)),
+      accuracy_(accuracy),
+      dirty_(helpers_.size(), 1) {
+    QL_REQUIRE(!helpers_.empty(), "no rate helpers given");
+    watches_.reserve(helpers_.size());
+    for (std::size_t k = 0; k < helpers_.size(); ++k) {
+        QL_REQUIRE(helpers_[k], "null rate helper at position " << k);
+        watches_.push_back(ext::make_shared<HelperWatch>(this, k, helpers_[k]));
+    }
+    registerWith(Settings::instance().evaluationDate());
+}
+
+BootstrappedCurve::~BootstrappedCurve() = default;
+
+Date BootstrappedCurve::maxDate() const {
+    calculate();
+    return pillars_.back().date;
+}
+
+void BootstrappedCurve::update() {
+    // Evaluation date moved: helper dates may have changed
+    layoutDirty_ = true;
+    LazyObject::update();
+}
+
+void BootstrappedCurve::helperChanged(std::size_t index) {
+    if (bootstrapping_)
+        return;
+    dirty_[index] = 1;
+    LazyObject::update();
+}
+
+std::shared_ptr<const DiscountCurveSnapshot> BootstrappedCurve::snapshot() const {
+    calculate();
+    return published_;
+}
+
+DiscountFactor BootstrappedCurve::discountImpl(Time t) const {
+    calculate();
+    return nodes_.discount(t);
+}
+
+void BootstrappedCurve::layout() const {
+    const std::size_t n = helpers_.size();
+    std::vector<std::size_t> order(n);
+    for (std::size_t k = 0; k < n; ++k)
+        order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return helpers_[a]->pillarDate() < helpers_[b]->pillarDate();
+    });
+
+    // Keep solved nodes as starting points when only the dates moved
+    const std::vector<double> previous = nodes_.logDiscounts;
+
+    pillars_.assign(n, Pillar());
+    position_.assign(n, 0);
+    nodes_.times.assign(n + 1, 0.0);
+    nodes_.logDiscounts.assign(n + 1, 0.0);
+    nodes_.forwards.assign(n, 0.0);
+
+    auto* self = const_cast<BootstrappedCurve*>(this);
+    for (std::size_t i = 0; i < n; ++i) {
+        Pillar& p = pillars_[i];
+        p.helper = helpers_[order[i]];
+        p.date = p.helper->pillarDate();
+        position_[order[i]] = i;
+        QL_REQUIRE(p.date > referenceDate(),
+                   "pillar " << p.date << " is not after the reference date " << referenceDate());
+        QL_REQUIRE(i == 0 || p.date != pillars_[i - 1].date,
+                   "more than one instrument with pillar " << p.date);
+        p.helper->setTermStructure(self);
+
+        nodes_.times[i + 1] = timeFromReference(p.date);
+        nodes_.logDiscounts[i + 1] = previous.size() == n + 1 ? previous[i + 1]
+                                                              : -0.02 * nodes_.times[i + 1];
+
+        // Deposits and FRAs read two discount factors; anything else
+        // (swaps) is assumed to read the whole span it covers.
+        const Time start = timeFromReference(p.helper->earliestDate());
+        const Time end = timeFromReference(p.helper->latestDate());
+        p.reads = {start, end};
+        p.readsSpan = !ext::dynamic_pointer_cast<DepositRateHelper>(p.helper) &&
+                      !ext::dynamic_pointer_cast<FraRateHelper>(p.helper);
+    }
+    for (std::size_t p = 1; p <= n; ++p)
+        setNode(p, nodes_.logDiscounts[p]);
+
+    // Node i + 1 enters the discount on (times[i], times[i + 2])
+    for (std::size_t i = 0; i < n; ++i) {
+        const Time lo = nodes_.times[i];
+        const Time hi = i + 2 <= n ? nodes_.times[i + 2] : std::numeric_limits<Time>::max();
+        for (std::size_t j = i + 1; j < n; ++j) {
+            const Pillar& q = pillars_[j];
+            bool reads = false;
+            if (q.readsSpan) {
+                reads = q.reads.front() < hi && q.reads.back() > lo;
+            } else {
+                for (Time t : q.reads)
+                    reads = reads || (t > lo && t < hi);
+            }
+            if (reads)
+                pillars_[i].dependents.push_back(j);
+        }
+    }
+    layoutDirty_ = false;
+}
+
+void BootstrappedCurve::setNode(std::size_t node, double logDiscount) const {
+    std::vector<double>& t = nodes_.times;
+    std::vector<double>& l = nodes_.logDiscounts;
+    l[node] = logDiscount;
+    nodes_.forwards[node - 1] = (l[node - 1] - l[node]) / (t[node] - t[node - 1]);
+    if (node + 1 < t.size())
+        nodes_.forwards[node] = (l[node] - l[node + 1]) / (t[node + 1] - t[node]);
+}
+
+void BootstrappedCurve::solve(std::size_t pillar) const {
+    const std::size_t node = pillar + 1;
+    RateHelper& helper = *pillars_[pillar].helper;
+    auto error = [&](Real logDiscount) {
+        setNode(node, logDiscount);
+        return helper.quoteError();
+    };
+    Brent solver;
+    solver.setMaxEvaluations(100);
+    const Real root = solver.solve(error, accuracy_, nodes_.logDiscounts[node], 1e-4);
+    setNode(node, root);
+}
+
+void BootstrappedCurve::performCalculations() const {
+    BERMUDAN_TIME_STAGE(Stage::CurveBuild);
+    struct Flag {
+        bool& f;
+        explicit Flag(bool& flag) : f(flag) { f = true; }
+        ~Flag() { f = false; }
+    } bootstrapping(bootstrapping_);
+
+    try {
+        if (layoutDirty_) {
+            layout();
+            std::fill(dirty_.begin(), dirty_.end(), 1);
+        }
+
+        const std::size_t n = pillars_.size();
+        std::vector<char> todo(n, 0);
+        for (std::size_t k = 0; k < n; ++k)
+            if (dirty_[k])
+                todo[position_[k]] = 1;
+
+        // Pillars are solved in date order, so a node only feeds later ones
+        lastSolved_ = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!todo[i])
+                continue;
+            const double before = nodes_.logDiscounts[i + 1];
+            solve(i);
+            ++lastSolved_;
+            if (nodes_.logDiscounts[i + 1] != before) {
+                for (std::size_t j : pillars_[i].dependents)
+                    todo[j] = 1;
+            }
+        }
+    } catch (...) {
+        layoutDirty_ = true;
+        throw;
+    }
+
+    std::fill(dirty_.begin(), dirty_.end(), 0);
+    published_ = std::make_shared<const DiscountCurveSnapshot>(nodes_);
+}
@@ -0,0 +1,62 @@
+#include "BootstrappedCurveBuilder.hpp"
+
+#include <ql/indexes/ibor/euribor.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/time/daycounters/thirty360.hpp>
+
+using namespace QuantLib;
+
+namespace {
+    constexpr Natural kFixingDays = 2;
+}
+
+ext::shared_ptr<SimpleQuote>
+BootstrappedCurveBuilder::addDeposit(const Period& tenor, Rate rate) {
+    auto quote = ext::make_shared<SimpleQuote>(rate);
+    factories_.push_back([quote, tenor]() -> ext::shared_ptr<RateHelper> {
+        return ext::make_shared<DepositRateHelper>(
+            Handle<Quote>(quote), tenor, kFixingDays, TARGET(), ModifiedFollowing, true, Actual360());
+    });
+    return quote;
+}
+
+ext::shared_ptr<SimpleQuote>
+BootstrappedCurveBuilder::addFra(Natural monthsToStart, Natural monthsToEnd, Rate rate) {
+    auto quote = ext::make_shared<SimpleQuote>(rate);
+    factories_.push_back([quote, monthsToStart, monthsToEnd]() -> ext::shared_ptr<RateHelper> {
+        return ext::make_shared<FraRateHelper>(
+            Handle<Quote>(quote), monthsToStart, monthsToEnd, kFixingDays, TARGET(),
+            ModifiedFollowing, true, Actual360());
+    });
+    return quote;
+}
+
+ext::shared_ptr<SimpleQuote>
+BootstrappedCurveBuilder::addSwap(const Period& tenor, Rate rate) {
+    auto quote = ext::make_shared<SimpleQuote>(rate);
+    factories_.push_back([quote, tenor]() -> ext::shared_ptr<RateHelper> {
+        return ext::make_shared<SwapRateHelper>(
+            Handle<Quote>(quote), tenor, TARGET(), Annual, Unadjusted,
+            Thirty360(Thirty360::European), ext::make_shared<Euribor6M>());
+    });
+    return quote;
+}
+
+ext::shared_ptr<BootstrappedCurve>
+BootstrappedCurveBuilder::build(const Date& settlementDate) const {
+    std::vector<ext::shared_ptr<RateHelper>> helpers;
+    helpers.reserve(factories_.size());
+    for (const auto& make : factories_)
+        helpers.push_back(make());
+    auto curve = ext::make_shared<BootstrappedCurve>(settlementDate, std::move(helpers),
+                                                     Actual365Fixed());
+    curve->enableExtrapolation();
+    return curve;
+}
+
+Handle<YieldTermStructure>
+BootstrappedCurveBuilder::buildCurve(const Date& settlementDate) const {
+    return Handle<YieldTermStructure>(build(settlementDate));
+}
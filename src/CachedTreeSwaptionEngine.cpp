@@ -0,0 +1,57 @@
+#include "CachedTreeSwaptionEngine.hpp"
+#include "Metrics.hpp"
+#include "PricingCancellation.hpp"
+
+#include <ql/pricingengines/swaption/discretizedswaption.hpp>
+#include <algorithm>
+
+using namespace QuantLib;
+
+CachedTreeSwaptionEngine::CachedTreeSwaptionEngine(
+    const ext::shared_ptr<BlackKarasinski>& model, Size timeSteps, FittedLatticeCache& cache)
+    : GenericModelEngine<BlackKarasinski, Swaption::arguments, Swaption::results>(model),
+      timeSteps_(timeSteps),
+      cache_(cache) {
+    QL_REQUIRE(timeSteps_ > 0, "timeSteps must be positive");
+}
+
+CachedTreeSwaptionEngine::CachedTreeSwaptionEngine(
+    const ext::shared_ptr<BlackKarasinski>& model, const TimeGrid& grid, FittedLatticeCache& cache)
+    : GenericModelEngine<BlackKarasinski, Swaption::arguments, Swaption::results>(model),
+      timeSteps_(0),
+      grid_(grid),
+      cache_(cache) {}
+
+void CachedTreeSwaptionEngine::calculate() const {
+    QL_REQUIRE(arguments_.settlementMethod != Settlement::ParYieldCurve,
+               "cash-settled (ParYieldCurve) swaptions not priced with tree engine");
+    QL_REQUIRE(!model_.empty(), "no model specified");
+
+    const Handle<YieldTermStructure>& ts = model_->termStructure();
+    const Date referenceDate = ts->referenceDate();
+    const DayCounter dayCounter = ts->dayCounter();
+
+    DiscretizedSwaption swaption(arguments_, referenceDate, dayCounter);
+    ext::shared_ptr<Lattice> lattice;
+    if (!grid_.empty()) {
+        lattice = cache_.tree(*model_.currentLink(), grid_);
+    } else {
+        std::vector<Time> times = swaption.mandatoryTimes();
+        lattice = cache_.tree(*model_.currentLink(),
+                              TimeGrid(times.begin(), times.end(), timeSteps_));
+    }
+
+    // Stopping logic mirrors TreeSwaptionEngine::calculate()
+    std::vector<Time> stoppingTimes(arguments_.exercise->dates().size());
+    for (Size i = 0; i < stoppingTimes.size(); ++i)
+        stoppingTimes[i] = dayCounter.yearFraction(referenceDate, arguments_.exercise->date(i));
+
+    const auto nextExercise = std::find_if(stoppingTimes.begin(), stoppingTimes.end(),
+                                           [](Time t) { return t >= 0.0; });
+    QL_REQUIRE(nextExercise != stoppingTimes.end(), "no exercise date left");
+
+    BERMUDAN_TIME_STAGE(Stage::Rollback);
+    swaption.initialize(lattice, stoppingTimes.back());
+    rollbackWithCheckpoints(swaption, *nextExercise);
+    results_.value = swaption.presentValue();
+}
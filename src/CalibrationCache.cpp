@@ -0,0 +1,163 @@
+#include "CalibrationCache.hpp"
+
+#include <ql/errors.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+    // Models have a handful of parameters; a larger count is a corrupt file
+    constexpr std::size_t kMaxParameters = 1024;
+}
+
+void SnapshotHash::bytes(const void* data, std::size_t size) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash_ ^= p[i];
+        hash_ *= 0x100000001b3ull;
+    }
+}
+
+void SnapshotHash::add(double value) {
+    if (value == 0.0)
+        value = 0.0;
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    bytes(&bits, sizeof bits);
+}
+
+void SnapshotHash::add(std::int64_t value) {
+    bytes(&value, sizeof value);
+}
+
+void SnapshotHash::add(const std::string& value) {
+    add(static_cast<std::int64_t>(value.size()));
+    bytes(value.data(), value.size());
+}
+
+CalibrationCache::CalibrationCache(std::size_t capacity, std::string directory)
+    : capacity_(capacity), directory_(std::move(directory)) {
+    QL_REQUIRE(capacity_ > 0, "calibration cache capacity must be positive");
+    if (!directory_.empty())
+        std::filesystem::create_directories(directory_);
+}
+
+std::optional<std::vector<double>> CalibrationCache::find(std::uint64_t key) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            it->second->lastUse.store(++clock_, std::memory_order_relaxed);
+            return it->second->parameters;
+        }
+    }
+    if (directory_.empty())
+        return std::nullopt;
+    auto parameters = load(key);
+    if (parameters)
+        insertInMemory(key, *parameters);
+    return parameters;
+}
+
+void CalibrationCache::insert(std::uint64_t key, const std::vector<double>& parameters) {
+    insertInMemory(key, parameters);
+    if (!directory_.empty())
+        store(key, parameters);
+}
+
+void CalibrationCache::insertInMemory(std::uint64_t key, const std::vector<double>& parameters) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        if (entries_.size() >= capacity_) {
+            auto oldest = std::min_element(entries_.begin(), entries_.end(),
+                [](const auto& a, const auto& b) {
+                    return a.second->lastUse.load(std::memory_order_relaxed) <
+                           b.second->lastUse.load(std::memory_order_relaxed);
+                });
+            entries_.erase(oldest);
+        }
+        it = entries_.emplace(key, std::make_unique<Entry>()).first;
+    }
+    it->second->parameters = parameters;
+    it->second->lastUse.store(++clock_, std::memory_order_relaxed);
+}
+
+std::size_t CalibrationCache::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void CalibrationCache::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    entries_.clear();
+}
+
+std::string CalibrationCache::pathFor(std::uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof name, "%016" PRIx64 ".params", key);
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+// File layout: the key in hex, the parameter count, then one value per line
+// in round-trip precision. A truncated or corrupt file is a miss.
+std::optional<std::vector<double>> CalibrationCache::load(std::uint64_t key) const {
+    std::ifstream in(pathFor(key));
+    if (!in)
+        return std::nullopt;
+    std::string header;
+    std::size_t count = 0;
+    if (!(in >> header >> count) || count > kMaxParameters)
+        return std::nullopt;
+    std::uint64_t stored = 0;
+    const char* end = header.data() + header.size();
+    const auto [ptr, ec] = std::from_chars(header.data(), end, stored, 16);
+    if (ec != std::errc() || ptr != end || stored != key)
+        return std::nullopt;
+    std::vector<double> parameters(count);
+    for (double& p : parameters)
+        if (!(in >> p))
+            return std::nullopt;
+    return parameters;
+}
+
+// Written to a temporary name unique to the process and thread, then
+// renamed, so concurrent readers (in this or another process) see either no
+// file or a complete one.
+void CalibrationCache::store(std::uint64_t key, const std::vector<double>& parameters) const {
+    const std::string path = pathFor(key);
+    std::ostringstream tmp;
+    tmp << path << ".tmp." << ::getpid() << '.'
+        << std::hash<std::thread::id>()(std::this_thread::get_id());
+    {
+        std::ofstream out(tmp.str(), std::ios::trunc);
+        if (!out)
+            return;
+        char header[32];
+        std::snprintf(header, sizeof header, "%016" PRIx64, key);
+        out << header << '\n' << parameters.size() << '\n';
+        out.precision(17);
+        for (double p : parameters)
+            out << p << '\n';
+        if (!out)
+            return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp.str(), path, ec);
+    if (ec)
+        std::filesystem::remove(tmp.str(), ec);
+}
+
+CalibrationCache& CalibrationCache::shared() {
+    static CalibrationCache cache;
+    return cache;
+}
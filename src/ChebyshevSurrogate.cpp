@@ -0,0 +1,231 @@
+#include "ChebyshevSurrogate.hpp"
+#include "PricingService.hpp"
+
+#include <ql/errors.hpp>
+#include <ql/mathconstants.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace QuantLib;
+
+namespace {
+
+    // Chebyshev points of the first kind on [-1, 1]
+    std::vector<double> chebyshevNodes(std::size_t n) {
+        std::vector<double> x(n);
+        for (std::size_t k = 0; k < n; ++k)
+            x[k] = std::cos(M_PI * (static_cast<double>(k) + 0.5) / static_cast<double>(n));
+        return x;
+    }
+
+    double toUnit(double v, double lo, double hi) {
+        return (2.0 * v - lo - hi) / (hi - lo);
+    }
+
+    double fromUnit(double x, double lo, double hi) {
+        return 0.5 * (lo + hi) + 0.5 * (hi - lo) * x;
+    }
+
+    // sum_k c[k] T_k(x)
+    double clenshaw(const double* c, std::size_t n, double x) {
+        double b1 = 0.0, b2 = 0.0;
+        for (std::size_t k = n; k-- > 1;) {
+            const double b0 = c[k] + 2.0 * x * b1 - b2;
+            b2 = b1;
+            b1 = b0;
+        }
+        return c[0] + x * b1 - b2;
+    }
+
+    // Coefficients c[k] of the degree n - 1 interpolant through values at
+    // the n first-kind nodes (stride apart in values / c)
+    void chebyshevTransform(const double* values, double* c, std::size_t n, std::size_t stride) {
+        const double scale = 2.0 / static_cast<double>(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            double sum = 0.0;
+            for (std::size_t i = 0; i < n; ++i)
+                sum += values[i * stride] *
+                       std::cos(M_PI * static_cast<double>(k) * (static_cast<double>(i) + 0.5) /
+                                static_cast<double>(n));
+            c[k * stride] = (k == 0 ? 0.5 : 1.0) * scale * sum;
+        }
+    }
+
+    // Offline grid pricing goes through the shared service at batch
+    // priority, so quotes overtake it and its evaluation date never
+    // overlaps another job's on stock builds
+    std::vector<double> priceGrid(std::vector<BermudanTrade> trades, std::size_t threads) {
+        JobOptions options;
+        options.priority = JobPriority::Batch;
+        options.threads = threads;
+        return PricingService::shared().submitBook(std::move(trades), options).result.get();
+    }
+
+}
+
+ChebyshevSurrogate ChebyshevSurrogate::build(const BermudanTrade& shape,
+                                             const SurrogateSettings& settings) {
+    QL_REQUIRE(settings.minRate < settings.maxRate &&
+               settings.minMultiplier < settings.maxMultiplier,
+               "empty surrogate domain");
+    QL_REQUIRE(settings.rateNodes >= 2 && settings.multiplierNodes >= 2,
+               "a surrogate needs at least two Chebyshev nodes per axis");
+    QL_REQUIRE(settings.checkNodes >= 2, "a surrogate needs at least two check nodes per axis");
+
+    const std::size_t nr = settings.rateNodes;
+    const std::size_t nm = settings.multiplierNodes;
+    const std::vector<double> xr = chebyshevNodes(nr);
+    const std::vector<double> xm = chebyshevNodes(nm);
+
+    // Node grid, rate-major, so each rate is one market ladder
+    std::vector<BermudanTrade> trades(nr * nm, shape);
+    for (std::size_t i = 0; i < nr; ++i) {
+        for (std::size_t j = 0; j < nm; ++j) {
+            BermudanTrade& t = trades[i * nm + j];
+            t.flatRate = fromUnit(xr[i], settings.minRate, settings.maxRate);
+            t.strikeMultiplier = fromUnit(xm[j], settings.minMultiplier, settings.maxMultiplier);
+        }
+    }
+    const std::vector<double> values = priceGrid(std::move(trades), settings.threads);
+    for (double v : values)
+        QL_REQUIRE(std::isfinite(v), "non-finite NPV on a surrogate node");
+
+    // Separable transform: along the multiplier for each rate, then along the rate
+    ChebyshevSurrogate surrogate;
+    surrogate.settings_ = settings;
+    std::vector<double> partial(nr * nm);
+    for (std::size_t i = 0; i < nr; ++i)
+        chebyshevTransform(&values[i * nm], &partial[i * nm], nm, 1);
+    surrogate.coefficients_.resize(nr * nm);
+    for (std::size_t j = 0; j < nm; ++j)
+        chebyshevTransform(&partial[j], &surrogate.coefficients_[j], nr, nm);
+
+    // Last row and column of the table: the highest degree kept on each axis
+    const std::vector<double>& c = surrogate.coefficients_;
+    for (std::size_t j = 0; j < nm; ++j)
+        surrogate.tailEstimate_ += std::fabs(c[(nr - 1) * nm + j]);
+    for (std::size_t i = 0; i + 1 < nr; ++i)
+        surrogate.tailEstimate_ += std::fabs(c[i * nm + nm - 1]);
+
+    // Independent check grid, corners included, where first-kind
+    // interpolants are weakest
+    const std::size_t nc = settings.checkNodes;
+    std::vector<BermudanTrade> checks(nc * nc, shape);
+    for (std::size_t i = 0; i < nc; ++i) {
+        for (std::size_t j = 0; j < nc; ++j) {
+            const double u = static_cast<double>(i) / static_cast<double>(nc - 1);
+            const double v = static_cast<double>(j) / static_cast<double>(nc - 1);
+            BermudanTrade& t = checks[i * nc + j];
+            t.flatRate = settings.minRate + u * (settings.maxRate - settings.minRate);
+            t.strikeMultiplier =
+                settings.minMultiplier + v * (settings.maxMultiplier - settings.minMultiplier);
+        }
+    }
+    const std::vector<double> exact = priceGrid(checks, settings.threads);
+    for (std::size_t k = 0; k < checks.size(); ++k) {
+        const double approx = *surrogate.price(checks[k].flatRate, checks[k].strikeMultiplier);
+        surrogate.checkedError_ = std::max(surrogate.checkedError_, std::fabs(approx - exact[k]));
+    }
+    QL_REQUIRE(settings.tolerance <= 0.0 || surrogate.errorEstimate() <= settings.tolerance,
+               "surrogate error estimate " << surrogate.errorEstimate() << " (checked "
+               << surrogate.checkedError_ << ", tail " << surrogate.tailEstimate_
+               << ") above tolerance " << settings.tolerance
+               << " (add nodes or narrow the domain)");
+    return surrogate;
+}
+
+bool ChebyshevSurrogate::contains(double flatRate, double strikeMultiplier) const {
+    return flatRate >= settings_.minRate && flatRate <= settings_.maxRate &&
+           strikeMultiplier >= settings_.minMultiplier &&
+           strikeMultiplier <= settings_.maxMultiplier;
+}
+
+std::optional<double> ChebyshevSurrogate::price(double flatRate, double strikeMultiplier) const {
+    if (!contains(flatRate, strikeMultiplier))
+        return std::nullopt;
+    const std::size_t nr = settings_.rateNodes;
+    const std::size_t nm = settings_.multiplierNodes;
+    const double x = toUnit(flatRate, settings_.minRate, settings_.maxRate);
+    const double y = toUnit(strikeMultiplier, settings_.minMultiplier, settings_.maxMultiplier);
+
+    // Outer recurrence in the rate; each of its coefficients is an inner
+    // recurrence over one row of the table
+    const double* c = coefficients_.data();
+    double b1 = 0.0, b2 = 0.0;
+    for (std::size_t a = nr; a-- > 1;) {
+        const double b0 = clenshaw(c + a * nm, nm, y) + 2.0 * x * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return clenshaw(c, nm, y) + x * b1 - b2;
+}
+
+SurrogateCache::Key SurrogateCache::keyOf(const BermudanTrade& trade) {
+    const LsmcSettings& mc = trade.lsmc;
+    return Key(trade.evaluationDate, trade.model, trade.engine, trade.swap, trade.modelParams,
+               mc.calibrationPaths, mc.maxPaths, mc.tolerance, mc.blockSize, mc.seed,
+               trade.grid.tolerance, trade.grid.minSteps, trade.grid.maxSteps,
+               trade.grid.richardson);
+}
+
+std::shared_ptr<const ChebyshevSurrogate>
+SurrogateCache::build(const BermudanTrade& shape, const SurrogateSettings& settings) {
+    auto surrogate =
+        std::make_shared<const ChebyshevSurrogate>(ChebyshevSurrogate::build(shape, settings));
+    std::lock_guard<std::mutex> lock(mutex_);
+    surrogates_[keyOf(shape)] = surrogate;
+    return surrogate;
+}
+
+std::shared_ptr<const ChebyshevSurrogate> SurrogateCache::find(const BermudanTrade& trade) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surrogates_.find(keyOf(trade));
+    return it == surrogates_.end() ? nullptr : it->second;
+}
+
+std::optional<double> SurrogateCache::quote(const BermudanTrade& trade) {
+    std::optional<double> npv;
+    if (auto surrogate = find(trade))
+        npv = surrogate->price(trade.flatRate, trade.strikeMultiplier);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++(npv ? hits_ : fallbacks_);
+    return npv;
+}
+
+double SurrogateCache::price(const BermudanTrade& trade, bool* fromSurrogate) {
+    const std::optional<double> npv = quote(trade);
+    if (fromSurrogate)
+        *fromSurrogate = npv.has_value();
+    if (npv)
+        return *npv;
+    JobOptions options;
+    options.priority = JobPriority::Interactive;
+    return PricingService::shared().submit(trade, options).result.get();
+}
+
+std::size_t SurrogateCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return surrogates_.size();
+}
+
+void SurrogateCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    surrogates_.clear();
+    hits_ = 0;
+    fallbacks_ = 0;
+}
+
+std::uint64_t SurrogateCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+std::uint64_t SurrogateCache::fallbacks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fallbacks_;
+}
+
+SurrogateCache& SurrogateCache::shared() {
+    static SurrogateCache cache;
+    return cache;
+}
@@ -0,0 +1,145 @@
+#include "FittedLatticeCache.hpp"
+#include "Metrics.hpp"
+
+#include <ql/models/shortrate/onefactormodels/blackkarasinski.hpp>
+#include <ql/termstructures/yieldtermstructure.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/timegrid.hpp>
+#include <algorithm>
+
+using namespace QuantLib;
+
+namespace {
+
+    // The discount factors a fit read, on the grid times only. Not linked
+    // to any quote or to the evaluation date, so the tree fitted on it
+    // carries no observer of the caller's market.
+    class GridSnapshotCurve : public YieldTermStructure {
+    public:
+        GridSnapshotCurve(std::vector<Time> times, std::vector<DiscountFactor> discounts)
+            : YieldTermStructure(Date(), NullCalendar(), Actual365Fixed()),
+              times_(std::move(times)), discounts_(std::move(discounts)) {}
+
+        Date maxDate() const override { return Date::maxDate(); }
+        Time maxTime() const override { return times_.back(); }
+
+    private:
+        DiscountFactor discountImpl(Time t) const override {
+            auto it = std::lower_bound(times_.begin(), times_.end(), t);
+            QL_REQUIRE(it != times_.end() && *it == t,
+                       "t = " << t << " is not on the fitting grid");
+            return discounts_[static_cast<std::size_t>(it - times_.begin())];
+        }
+
+        std::vector<Time> times_;
+        std::vector<DiscountFactor> discounts_;
+    };
+
+}
+
+FittedLatticeCache::FittedLatticeCache(std::size_t capacity)
+    : capacity_(capacity) {
+    QL_REQUIRE(capacity_ > 0, "FittedLatticeCache capacity must be positive");
+}
+
+ext::shared_ptr<Lattice> FittedLatticeCache::tree(const BlackKarasinski& model,
+                                                  const TimeGrid& grid) {
+    const Array params = model.params();
+    QL_REQUIRE(params.size() == 2, "Black-Karasinski model expected (a, sigma)");
+    const Handle<YieldTermStructure>& curve = model.termStructure();
+    QL_REQUIRE(!curve.empty(), "no term structure set on the model");
+
+    std::vector<Time> times(grid.begin(), grid.end());
+    std::vector<DiscountFactor> discounts(times.size());
+    for (Size i = 0; i < times.size(); ++i)
+        discounts[i] = curve->discount(times[i]);
+
+    Key key;
+    key.reserve(2 + 2 * times.size());
+    key.insert(key.end(), params.begin(), params.end());
+    key.insert(key.end(), times.begin(), times.end());
+    key.insert(key.end(), discounts.begin(), discounts.end());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            ++hits_;
+            it->second.lastUse = ++clock_;
+            BERMUDAN_COUNT(Counter::LatticeCacheHits, 1);
+            return it->second.lattice;
+        }
+        ++misses_;
+    }
+
+    // Fitted outside the lock; two threads missing the same key both fit
+    // and the first insert wins
+    ext::shared_ptr<Lattice> lattice;
+    {
+        BERMUDAN_TIME_STAGE(Stage::LatticeBuild);
+        Handle<YieldTermStructure> snapshot(
+            ext::make_shared<GridSnapshotCurve>(std::move(times), std::move(discounts)));
+        lattice = BlackKarasinski(snapshot, params[0], params[1]).tree(grid);
+
+        // Completes the lazily built state prices, after which the tree is
+        // only read
+        auto shortRateTree = ext::dynamic_pointer_cast<OneFactorModel::ShortRateTree>(lattice);
+        QL_REQUIRE(shortRateTree, "unexpected Black-Karasinski lattice type");
+        shortRateTree->statePrices(grid.size() - 1);
+
+        BERMUDAN_COUNT(Counter::LatticeSteps, grid.size() - 1);
+#ifdef BERMUDAN_METRICS
+        Size nodes = 0;
+        for (Size i = 0; i < grid.size(); ++i)
+            nodes += shortRateTree->size(i);
+        BERMUDAN_COUNT(Counter::LatticeNodes, nodes);
+#endif
+    }
+
+    ext::shared_ptr<Lattice> evicted;   // released after the cache lock
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = entries_.try_emplace(std::move(key));
+    if (inserted) {
+        it->second.lattice = lattice;
+        if (entries_.size() > capacity_) {
+            auto oldest = entries_.end();
+            for (auto e = entries_.begin(); e != entries_.end(); ++e) {
+                if (e != it && (oldest == entries_.end() || e->second.lastUse < oldest->second.lastUse))
+                    oldest = e;
+            }
+            evicted = std::move(oldest->second.lattice);
+            entries_.erase(oldest);
+        }
+    }
+    it->second.lastUse = ++clock_;
+    return it->second.lattice;
+}
+
+std::size_t FittedLatticeCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void FittedLatticeCache::clear() {
+    std::map<Key, Entry> dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    dropped.swap(entries_);
+    hits_ = 0;
+    misses_ = 0;
+}
+
+std::uint64_t FittedLatticeCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+std::uint64_t FittedLatticeCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+FittedLatticeCache& FittedLatticeCache::shared() {
+    static FittedLatticeCache cache;
+    return cache;
+}
@@ -0,0 +1,357 @@
+#include "G2AdiSwaptionEngine.hpp"
+#include "Metrics.hpp"
+#include "PricingCancellation.hpp"
+#include "PricingWorkspace.hpp"
+#include "SwaptionCashflows.hpp"
+#include "ThreadPool.hpp"
+
+#include <ql/math/comparison.hpp>
+#include <ql/timegrid.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <optional>
+
+using namespace QuantLib;
+
+namespace {
+
+    constexpr Real kStdDevs = 5.0;
+    constexpr Size kColumnBlock = 16;     // y-sweep columns solved together
+    constexpr Size kDampingSteps = 2;     // fully implicit steps after the last exercise
+
+    // Nodes of one factor and its 1/2 s^2 d2/dx2 - k x d/dx stencil. At the
+    // edges the second derivative is dropped and the drift is upwinded.
+    struct Axis {
+        std::vector<Real> x, lower, diag, upper;
+        Real h = 0.0;
+
+        Size size() const { return x.size(); }
+    };
+
+    Axis makeAxis(Size n, Real halfWidth, Real sigma, Real k) {
+        n = std::max<Size>(n, 5) | 1;     // odd: the origin is a node
+        const Size centre = n / 2;
+        Axis axis;
+        axis.h = halfWidth / static_cast<Real>(centre);
+        axis.x.resize(n);
+        axis.lower.assign(n, 0.0);
+        axis.diag.assign(n, 0.0);
+        axis.upper.assign(n, 0.0);
+        const Real h = axis.h;
+        const Real diffusion = 0.5 * sigma * sigma / (h * h);
+        for (Size i = 0; i < n; ++i) {
+            axis.x[i] = (static_cast<Real>(i) - static_cast<Real>(centre)) * h;
+            const Real drift = -k * axis.x[i];
+            if (i == 0) {
+                axis.diag[i] = -drift / h;
+                axis.upper[i] = drift / h;
+            } else if (i == n - 1) {
+                axis.lower[i] = -drift / h;
+                axis.diag[i] = drift / h;
+            } else {
+                axis.lower[i] = diffusion - drift / (2.0 * h);
+                axis.diag[i] = -2.0 * diffusion;
+                axis.upper[i] = diffusion + drift / (2.0 * h);
+            }
+        }
+        return axis;
+    }
+
+    // Operator splitting of the G2 generator on the nx * ny mesh (x
+    // contiguous): A0 the correlation term, A1 / A2 the x / y stencils,
+    // each with half of the discounting -(x + y + phi).
+    class AdiSolver {
+    public:
+        AdiSolver(Axis x, Axis y, Real correlation, ThreadPool& pool)
+            : x_(std::move(x)), y_(std::move(y)), nx_(x_.size()), ny_(y_.size()),
+              mixed_(correlation / (4.0 * x_.h * y_.h)), pool_(pool),
+              v_(nx_ * ny_, 0.0), a0v_(v_), a1v_(v_), a2v_(v_), y0_(v_), work_(v_), z_(v_) {
+            const Size rows = std::max<Size>(1, 4 * pool_.size());
+            rowGrain_ = std::max<Size>(1, ny_ / rows);
+        }
+
+        std::vector<Real>& values() { return v_; }
+        Size nx() const { return nx_; }
+        Size ny() const { return ny_; }
+        const Axis& xAxis() const { return x_; }
+        const Axis& yAxis() const { return y_; }
+
+        template <class F>
+        void forRows(const F& body) {
+            pool_.parallelFor(ny_, [&](std::size_t j) { body(j); }, rowGrain_);
+        }
+
+        // One step back over dt with phi frozen at the step's midpoint.
+        // Douglas: Y0 = V + dt A V, (I - c A_k) Y_k = Y_{k-1} - c A_k V.
+        // Craig-Sneyd then corrects Y0 by dt / 2 A0 (Y2 - V) and repeats
+        // the two implicit sweeps.
+        void step(Real dt, Real phi, Real theta, bool craigSneyd) {
+            const Real c = theta * dt;
+            forRows([&](Size j) {
+                Real* a0 = row(a0v_, j);
+                Real* a1 = row(a1v_, j);
+                Real* a2 = row(a2v_, j);
+                applyMixed(j, v_.data(), a0);
+                applyX(j, v_.data(), a1, phi);
+                applyY(j, v_.data(), a2, phi);
+                const Real* v = row(v_, j);
+                Real* y0 = row(y0_, j);
+                Real* w = row(work_, j);
+                for (Size i = 0; i < nx_; ++i) {
+                    y0[i] = v[i] + dt * (a0[i] + a1[i] + a2[i]);
+                    w[i] = y0[i] - c * a1[i];
+                }
+            });
+            sweeps(work_, c, phi);
+            if (craigSneyd) {
+                forRows([&](Size j) {
+                    Real* z = row(z_, j);
+                    applyMixed(j, work_.data(), z);
+                    const Real* y0 = row(y0_, j);
+                    const Real* a0 = row(a0v_, j);
+                    const Real* a1 = row(a1v_, j);
+                    for (Size i = 0; i < nx_; ++i)
+                        z[i] = y0[i] + 0.5 * dt * (z[i] - a0[i]) - c * a1[i];
+                });
+                sweeps(z_, c, phi);
+                v_.swap(z_);
+            } else {
+                v_.swap(work_);
+            }
+        }
+
+    private:
+        Real* row(std::vector<Real>& f, Size j) { return f.data() + j * nx_; }
+        const Real* row(const std::vector<Real>& f, Size j) const { return f.data() + j * nx_; }
+
+        Real rate(Size i, Size j, Real phi) const { return x_.x[i] + y_.x[j] + phi; }
+
+        // field holds the x-sweep right-hand side and ends up as Y2
+        void sweeps(std::vector<Real>& field, Real c, Real phi) {
+            forRows([&](Size j) {
+                Real* f = row(field, j);
+                solveX(j, f, c, phi);
+                const Real* a2 = row(a2v_, j);
+                for (Size i = 0; i < nx_; ++i)
+                    f[i] -= c * a2[i];
+            });
+            const Size blocks = (nx_ + kColumnBlock - 1) / kColumnBlock;
+            pool_.parallelFor(blocks, [&](std::size_t b) {
+                const Size first = b * kColumnBlock;
+                solveY(first, std::min(kColumnBlock, nx_ - first), field.data(), c, phi);
+            });
+        }
+
+        void applyX(Size j, const Real* u, Real* out, Real phi) const {
+            const Real* r = u + j * nx_;
+            for (Size i = 0; i < nx_; ++i) {
+                Real value = (x_.diag[i] - 0.5 * rate(i, j, phi)) * r[i];
+                if (i > 0)
+                    value += x_.lower[i] * r[i - 1];
+                if (i + 1 < nx_)
+                    value += x_.upper[i] * r[i + 1];
+                out[i] = value;
+            }
+        }
+
+        void applyY(Size j, const Real* u, Real* out, Real phi) const {
+            const Real* r = u + j * nx_;
+            const Real* below = j > 0 ? r - nx_ : nullptr;
+            const Real* above = j + 1 < ny_ ? r + nx_ : nullptr;
+            for (Size i = 0; i < nx_; ++i) {
+                Real value = (y_.diag[j] - 0.5 * rate(i, j, phi)) * r[i];
+                if (below)
+                    value += y_.lower[j] * below[i];
+                if (above)
+                    value += y_.upper[j] * above[i];
+                out[i] = value;
+            }
+        }
+
+        // Central cross difference; zero on the mesh boundary
+        void applyMixed(Size j, const Real* u, Real* out) const {
+            std::fill_n(out, nx_, 0.0);
+            if (j == 0 || j + 1 == ny_)
+                return;
+            const Real* below = u + (j - 1) * nx_;
+            const Real* above = u + (j + 1) * nx_;
+            for (Size i = 1; i + 1 < nx_; ++i)
+                out[i] = mixed_ * (above[i + 1] - above[i - 1] - below[i + 1] + below[i - 1]);
+        }
+
+        // (I - c A1) u = f along row j, in place (Thomas)
+        void solveX(Size j, Real* f, Real c, Real phi) const {
+            PricingWorkspace& workspace = PricingWorkspace::local();
+            PricingWorkspace::Scope scope(workspace);
+            Real* cp = workspace.take<Real>(nx_).data();
+            for (Size i = 0; i < nx_; ++i) {
+                const Real a = i > 0 ? -c * x_.lower[i] : 0.0;
+                const Real b = 1.0 - c * (x_.diag[i] - 0.5 * rate(i, j, phi));
+                const Real m = i > 0 ? b - a * cp[i - 1] : b;
+                cp[i] = -c * x_.upper[i] / m;
+                f[i] = (i > 0 ? f[i] - a * f[i - 1] : f[i]) / m;
+            }
+            for (Size i = nx_ - 1; i-- > 0;)
+                f[i] -= cp[i] * f[i + 1];
+        }
+
+        // (I - c A2) u = f along columns [first, first + width), in place.
+        // The columns advance together so every row access is contiguous.
+        void solveY(Size first, Size width, Real* field, Real c, Real phi) const {
+            PricingWorkspace& workspace = PricingWorkspace::local();
+            PricingWorkspace::Scope scope(workspace);
+            Real* cp = workspace.take<Real>(ny_ * width).data();
+            for (Size j = 0; j < ny_; ++j) {
+                const Real a = j > 0 ? -c * y_.lower[j] : 0.0;
+                const Real upper = -c * y_.upper[j];
+                Real* f = field + j * nx_ + first;
+                const Real* fPrev = j > 0 ? f - nx_ : nullptr;
+                Real* cpRow = cp + j * width;
+                const Real* cpPrev = j > 0 ? cpRow - width : nullptr;
+                for (Size k = 0; k < width; ++k) {
+                    const Real b = 1.0 - c * (y_.diag[j] - 0.5 * rate(first + k, j, phi));
+                    const Real m = fPrev ? b - a * cpPrev[k] : b;
+                    cpRow[k] = upper / m;
+                    f[k] = (fPrev ? f[k] - a * fPrev[k] : f[k]) / m;
+                }
+            }
+            for (Size j = ny_ - 1; j-- > 0;) {
+                Real* f = field + j * nx_ + first;
+                const Real* fNext = f + nx_;
+                const Real* cpRow = cp + j * width;
+                for (Size k = 0; k < width; ++k)
+                    f[k] -= cpRow[k] * fNext[k];
+            }
+        }
+
+        Axis x_, y_;
+        Size nx_, ny_;
+        Real mixed_;
+        ThreadPool& pool_;
+        Size rowGrain_ = 1;
+        std::vector<Real> v_, a0v_, a1v_, a2v_, y0_, work_, z_;
+    };
+
+    // int_0^t exp(-k s) ds
+    Real integral(Real k, Time t) { return -std::expm1(-k * t) / k; }
+
+}
+
+G2AdiSwaptionEngine::G2AdiSwaptionEngine(const ext::shared_ptr<G2>& model, Size timeSteps,
+                                         Size xGrid, Size yGrid, Scheme scheme,
+                                         std::size_t threads)
+    : GenericModelEngine<G2, Swaption::arguments, Swaption::results>(model),
+      timeSteps_(timeSteps), xGrid_(xGrid), yGrid_(yGrid), scheme_(scheme), threads_(threads) {
+    QL_REQUIRE(timeSteps_ > 0, "timeSteps must be positive");
+    QL_REQUIRE(xGrid_ > 2 && yGrid_ > 2, "at least three space points per factor");
+}
+
+void G2AdiSwaptionEngine::calculate() const {
+    QL_REQUIRE(!model_.empty(), "no model specified");
+    QL_REQUIRE(arguments_.settlementType == Settlement::Physical,
+               "fdm-adi engine supports physically settled swaptions only");
+
+    const G2& model = *model_.currentLink();
+    const Handle<YieldTermStructure>& ts = model.termStructure();
+    const Date referenceDate = ts->referenceDate();
+    const DayCounter dayCounter = ts->dayCounter();
+    auto timeOf = [&](const Date& d) { return dayCounter.yearFraction(referenceDate, d); };
+
+    std::vector<Date> exerciseDates;
+    std::vector<Time> exerciseTimes;
+    for (const Date& d : arguments_.exercise->dates()) {
+        if (d < referenceDate)
+            continue;
+        exerciseDates.push_back(d);
+        exerciseTimes.push_back(timeOf(d));
+    }
+    QL_REQUIRE(!exerciseDates.empty(), "no exercise date left");
+    const std::vector<SwaptionCashflow> cashflows = swaptionCashflows(arguments_, referenceDate);
+
+    const Real a = model.a(), sigma = model.sigma(), b = model.b(), eta = model.eta();
+    const Real rho = model.rho();
+    const Time horizon = exerciseTimes.back();
+    auto halfWidth = [&](Real k, Real s) {
+        return kStdDevs * s * std::sqrt(std::max(integral(2.0 * k, horizon), 1e-4));
+    };
+
+    std::optional<ThreadPool> ownPool;
+    if (threads_ != 0)
+        ownPool.emplace(threads_);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    AdiSolver solver(makeAxis(xGrid_, halfWidth(a, sigma), sigma, a),
+                     makeAxis(yGrid_, halfWidth(b, eta), eta, b), rho * sigma * eta, pool);
+    const Size nx = solver.nx();
+    const Size ny = solver.ny();
+
+    // phi(t) = f(0, t) + the G2 convexity terms, as G2::FittingParameter
+    auto phi = [&](Time t) {
+        const Real x = sigma * integral(a, t);
+        const Real y = eta * integral(b, t);
+        return ts->forwardRate(t, t, Continuous, NoFrequency, true) +
+               0.5 * x * x + 0.5 * y * y + rho * x * y;
+    };
+
+    // Underlying at an exercise date: sum_m w_m P(t, T_m; x, y), separable
+    // as A(t, T_m) exp(-B_a x) exp(-B_b y)
+    std::vector<Real> weights, ex, ey;
+    auto exercise = [&](Size e) {
+        const Time t = exerciseTimes[e];
+        std::map<Time, Real> byMaturity;
+        for (const SwaptionCashflow& cf : cashflows) {
+            if (cf.resetDate < exerciseDates[e])
+                continue;
+            byMaturity[timeOf(cf.resetDate)] += cf.fixedPart;
+            byMaturity[timeOf(cf.payDate)] += cf.bondPart;
+        }
+        weights.clear();
+        ex.clear();
+        ey.clear();
+        for (const auto& [T, w] : byMaturity) {
+            if (w == 0.0)
+                continue;
+            const Time tau = std::max(T - t, 0.0);
+            weights.push_back(w * (close_enough(tau, 0.0) ? 1.0 : model.discountBond(t, T, 0.0, 0.0)));
+            for (Real x : solver.xAxis().x)
+                ex.push_back(std::exp(-integral(a, tau) * x));
+            for (Real y : solver.yAxis().x)
+                ey.push_back(std::exp(-integral(b, tau) * y));
+        }
+        std::vector<Real>& v = solver.values();
+        solver.forRows([&](Size j) {
+            Real* r = v.data() + j * nx;
+            for (Size i = 0; i < nx; ++i) {
+                Real underlying = 0.0;
+                for (Size m = 0; m < weights.size(); ++m)
+                    underlying += weights[m] * ex[m * nx + i] * ey[m * ny + j];
+                // std::max(underlying, option), as DiscretizedSwaption does
+                if (!(underlying < r[i]))
+                    r[i] = underlying;
+            }
+        });
+    };
+
+    const TimeGrid grid(exerciseTimes.begin(), exerciseTimes.end(), timeSteps_);
+    std::vector<std::ptrdiff_t> exerciseAt(grid.size(), -1);
+    for (Size e = 0; e < exerciseTimes.size(); ++e)
+        exerciseAt[grid.index(exerciseTimes[e])] = static_cast<std::ptrdiff_t>(e);
+
+    BERMUDAN_TIME_STAGE(Stage::Rollback);
+    const Size last = grid.size() - 1;
+    exercise(static_cast<Size>(exerciseAt[last]));
+    for (Size i = last; i-- > 0;) {
+        CancellationToken::checkpoint();
+        const Time dt = grid[i + 1] - grid[i];
+        const bool damping = last - i <= kDampingSteps;
+        solver.step(dt, phi(0.5 * (grid[i] + grid[i + 1])), damping ? 1.0 : 0.5,
+                    !damping && scheme_ == CraigSneyd);
+        if (exerciseAt[i] >= 0)
+            exercise(static_cast<Size>(exerciseAt[i]));
+    }
+
+    results_.value = solver.values()[(ny / 2) * nx + nx / 2];
+    results_.additionalResults["xGrid"] = nx;
+    results_.additionalResults["yGrid"] = ny;
+}
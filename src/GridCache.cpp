@@ -0,0 +1,62 @@
+#include "GridCache.hpp"
+
+#include <ql/errors.hpp>
+
+GridCache::GridCache(std::size_t capacity)
+    : capacity_(capacity) {
+    QL_REQUIRE(capacity_ > 0, "GridCache capacity must be positive");
+}
+
+std::optional<GridCache::Choice> GridCache::find(const Shape& shape) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = choices_.find(shape);
+    if (it == choices_.end()) {
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    it->second.lastUse = ++clock_;
+    return it->second.choice;
+}
+
+void GridCache::insert(const Shape& shape, const Choice& choice) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = choices_.try_emplace(shape);
+    if (inserted && choices_.size() > capacity_) {
+        auto oldest = choices_.end();
+        for (auto e = choices_.begin(); e != choices_.end(); ++e) {
+            if (e != it && (oldest == choices_.end() || e->second.lastUse < oldest->second.lastUse))
+                oldest = e;
+        }
+        choices_.erase(oldest);
+    }
+    it->second.choice = choice;
+    it->second.lastUse = ++clock_;
+}
+
+std::size_t GridCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return choices_.size();
+}
+
+void GridCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    choices_.clear();
+    hits_ = 0;
+    misses_ = 0;
+}
+
+std::uint64_t GridCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+std::uint64_t GridCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+GridCache& GridCache::shared() {
+    static GridCache cache;
+    return cache;
+}
@@ -0,0 +1,60 @@
+#include "GridDiscountCurve.hpp"
+
+#include <algorithm>
+
+using namespace QuantLib;
+
+GridDiscountCurve::GridDiscountCurve(const Handle<YieldTermStructure>& curve)
+    : YieldTermStructure(curve->dayCounter()),
+      curve_(curve) {
+    if (curve_->allowsExtrapolation())
+        enableExtrapolation();
+    registerWith(curve_);
+}
+
+void GridDiscountCurve::cacheTimes(const std::vector<Time>& times) {
+    std::vector<Time> merged;
+    merged.reserve(times_.size() + times.size());
+    for (Time t : times)
+        if (t >= 0.0)
+            merged.push_back(t);
+    std::sort(merged.begin(), merged.end());
+    const std::size_t added = merged.size();
+    merged.insert(merged.end(), times_.begin(), times_.end());
+    std::inplace_merge(merged.begin(), merged.begin() + added, merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    if (merged == times_)
+        return;
+
+    times_.swap(merged);
+    // Values at the old times are unchanged: refill without notifying
+    calculated_ = false;
+    calculate();
+}
+
+void GridDiscountCurve::update() {
+    LazyObject::update();
+}
+
+const std::vector<DiscountFactor>& GridDiscountCurve::discounts() const {
+    calculate();
+    return discounts_;
+}
+
+DiscountFactor GridDiscountCurve::discountImpl(Time t) const {
+    calculate();
+    const auto it = std::lower_bound(times_.begin(), times_.end(), t);
+    if (it != times_.end() && *it == t) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return discounts_[it - times_.begin()];
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return curve_->discount(t, true);
+}
+
+void GridDiscountCurve::performCalculations() const {
+    const std::size_t n = times_.size();
+    discounts_.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+        discounts_[i] = curve_->discount(times_[i], true);
+}
@@ -0,0 +1,73 @@
+#include "HullWhiteSimdSwaptionEngine.hpp"
+#include "HullWhiteSoaLattice.hpp"
+#include "Metrics.hpp"
+#include "PricingCancellation.hpp"
+#include "PricingWorkspace.hpp"
+
+#include <ql/pricingengines/swaption/discretizedswaption.hpp>
+#include <algorithm>
+
+using namespace QuantLib;
+
+HullWhiteSimdSwaptionEngine::HullWhiteSimdSwaptionEngine(
+    const ext::shared_ptr<HullWhite>& model, Size timeSteps)
+    : GenericModelEngine<HullWhite, Swaption::arguments, Swaption::results>(model),
+      timeSteps_(timeSteps) {
+    QL_REQUIRE(timeSteps_ > 0, "timeSteps must be positive");
+}
+
+HullWhiteSimdSwaptionEngine::HullWhiteSimdSwaptionEngine(
+    const ext::shared_ptr<HullWhite>& model, const TimeGrid& grid)
+    : GenericModelEngine<HullWhite, Swaption::arguments, Swaption::results>(model),
+      timeSteps_(0),
+      grid_(grid) {}
+
+void HullWhiteSimdSwaptionEngine::update() {
+    lattice_.reset();
+    GenericModelEngine<HullWhite, Swaption::arguments, Swaption::results>::update();
+}
+
+void HullWhiteSimdSwaptionEngine::calculate() const {
+    QL_REQUIRE(!model_.empty(), "no model specified");
+
+    const Handle<YieldTermStructure>& ts = model_->termStructure();
+    const Date referenceDate = ts->referenceDate();
+    const DayCounter dayCounter = ts->dayCounter();
+
+    ext::shared_ptr<HullWhiteSoaLattice> lattice;
+    if (!grid_.empty()) {
+        if (!lattice_)
+            lattice_ = HullWhiteSoaLattice::build(*model_.currentLink(), grid_);
+        lattice = lattice_;
+    } else {
+        DiscretizedSwaption swaption(arguments_, referenceDate, dayCounter);
+        std::vector<Time> times = swaption.mandatoryTimes();
+        lattice = HullWhiteSoaLattice::build(*model_.currentLink(),
+                                             TimeGrid(times.begin(), times.end(), timeSteps_));
+    }
+
+    swaptionCashflows(arguments_, referenceDate, cashflows_);
+    if (lattice->locate(cashflows_, arguments_.exercise->dates(), referenceDate, dayCounter,
+                        bermudan_)) {
+        BERMUDAN_TIME_STAGE(Stage::Rollback);
+        results_.value = lattice->value(bermudan_, PricingWorkspace::local());
+        return;
+    }
+
+    // A fixed grid missing some dates: DiscretizedSwaption copes with that
+    DiscretizedSwaption swaption(arguments_, referenceDate, dayCounter);
+
+    // Stopping logic mirrors TreeSwaptionEngine::calculate()
+    std::vector<Time> stoppingTimes(arguments_.exercise->dates().size());
+    for (Size i = 0; i < stoppingTimes.size(); ++i)
+        stoppingTimes[i] = dayCounter.yearFraction(referenceDate, arguments_.exercise->date(i));
+
+    const auto nextExercise = std::find_if(stoppingTimes.begin(), stoppingTimes.end(),
+                                           [](Time t) { return t >= 0.0; });
+    QL_REQUIRE(nextExercise != stoppingTimes.end(), "no exercise date left");
+
+    BERMUDAN_TIME_STAGE(Stage::Rollback);
+    swaption.initialize(lattice, stoppingTimes.back());
+    rollbackWithCheckpoints(swaption, *nextExercise);
+    results_.value = swaption.presentValue();
+}
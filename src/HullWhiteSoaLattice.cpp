@@ -0,0 +1,339 @@
+#include "HullWhiteSoaLattice.hpp"
+#include "Metrics.hpp"
+#include "PricingCancellation.hpp"
+#include "PricingWorkspace.hpp"
+
+#include <ql/discretizedasset.hpp>
+#include <ql/math/comparison.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BERMUDAN_X86_DISPATCH 1
+#endif
+
+using namespace QuantLib;
+
+namespace {
+
+    // out[j] = disc[j] * sum_l p_l[j] * v[base[j] + l], same summation order
+    // as TreeLattice::stepback.
+    using StepKernel = void (*)(std::size_t n, const double* v, const std::int32_t* base,
+                                const double* p0, const double* p1, const double* p2,
+                                const double* disc, double* out);
+
+    void stepScalar(std::size_t n, const double* v, const std::int32_t* base,
+                    const double* p0, const double* p1, const double* p2,
+                    const double* disc, double* out) {
+        for (std::size_t j = 0; j < n; ++j) {
+            const double* d = v + base[j];
+            double value = p0[j] * d[0];
+            value += p1[j] * d[1];
+            value += p2[j] * d[2];
+            out[j] = value * disc[j];
+        }
+    }
+
+#if defined(BERMUDAN_X86_DISPATCH)
+    __attribute__((target("avx2")))
+    void stepAvx2(std::size_t n, const double* v, const std::int32_t* base,
+                  const double* p0, const double* p1, const double* p2,
+                  const double* disc, double* out) {
+        // masked gathers with an explicit zero source keep GCC's
+        // -Wmaybe-uninitialized quiet about the unmasked intrinsic
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        std::size_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            const __m128i idx = _mm_load_si128(reinterpret_cast<const __m128i*>(base + j));
+            const __m256d v0 = _mm256_mask_i32gather_pd(zero, v, idx, all, 8);
+            const __m256d v1 = _mm256_mask_i32gather_pd(zero, v + 1, idx, all, 8);
+            const __m256d v2 = _mm256_mask_i32gather_pd(zero, v + 2, idx, all, 8);
+            __m256d acc = _mm256_mul_pd(_mm256_load_pd(p0 + j), v0);
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_load_pd(p1 + j), v1));
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_load_pd(p2 + j), v2));
+            _mm256_storeu_pd(out + j, _mm256_mul_pd(acc, _mm256_load_pd(disc + j)));
+        }
+        stepScalar(n - j, v, base + j, p0 + j, p1 + j, p2 + j, disc + j, out + j);
+    }
+
+    __attribute__((target("avx512f")))
+    void stepAvx512(std::size_t n, const double* v, const std::int32_t* base,
+                    const double* p0, const double* p1, const double* p2,
+                    const double* disc, double* out) {
+        const __m512d zero = _mm512_setzero_pd();
+        std::size_t j = 0;
+        for (; j + 8 <= n; j += 8) {
+            const __m256i idx = _mm256_load_si256(reinterpret_cast<const __m256i*>(base + j));
+            const __m512d v0 = _mm512_mask_i32gather_pd(zero, 0xFF, idx, v, 8);
+            const __m512d v1 = _mm512_mask_i32gather_pd(zero, 0xFF, idx, v + 1, 8);
+            const __m512d v2 = _mm512_mask_i32gather_pd(zero, 0xFF, idx, v + 2, 8);
+            __m512d acc = _mm512_mul_pd(_mm512_load_pd(p0 + j), v0);
+            acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_load_pd(p1 + j), v1));
+            acc = _mm512_add_pd(acc, _mm512_mul_pd(_mm512_load_pd(p2 + j), v2));
+            _mm512_storeu_pd(out + j, _mm512_mul_pd(acc, _mm512_load_pd(disc + j)));
+        }
+        stepScalar(n - j, v, base + j, p0 + j, p1 + j, p2 + j, disc + j, out + j);
+    }
+#endif
+
+    struct KernelChoice {
+        StepKernel fn;
+        const char* name;
+    };
+
+    KernelChoice selectKernel() {
+#if defined(BERMUDAN_X86_DISPATCH)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return {stepAvx512, "avx512"};
+        if (__builtin_cpu_supports("avx2"))
+            return {stepAvx2, "avx2"};
+#endif
+        return {stepScalar, "scalar"};
+    }
+
+    const KernelChoice& kernel() {
+        static const KernelChoice choice = selectKernel();
+        return choice;
+    }
+
+}
+
+HullWhiteSoaLattice::HullWhiteSoaLattice(
+    const ext::shared_ptr<OneFactorModel::ShortRateTree>& tree)
+    : TreeLattice1D<HullWhiteSoaLattice>(tree->timeGrid(), 3),
+      source_(tree) {
+    const Size nSteps = tree->timeGrid().size() - 1;
+
+    sizes_.resize(nSteps + 1);
+    for (Size i = 0; i <= nSteps; ++i)
+        sizes_[i] = tree->size(i);
+
+    steps_.resize(nSteps);
+    for (Size i = 0; i < nSteps; ++i) {
+        Step& s = steps_[i];
+        const Size n = sizes_[i];
+        s.discount.resize(n);
+        s.base.resize(n);
+        for (auto& p : s.prob)
+            p.resize(n);
+
+        for (Size j = 0; j < n; ++j) {
+            const Size d0 = tree->descendant(i, j, 0);
+            QL_REQUIRE(tree->descendant(i, j, 1) == d0 + 1 &&
+                       tree->descendant(i, j, 2) == d0 + 2,
+                       "non-adjacent trinomial branches at step " << i);
+            s.base[j] = static_cast<std::int32_t>(d0);
+            s.discount[j] = tree->discount(i, j);
+            for (Size l = 0; l < 3; ++l)
+                s.prob[l][j] = tree->probability(i, j, l);
+        }
+    }
+}
+
+ext::shared_ptr<HullWhiteSoaLattice>
+HullWhiteSoaLattice::build(const HullWhite& model, const TimeGrid& grid) {
+    BERMUDAN_TIME_STAGE(Stage::LatticeBuild);
+    auto tree = ext::dynamic_pointer_cast<OneFactorModel::ShortRateTree>(model.tree(grid));
+    QL_REQUIRE(tree, "HullWhite::tree() did not return a short-rate tree");
+    auto lattice = ext::make_shared<HullWhiteSoaLattice>(tree);
+#ifdef BERMUDAN_METRICS
+    Size nodes = 0;
+    for (Size n : lattice->sizes_)
+        nodes += n;
+    BERMUDAN_COUNT(Counter::LatticeNodes, nodes);
+    BERMUDAN_COUNT(Counter::LatticeSteps, grid.size() - 1);
+#endif
+    return lattice;
+}
+
+void HullWhiteSoaLattice::stepback(Size i, const Array& values, Array& newValues) const {
+    stepback(i, values.begin(), newValues.begin());
+}
+
+void HullWhiteSoaLattice::stepback(Size i, const double* values, double* newValues) const {
+    const Step& s = steps_[i];
+    kernel().fn(sizes_[i], values, s.base.data(),
+                s.prob[0].data(), s.prob[1].data(), s.prob[2].data(),
+                s.discount.data(), newValues);
+}
+
+void HullWhiteSoaLattice::partialRollback(DiscretizedAsset& asset, Time to) const {
+    const Time from = asset.time();
+    if (close(from, to))
+        return;
+    QL_REQUIRE(from > to,
+               "cannot roll the asset back to " << to
+               << " (it is already at t = " << from << ")");
+
+    const Integer iFrom = Integer(timeGrid().index(from));
+    const Integer iTo = Integer(timeGrid().index(to));
+
+    // Steps go through workspace scratch; the asset's array is only
+    // replaced where the tree narrows
+    PricingWorkspace& workspace = PricingWorkspace::local();
+    PricingWorkspace::Scope scope(workspace);
+    const Size width = *std::max_element(sizes_.begin() + iTo, sizes_.begin() + iFrom);
+    double* scratch = workspace.take<double>(width).data();
+    for (Integer i = iFrom - 1; i >= iTo; --i) {
+        const Size n = sizes_[Size(i)];
+        stepback(Size(i), asset.values().begin(), scratch);
+        asset.time() = timeGrid()[i];
+        Array& values = asset.values();
+        if (values.size() == n)
+            std::copy(scratch, scratch + n, values.begin());
+        else
+            values = Array(scratch, scratch + n);
+        // skip the very last adjustment, as TreeLattice does
+        if (i != iTo)
+            asset.adjustValues();
+    }
+}
+
+void HullWhiteSoaLattice::rollback(DiscretizedAsset& asset, Time to) const {
+    partialRollback(asset, to);
+    asset.adjustValues();
+}
+
+bool HullWhiteSoaLattice::locate(const std::vector<SwaptionCashflow>& cashflows,
+                                 const std::vector<Date>& exerciseDates,
+                                 const Date& referenceDate, const DayCounter& dayCounter,
+                                 Bermudan& bermudan) const {
+    const TimeGrid& grid = timeGrid();
+    auto indexOf = [&](const Date& d, Size& index) {
+        const Time t = dayCounter.yearFraction(referenceDate, d);
+        index = grid.closestIndex(t);
+        return close_enough(grid[index], t);
+    };
+
+    bermudan.coupons.clear();
+    bermudan.exercises.clear();
+    for (const Date& d : exerciseDates) {
+        if (d < referenceDate)
+            continue;
+        Size i;
+        if (!indexOf(d, i))
+            return false;
+        bermudan.exercises.push_back(i);
+    }
+    if (bermudan.exercises.empty())
+        return false;
+    std::sort(bermudan.exercises.begin(), bermudan.exercises.end());
+    bermudan.exercises.erase(std::unique(bermudan.exercises.begin(), bermudan.exercises.end()),
+                             bermudan.exercises.end());
+
+    for (const SwaptionCashflow& cf : cashflows) {
+        Size reset, pay;
+        if (!indexOf(cf.resetDate, reset) || !indexOf(cf.payDate, pay) || pay <= reset)
+            return false;
+        bermudan.coupons.push_back({reset, pay, cf.fixedPart, cf.bondPart});
+    }
+    // Stable insertion sort by reset (std::stable_sort may allocate)
+    auto& coupons = bermudan.coupons;
+    for (Size k = 1; k < coupons.size(); ++k)
+        for (Size m = k; m > 0 && coupons[m].reset < coupons[m - 1].reset; --m)
+            std::swap(coupons[m], coupons[m - 1]);
+    return true;
+}
+
+Real HullWhiteSoaLattice::value(const Bermudan& bermudan, PricingWorkspace& workspace) const {
+    const auto& coupons = bermudan.coupons;
+    const auto& exercises = bermudan.exercises;
+    QL_REQUIRE(!exercises.empty(), "no exercise date left");
+    const Size first = exercises.front();
+    const Size lastExercise = exercises.back();
+
+    // Slot 0: underlying, slot 1: option, then one per distinct reset step
+    // holding the bond parts rolled back from the payment steps
+    Size last = lastExercise;
+    Size slots = 2;
+    for (Size k = 0; k < coupons.size(); ++k) {
+        last = std::max(last, coupons[k].pay);
+        if (k == 0 || coupons[k].reset != coupons[k - 1].reset)
+            ++slots;
+    }
+    QL_REQUIRE(last < sizes_.size(), "cashflow beyond the lattice");
+
+    PricingWorkspace::Scope scope(workspace);
+    const Size width = *std::max_element(sizes_.begin() + first, sizes_.begin() + last + 1);
+    double* buffers = workspace.take<double>((slots + 1) * width).data();
+    std::span<double*> value = workspace.take<double*>(slots);
+    std::span<unsigned char> active = workspace.take<unsigned char>(slots);
+    for (Size s = 0; s < slots; ++s) {
+        value[s] = buffers + s * width;
+        active[s] = 0;
+    }
+    double* scratch = buffers + slots * width;
+
+    const Size U = 0, V = 1;
+    std::fill_n(value[U], sizes_[last], 0.0);
+    active[U] = 1;
+    Size nextExercise = exercises.size();    // exercises[nextExercise - 1] is the next one back
+    for (Size i = last;; --i) {
+        const Size n = sizes_[i];
+        if (i < last) {
+            CancellationToken::checkpoint();
+            for (Size s = 0; s < slots; ++s) {
+                if (!active[s])
+                    continue;
+                stepback(i, value[s], scratch);
+                std::swap(value[s], scratch);
+            }
+        }
+
+        Size slot = 1;
+        for (Size k = 0; k < coupons.size(); ++k) {
+            if (k == 0 || coupons[k].reset != coupons[k - 1].reset)
+                ++slot;
+            if (coupons[k].pay != i)
+                continue;
+            double* bond = value[slot];
+            if (!active[slot]) {
+                std::fill_n(bond, n, 0.0);
+                active[slot] = 1;
+            }
+            for (Size j = 0; j < n; ++j)
+                bond[j] += coupons[k].bondPart;
+        }
+
+        slot = 2;
+        for (Size k = 0; k < coupons.size(); ++slot) {
+            const Size reset = coupons[k].reset;
+            Real fixedPart = 0.0;
+            for (; k < coupons.size() && coupons[k].reset == reset; ++k)
+                fixedPart += coupons[k].fixedPart;
+            if (reset != i)
+                continue;
+            const double* bond = value[slot];
+            for (Size j = 0; j < n; ++j)
+                value[U][j] += bond[j] + fixedPart;
+            active[slot] = 0;
+        }
+
+        if (i == lastExercise) {
+            std::fill_n(value[V], n, 0.0);
+            active[V] = 1;
+        }
+        if (nextExercise > 0 && exercises[nextExercise - 1] == i) {
+            --nextExercise;
+            // std::max(underlying, option), as DiscretizedSwaption does
+            for (Size j = 0; j < n; ++j)
+                if (!(value[U][j] < value[V][j]))
+                    value[V][j] = value[U][j];
+        }
+        if (i == first)
+            break;
+    }
+
+    const Array& prices = statePrices(first);
+    Real npv = 0.0;
+    for (Size j = 0; j < sizes_[first]; ++j)
+        npv += value[V][j] * prices[j];
+    return npv;
+}
+
+const char* HullWhiteSoaLattice::kernelName() {
+    return kernel().name;
+}
@@ -0,0 +1,250 @@
+#include "HullWhiteTreeAdjoint.hpp"
+
+#include <ql/errors.hpp>
+#include <algorithm>
+
+namespace {
+    constexpr std::size_t kNone = static_cast<std::size_t>(-1);
+}
+
+HullWhiteTreeAdjoint::HullWhiteTreeAdjoint(std::vector<Step> steps,
+                                           std::vector<std::size_t> sizes)
+    : steps_(std::move(steps)), sizes_(std::move(sizes)) {
+    QL_REQUIRE(sizes_.size() == steps_.size() + 1, "tree needs one size per grid point");
+    QL_REQUIRE(!sizes_.empty() && sizes_[0] == 1, "tree must start from a single node");
+    for (std::size_t i = 0; i < steps_.size(); ++i) {
+        const Step& s = steps_[i];
+        QL_REQUIRE(s.growth.size() == sizes_[i] && s.base.size() == sizes_[i] &&
+                   s.prob[0].size() == sizes_[i] && s.prob[1].size() == sizes_[i] &&
+                   s.prob[2].size() == sizes_[i],
+                   "tree step arrays do not match the node count");
+    }
+}
+
+void HullWhiteTreeAdjoint::rollback(std::size_t i, const Values& next,
+                                    Values& continuation, Values& out) const {
+    const Step& s = steps_[i];
+    const std::size_t n = sizes_[i];
+    continuation.resize(n);
+    out.resize(n);
+    for (std::size_t j = 0; j < n; ++j) {
+        const double* d = next.data() + s.base[j];
+        double value = s.prob[0][j] * d[0];
+        value += s.prob[1][j] * d[1];
+        value += s.prob[2][j] * d[2];
+        continuation[j] = value;
+        out[j] = value * discount_[i][j];
+    }
+}
+
+void HullWhiteTreeAdjoint::rollbackAdjoint(std::size_t i, const Values& adjoint,
+                                           Values& nextAdjoint) const {
+    const Step& s = steps_[i];
+    nextAdjoint.assign(sizes_[i + 1], 0.0);
+    for (std::size_t j = 0; j < sizes_[i]; ++j) {
+        const double a = adjoint[j] * discount_[i][j];
+        double* d = nextAdjoint.data() + s.base[j];
+        d[0] += s.prob[0][j] * a;
+        d[1] += s.prob[1][j] * a;
+        d[2] += s.prob[2][j] * a;
+    }
+}
+
+double HullWhiteTreeAdjoint::calculate(const std::vector<double>& discounts,
+                                       const std::vector<Cashflow>& cashflows,
+                                       const std::vector<std::size_t>& exerciseIndices,
+                                       std::size_t valuationIndex) {
+    const std::size_t nSteps = steps_.size();
+    QL_REQUIRE(discounts.size() == nSteps + 1, "one discount factor per grid point required");
+    QL_REQUIRE(!exerciseIndices.empty(), "no exercise dates");
+
+    // Cashflows resetting before the valuation index never reach the option
+    std::size_t last = valuationIndex;
+    std::size_t lastExercise = 0;
+    std::vector<char> isExercise(nSteps + 1, 0);
+    for (std::size_t e : exerciseIndices) {
+        QL_REQUIRE(e >= valuationIndex && e <= nSteps, "exercise index outside the tree");
+        isExercise[e] = 1;
+        lastExercise = std::max(lastExercise, e);
+    }
+    last = std::max(last, lastExercise);
+
+    // Slot 0: underlying swap, slot 1: option, then one pending-bond slot per
+    // reset index, holding sum(bondPart) rolled back from the payment dates.
+    std::vector<std::size_t> slotOfReset(nSteps + 1, kNone);
+    std::vector<double> fixedAtReset(nSteps + 1, 0.0);
+    std::vector<std::vector<const Cashflow*>> paysAt(nSteps + 1);
+    std::vector<std::size_t> createdAt(2, kNone);
+    std::size_t nSlots = 2;
+    for (const Cashflow& cf : cashflows) {
+        QL_REQUIRE(cf.payIndex > cf.resetIndex && cf.payIndex <= nSteps,
+                   "cashflow must pay after it resets, inside the tree");
+        if (cf.resetIndex < valuationIndex)
+            continue;
+        if (slotOfReset[cf.resetIndex] == kNone) {
+            slotOfReset[cf.resetIndex] = nSlots++;
+            createdAt.push_back(0);
+        }
+        const std::size_t s = slotOfReset[cf.resetIndex];
+        createdAt[s] = std::max(createdAt[s], cf.payIndex);
+        fixedAtReset[cf.resetIndex] += cf.fixedPart;
+        paysAt[cf.payIndex].push_back(&cf);
+        last = std::max(last, cf.payIndex);
+    }
+    const std::size_t U = 0, V = 1;
+
+    // Forward sweep: fit the drift so the tree reprices every P(0, t_{i+1})
+    std::vector<Values> Q(last + 1);
+    std::vector<double> S(last);
+    discount_.assign(last, Values());
+    Q[0] = Values(1, 1.0);
+    for (std::size_t i = 0; i < last; ++i) {
+        const Step& s = steps_[i];
+        double sum = 0.0;
+        for (std::size_t j = 0; j < sizes_[i]; ++j)
+            sum += Q[i][j] * s.growth[j];
+        S[i] = sum;
+
+        const double scale = discounts[i + 1] / sum;
+        discount_[i].resize(sizes_[i]);
+        Q[i + 1].assign(sizes_[i + 1], 0.0);
+        for (std::size_t j = 0; j < sizes_[i]; ++j) {
+            const double d = s.growth[j] * scale;
+            discount_[i][j] = d;
+            const double q = Q[i][j] * d;
+            double* next = Q[i + 1].data() + s.base[j];
+            next[0] += q * s.prob[0][j];
+            next[1] += q * s.prob[1][j];
+            next[2] += q * s.prob[2][j];
+        }
+    }
+
+    // Backward induction, keeping continuation values and exercise flags
+    std::vector<Values> value(nSlots);
+    std::vector<char> active(nSlots, 0);
+    std::vector<std::vector<Values>> continuation(last);
+    std::vector<std::vector<char>> exercised(last + 1);
+
+    value[U].assign(sizes_[last], 0.0);
+    active[U] = 1;
+    for (std::size_t i = last;; --i) {
+        if (i < last) {
+            continuation[i].resize(nSlots);
+            for (std::size_t s = 0; s < nSlots; ++s) {
+                if (!active[s])
+                    continue;
+                Values out;
+                rollback(i, value[s], continuation[i][s], out);
+                value[s].swap(out);
+            }
+        }
+        for (const Cashflow* cf : paysAt[i]) {
+            const std::size_t s = slotOfReset[cf->resetIndex];
+            if (!active[s]) {
+                value[s].assign(sizes_[i], 0.0);
+                active[s] = 1;
+            }
+            for (double& v : value[s])
+                v += cf->bondPart;
+        }
+        if (slotOfReset[i] != kNone) {
+            const std::size_t s = slotOfReset[i];
+            for (std::size_t j = 0; j < sizes_[i]; ++j)
+                value[U][j] += value[s][j] + fixedAtReset[i];
+            active[s] = 0;
+            Values().swap(value[s]);
+        }
+        if (i == lastExercise) {
+            value[V].assign(sizes_[i], 0.0);
+            active[V] = 1;
+        }
+        if (isExercise[i]) {
+            exercised[i].resize(sizes_[i]);
+            for (std::size_t j = 0; j < sizes_[i]; ++j) {
+                // std::max(underlying, option), as DiscretizedSwaption does
+                const bool ex = !(value[U][j] < value[V][j]);
+                exercised[i][j] = ex;
+                if (ex)
+                    value[V][j] = value[U][j];
+            }
+        }
+        if (i == valuationIndex)
+            break;
+    }
+
+    const std::size_t m = valuationIndex;
+    const Values optionAtValuation = value[V];
+    double npv = 0.0;
+    for (std::size_t j = 0; j < sizes_[m]; ++j)
+        npv += Q[m][j] * optionAtValuation[j];
+
+    // Reverse of the backward induction: adjoints of the node discounts
+    std::vector<Values> discountBar(last);
+    std::vector<Values> adjoint(nSlots);
+    adjoint[U].assign(sizes_[m], 0.0);
+    adjoint[V] = Q[m];
+    for (std::size_t i = m; i <= last; ++i) {
+        if (isExercise[i]) {
+            for (std::size_t j = 0; j < sizes_[i]; ++j) {
+                if (exercised[i][j]) {
+                    adjoint[U][j] += adjoint[V][j];
+                    adjoint[V][j] = 0.0;
+                }
+            }
+        }
+        if (i == lastExercise)
+            Values().swap(adjoint[V]);
+        if (slotOfReset[i] != kNone)
+            adjoint[slotOfReset[i]] = adjoint[U];
+        for (const Cashflow* cf : paysAt[i]) {
+            const std::size_t s = slotOfReset[cf->resetIndex];
+            if (createdAt[s] == i)
+                Values().swap(adjoint[s]);
+        }
+        if (i == last)
+            break;
+
+        discountBar[i].assign(sizes_[i], 0.0);
+        for (std::size_t s = 0; s < nSlots; ++s) {
+            const Values& c = continuation[i][s];
+            if (c.empty())
+                continue;
+            if (adjoint[s].empty())
+                adjoint[s].assign(sizes_[i], 0.0);
+            for (std::size_t j = 0; j < sizes_[i]; ++j)
+                discountBar[i][j] += adjoint[s][j] * c[j];
+            Values next;
+            rollbackAdjoint(i, adjoint[s], next);
+            adjoint[s].swap(next);
+        }
+    }
+
+    // Reverse of the fitting sweep: D_ij = g_ij P_{i+1} / S_i
+    sensitivities_.assign(nSteps + 1, 0.0);
+    Values qBarNext = (m == last) ? optionAtValuation : Values(sizes_[last], 0.0);
+    for (std::size_t i = last; i-- > 0;) {
+        const Step& s = steps_[i];
+        Values qBar(sizes_[i], 0.0);
+        if (i == m)
+            qBar = optionAtValuation;
+
+        double logPBar = 0.0;
+        for (std::size_t j = 0; j < sizes_[i]; ++j) {
+            const double* d = qBarNext.data() + s.base[j];
+            const double e = s.prob[0][j] * d[0] + s.prob[1][j] * d[1] + s.prob[2][j] * d[2];
+            double dBar = Q[i][j] * e;
+            if (!discountBar[i].empty())
+                dBar += discountBar[i][j];
+            qBar[j] += discount_[i][j] * e;
+            logPBar += dBar * discount_[i][j];
+        }
+        sensitivities_[i + 1] = logPBar;
+
+        const double sBar = -logPBar / S[i];
+        for (std::size_t j = 0; j < sizes_[i]; ++j)
+            qBar[j] += sBar * s.growth[j];
+        qBarNext.swap(qBar);
+    }
+
+    return npv;
+}
@@ -0,0 +1,423 @@
+#include "LsmcSwaptionEngine.hpp"
+#include "AlignedAllocator.hpp"
+#include "Philox.hpp"
+#include "SwaptionCashflows.hpp"
+#include "ThreadPool.hpp"
+
+#include <ql/math/matrixutilities/choleskydecomposition.hpp>
+#include <ql/math/matrixutilities/svd.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/models/shortrate/twofactormodels/g2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <optional>
+
+using namespace QuantLib;
+
+namespace {
+
+    using Values = AlignedVector<Real>;
+
+    // Pricing blocks are run in rounds of this many, so the tolerance check
+    // (and hence the path count) does not depend on the thread count.
+    constexpr Size kRoundBlocks = 8;
+    // Regression basis: 1, u, u^2, u^3 in the underlying u = U / nominal,
+    // then the raw factors.
+    constexpr Size kPolynomialOrder = 3;
+
+    // r(t) = phi(t) + sum_i x_i(t), dx_i = -k_i x_i dt + sigma_i dW_i,
+    // d<W_i, W_j> = rho_ij dt, x_i(0) = 0, phi fitted to the curve.
+    // HullWhite is the one-factor case, G2 the two-factor one.
+    struct GaussianFactors {
+        std::vector<Real> k, sigma;
+        Matrix rho;
+
+        Size size() const { return k.size(); }
+
+        // int_0^t exp(-k s) ds
+        static Real E(Real k, Time t) { return -std::expm1(-k * t) / k; }
+
+        Real covariance(Size i, Size j) const { return rho[i][j] * sigma[i] * sigma[j]; }
+
+        // Var(int_0^tau sum_i x_i(s) ds) starting from x = 0
+        Real V(Time tau) const {
+            Real v = 0.0;
+            for (Size i = 0; i < size(); ++i)
+                for (Size j = 0; j < size(); ++j)
+                    v += covariance(i, j) / (k[i] * k[j]) *
+                         (tau - E(k[i], tau) - E(k[j], tau) + E(k[i] + k[j], tau));
+            return v;
+        }
+
+        // Covariance of (x_1, I_1, x_2, I_2, ...) accumulated over dt, where
+        // I_i = int x_i ds over the step: the exact transition.
+        Matrix stepCovariance(Time dt) const {
+            const Size n = size();
+            Matrix c(2 * n, 2 * n);
+            for (Size i = 0; i < n; ++i) {
+                for (Size j = 0; j < n; ++j) {
+                    const Real cij = covariance(i, j);
+                    const Real ei = E(k[i], dt), ej = E(k[j], dt), eij = E(k[i] + k[j], dt);
+                    c[2 * i][2 * j] = cij * eij;
+                    c[2 * i][2 * j + 1] = cij / k[j] * (ei - eij);
+                    c[2 * i + 1][2 * j] = cij / k[i] * (ej - eij);
+                    c[2 * i + 1][2 * j + 1] = cij / (k[i] * k[j]) * (dt - ei - ej + eij);
+                }
+            }
+            return c;
+        }
+    };
+
+    GaussianFactors factorsOf(const ShortRateModel& model) {
+        GaussianFactors f;
+        const Array p = model.params();
+        if (dynamic_cast<const HullWhite*>(&model)) {
+            QL_REQUIRE(p.size() == 2, "unexpected HullWhite parameters");
+            f.k = {p[0]};
+            f.sigma = {p[1]};
+            f.rho = Matrix(1, 1, 1.0);
+        } else if (dynamic_cast<const G2*>(&model)) {
+            QL_REQUIRE(p.size() == 5, "unexpected G2 parameters");
+            f.k = {p[0], p[2]};
+            f.sigma = {p[1], p[3]};
+            f.rho = Matrix(2, 2, 1.0);
+            f.rho[0][1] = f.rho[1][0] = p[4];
+        } else {
+            QL_FAIL("lsmc engine requires a HullWhite or G2 model");
+        }
+        for (Real k : f.k)
+            QL_REQUIRE(k > 0.0, "lsmc engine requires positive mean reversion");
+        return f;
+    }
+
+    // Everything about one exercise date that does not depend on the path
+    struct ExerciseStep {
+        Time dt;                               // from the previous exercise (or 0)
+        std::vector<Real> decay;               // exp(-k_i dt)
+        std::vector<Real> drift;               // E(k_i, dt): I_i += x_i * drift
+        Matrix cholesky;                       // of stepCovariance(dt)
+        Real logDiscount;                      // ln P(0, t) - V(t) / 2
+        // underlying(x) = sum_m weight[m] * exp(-sum_i loading[m][i] x_i)
+        std::vector<Real> weight;
+        std::vector<std::vector<Real>> loading;
+    };
+
+    // Exercise-date values of a range of paths, structure of arrays
+    struct PathSet {
+        std::vector<Values> underlying;        // [e][p]
+        std::vector<Values> deflator;          // [e][p]: exp(-int_0^t r)
+        std::vector<std::vector<Values>> state; // [e][i][p]
+
+        PathSet(Size exercises, Size factors, Size paths)
+            : underlying(exercises, Values(paths)), deflator(exercises, Values(paths)),
+              state(exercises, std::vector<Values>(factors, Values(paths))) {}
+    };
+
+    class Simulation {
+    public:
+        Simulation(GaussianFactors factors, std::vector<ExerciseStep> steps,
+                   Real nominal, std::uint64_t seed)
+            : factors_(std::move(factors)), steps_(std::move(steps)),
+              nominal_(nominal), key_(Philox4x32::key(seed)) {}
+
+        Size exercises() const { return steps_.size(); }
+        Size factors() const { return factors_.size(); }
+        Size basisSize() const { return 1 + kPolynomialOrder + factors(); }
+
+        // Paths [first, first + n) of the given phase into out[offset, offset + n)
+        void simulate(std::uint32_t phase, std::uint64_t first, Size n,
+                      PathSet& out, Size offset) const {
+            const Size nf = factors(), nz = 2 * nf;
+            std::vector<Values> x(nf, Values(n, 0.0)), integral(nf, Values(n, 0.0));
+            std::vector<Values> z(nz, Values(n)), w(nz, Values(n));
+
+            for (Size e = 0; e < steps_.size(); ++e) {
+                const ExerciseStep& s = steps_[e];
+                if (s.dt > 0.0) {
+                    for (Size p = 0; p < n; ++p) {
+                        const std::uint64_t path = first + p;
+                        for (Size c = 0; c < nf; ++c) {
+                            const Philox4x32::Counter counter = {
+                                std::uint32_t(path), std::uint32_t(path >> 32),
+                                std::uint32_t(e), (phase << 16) | std::uint32_t(c)};
+                            Philox4x32::normals(counter, key_, z[2 * c][p], z[2 * c + 1][p]);
+                        }
+                    }
+                    for (Size r = 0; r < nz; ++r) {
+                        Real* wr = w[r].data();
+                        std::fill(wr, wr + n, 0.0);
+                        for (Size c = 0; c <= r; ++c) {
+                            const Real l = s.cholesky[r][c];
+                            const Real* zc = z[c].data();
+                            for (Size p = 0; p < n; ++p)
+                                wr[p] += l * zc[p];
+                        }
+                    }
+                    for (Size i = 0; i < nf; ++i) {
+                        Real* xi = x[i].data();
+                        Real* Ii = integral[i].data();
+                        const Real* wx = w[2 * i].data();
+                        const Real* wI = w[2 * i + 1].data();
+                        const Real decay = s.decay[i], drift = s.drift[i];
+                        for (Size p = 0; p < n; ++p) {
+                            Ii[p] += xi[p] * drift + wI[p];
+                            xi[p] = xi[p] * decay + wx[p];
+                        }
+                    }
+                }
+
+                Real* D = out.deflator[e].data() + offset;
+                Real* U = out.underlying[e].data() + offset;
+                for (Size p = 0; p < n; ++p) {
+                    Real sum = 0.0;
+                    for (Size i = 0; i < nf; ++i)
+                        sum += integral[i][p];
+                    D[p] = std::exp(s.logDiscount - sum);
+                    U[p] = 0.0;
+                }
+                for (Size m = 0; m < s.weight.size(); ++m) {
+                    const Real weight = s.weight[m];
+                    const std::vector<Real>& loading = s.loading[m];
+                    for (Size p = 0; p < n; ++p) {
+                        Real exponent = 0.0;
+                        for (Size i = 0; i < nf; ++i)
+                            exponent += loading[i] * x[i][p];
+                        U[p] += weight * std::exp(-exponent);
+                    }
+                }
+                for (Size i = 0; i < nf; ++i)
+                    std::copy(x[i].begin(), x[i].end(), out.state[e][i].begin() + offset);
+            }
+        }
+
+        void basis(const PathSet& paths, Size e, Size p, Real* phi) const {
+            const Real u = paths.underlying[e][p] / nominal_;
+            Real power = 1.0;
+            for (Size d = 0; d <= kPolynomialOrder; ++d, power *= u)
+                phi[d] = power;
+            for (Size i = 0; i < factors(); ++i)
+                phi[kPolynomialOrder + 1 + i] = paths.state[e][i][p];
+        }
+
+        // Exercise now? The last date exercises whenever the underlying is
+        // in the money; earlier ones compare with the regressed continuation.
+        bool exercise(const PathSet& paths, Size e, Size p,
+                      const std::vector<std::vector<Real>>& coefficients, Real* phi) const {
+            const Real u = paths.underlying[e][p];
+            if (u <= 0.0)
+                return false;
+            if (e + 1 == exercises())
+                return true;
+            basis(paths, e, p, phi);
+            Real continuation = 0.0;
+            for (Size b = 0; b < basisSize(); ++b)
+                continuation += coefficients[e][b] * phi[b];
+            return u >= continuation;
+        }
+
+    private:
+        GaussianFactors factors_;
+        std::vector<ExerciseStep> steps_;
+        Real nominal_;
+        Philox4x32::Key key_;
+    };
+
+    constexpr std::uint32_t kCalibrationPhase = 0;
+    constexpr std::uint32_t kPricingPhase = 1;
+
+}
+
+LsmcSwaptionEngine::LsmcSwaptionEngine(const ext::shared_ptr<ShortRateModel>& model,
+                                       const LsmcSettings& settings)
+    : GenericModelEngine<ShortRateModel, Swaption::arguments, Swaption::results>(model),
+      settings_(settings) {
+    QL_REQUIRE(settings_.calibrationPaths > 1, "lsmc needs calibration paths");
+    QL_REQUIRE(settings_.maxPaths > 1, "lsmc needs pricing paths");
+    QL_REQUIRE(settings_.blockSize > 0, "lsmc block size must be positive");
+}
+
+void LsmcSwaptionEngine::calculate() const {
+    QL_REQUIRE(!model_.empty(), "no model specified");
+    QL_REQUIRE(arguments_.settlementType == Settlement::Physical,
+               "lsmc engine supports physically settled swaptions only");
+
+    auto tsModel = ext::dynamic_pointer_cast<TermStructureConsistentModel>(*model_);
+    QL_REQUIRE(tsModel, "lsmc engine requires a term-structure consistent model");
+    const Handle<YieldTermStructure>& ts = tsModel->termStructure();
+    const Date referenceDate = ts->referenceDate();
+    const DayCounter dayCounter = ts->dayCounter();
+    auto timeOf = [&](const Date& d) { return dayCounter.yearFraction(referenceDate, d); };
+
+    GaussianFactors factors = factorsOf(**model_);
+    const Size nf = factors.size();
+
+    std::vector<Date> exerciseDates;
+    for (const Date& d : arguments_.exercise->dates())
+        if (d >= referenceDate)
+            exerciseDates.push_back(d);
+    QL_REQUIRE(!exerciseDates.empty(), "no exercise date left");
+
+    const std::vector<SwaptionCashflow> cashflows = swaptionCashflows(arguments_, referenceDate);
+
+    std::vector<ExerciseStep> steps(exerciseDates.size());
+    Time previous = 0.0;
+    for (Size e = 0; e < steps.size(); ++e) {
+        ExerciseStep& s = steps[e];
+        const Time t = timeOf(exerciseDates[e]);
+        s.dt = t - previous;
+        previous = t;
+        for (Size i = 0; i < nf; ++i) {
+            s.decay.push_back(std::exp(-factors.k[i] * s.dt));
+            s.drift.push_back(GaussianFactors::E(factors.k[i], s.dt));
+        }
+        if (s.dt > 0.0)
+            s.cholesky = CholeskyDecomposition(factors.stepCovariance(s.dt), true);
+        const DiscountFactor discount = ts->discount(t);
+        s.logDiscount = std::log(discount) - 0.5 * factors.V(t);
+
+        // Coupons resetting on or after the exercise date, by bond maturity
+        std::map<Time, Real> weights;
+        for (const SwaptionCashflow& cf : cashflows) {
+            if (cf.resetDate < exerciseDates[e])
+                continue;
+            weights[timeOf(cf.resetDate)] += cf.fixedPart;
+            weights[timeOf(cf.payDate)] += cf.bondPart;
+        }
+        for (const auto& entry : weights) {
+            const Time T = entry.first;
+            if (entry.second == 0.0)
+                continue;
+            // P(t, T) = P(0, T) / P(0, t) exp((V(T - t) - V(T) + V(t)) / 2 - sum_i E(k_i, T - t) x_i)
+            const Real convexity = 0.5 * (factors.V(T - t) - factors.V(T) + factors.V(t));
+            s.weight.push_back(entry.second * ts->discount(T) / discount * std::exp(convexity));
+            std::vector<Real> loading(nf);
+            for (Size i = 0; i < nf; ++i)
+                loading[i] = GaussianFactors::E(factors.k[i], T - t);
+            s.loading.push_back(std::move(loading));
+        }
+    }
+
+    const Simulation simulation(std::move(factors), std::move(steps),
+                                arguments_.nominal, settings_.seed);
+    const Size nEx = simulation.exercises();
+    const Size nb = simulation.basisSize();
+    const Size blockSize = settings_.blockSize;
+
+    std::optional<ThreadPool> ownPool;
+    if (settings_.threads != 0)
+        ownPool.emplace(settings_.threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    // Pass 1: simulate the calibration set and fit the exercise boundary
+    // backwards, regressing realized (deflated) cash flows on the basis
+    // over the in-the-money paths.
+    const Size nCal = settings_.calibrationPaths;
+    const Size calBlocks = (nCal + blockSize - 1) / blockSize;
+    PathSet calibration(nEx, nf, nCal);
+    pool.parallelFor(calBlocks, [&](std::size_t b) {
+        const Size first = b * blockSize;
+        simulation.simulate(kCalibrationPhase, first, std::min(blockSize, nCal - first),
+                            calibration, first);
+    });
+
+    std::vector<Real> cashflow(nCal);   // deflated to t = 0
+    for (Size p = 0; p < nCal; ++p)
+        cashflow[p] = std::max(calibration.underlying[nEx - 1][p], 0.0) *
+                      calibration.deflator[nEx - 1][p];
+
+    std::vector<std::vector<Real>> coefficients(nEx, std::vector<Real>(nb, 0.0));
+    for (Size e = nEx - 1; e-- > 0;) {
+        // Normal equations summed per block, then combined in block order
+        std::vector<Matrix> xtx(calBlocks, Matrix(nb, nb, 0.0));
+        std::vector<Array> xty(calBlocks, Array(nb, 0.0));
+        std::vector<Size> itm(calBlocks, 0);
+        pool.parallelFor(calBlocks, [&](std::size_t b) {
+            std::vector<Real> phi(nb);
+            const Size first = b * blockSize, last = std::min(first + blockSize, nCal);
+            for (Size p = first; p < last; ++p) {
+                if (calibration.underlying[e][p] <= 0.0)
+                    continue;
+                simulation.basis(calibration, e, p, phi.data());
+                const Real y = cashflow[p] / calibration.deflator[e][p];
+                for (Size r = 0; r < nb; ++r) {
+                    xty[b][r] += phi[r] * y;
+                    for (Size c = 0; c < nb; ++c)
+                        xtx[b][r][c] += phi[r] * phi[c];
+                }
+                ++itm[b];
+            }
+        });
+        Matrix a(nb, nb, 0.0);
+        Array rhs(nb, 0.0);
+        Size count = 0;
+        for (Size b = 0; b < calBlocks; ++b) {
+            a += xtx[b];
+            rhs += xty[b];
+            count += itm[b];
+        }
+        if (count < 2 * nb) {
+            // Too few in-the-money paths to fit: never exercise early here
+            coefficients[e].assign(nb, 0.0);
+            coefficients[e][0] = QL_MAX_REAL;
+            continue;
+        }
+        const Array beta = SVD(a).solveFor(rhs);
+        std::copy(beta.begin(), beta.end(), coefficients[e].begin());
+
+        pool.parallelFor(calBlocks, [&](std::size_t b) {
+            std::vector<Real> phi(nb);
+            const Size first = b * blockSize, last = std::min(first + blockSize, nCal);
+            for (Size p = first; p < last; ++p)
+                if (simulation.exercise(calibration, e, p, coefficients, phi.data()))
+                    cashflow[p] = calibration.underlying[e][p] * calibration.deflator[e][p];
+        });
+    }
+
+    // Pass 2: independent paths priced with the fitted boundary, in rounds
+    // of blocks until the standard error target or the path cap is hit.
+    const Size maxPaths = settings_.maxPaths;
+    const Size totalBlocks = (maxPaths + blockSize - 1) / blockSize;
+    Real sum = 0.0, sumSquares = 0.0, standardError = 0.0;
+    Size paths = 0;
+    for (Size round = 0; round < totalBlocks; round += kRoundBlocks) {
+        const Size blocks = std::min(kRoundBlocks, totalBlocks - round);
+        std::vector<Real> blockSum(blocks, 0.0), blockSquares(blocks, 0.0);
+        std::vector<Size> blockPaths(blocks, 0);
+        pool.parallelFor(blocks, [&](std::size_t j) {
+            const Size first = (round + j) * blockSize;
+            const Size n = std::min(blockSize, maxPaths - first);
+            PathSet block(nEx, nf, n);
+            simulation.simulate(kPricingPhase, first, n, block, 0);
+            std::vector<Real> phi(nb);
+            for (Size p = 0; p < n; ++p) {
+                Real value = 0.0;
+                for (Size e = 0; e < nEx; ++e) {
+                    if (simulation.exercise(block, e, p, coefficients, phi.data())) {
+                        value = block.underlying[e][p] * block.deflator[e][p];
+                        break;
+                    }
+                }
+                blockSum[j] += value;
+                blockSquares[j] += value * value;
+            }
+            blockPaths[j] = n;
+        });
+        for (Size j = 0; j < blocks; ++j) {
+            sum += blockSum[j];
+            sumSquares += blockSquares[j];
+            paths += blockPaths[j];
+        }
+
+        const Real mean = sum / Real(paths);
+        const Real variance = std::max(sumSquares / Real(paths) - mean * mean, 0.0) *
+                              Real(paths) / Real(paths - 1);
+        standardError = std::sqrt(variance / Real(paths));
+        if (settings_.tolerance > 0.0 && standardError <= settings_.tolerance)
+            break;
+    }
+
+    results_.value = sum / Real(paths);
+    results_.errorEstimate = standardError;
+    results_.additionalResults["paths"] = paths;
+}
@@ -0,0 +1,114 @@
+#include "MarketCache.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "QuantLibSession.hpp"
+#include "TradeObjects.hpp"
+
+#include <optional>
+
+using namespace QuantLib;
+
+struct MarketCache::Entry {
+    std::mutex mutex;                   // held by the lease
+    std::optional<TradeObjects> objects;
+    std::unique_ptr<BermudanSwaptionPricer> pricer;
+    std::uint64_t lastUse = 0;          // guarded by MarketCache::mutex_
+
+    // The pricer's instrument and engine observe the graph; drop them first
+    ~Entry() {
+        QuantLibSession::Guard guard;
+        pricer.reset();
+        objects.reset();
+    }
+};
+
+BermudanSwaptionPricer& MarketCache::Lease::pricer() const {
+    return *entry_->pricer;
+}
+
+double MarketCache::Lease::atmRate() const {
+    return entry_->objects->swap->fixedRate();
+}
+
+MarketCache::MarketCache(std::size_t capacity)
+    : capacity_(capacity) {
+    QL_REQUIRE(capacity_ > 0, "MarketCache capacity must be positive");
+}
+
+MarketCache::~MarketCache() = default;
+
+MarketCache::Key MarketCache::keyOf(const BermudanTrade& trade) {
+    const LsmcSettings& mc = trade.lsmc;
+    const std::thread::id owner =
+        QuantLibSession::isolated() ? std::this_thread::get_id() : std::thread::id();
+    return Key(owner, trade.evaluationDate, trade.flatRate, trade.model, trade.engine, trade.swap,
+               trade.modelParams,
+               mc.calibrationPaths, mc.maxPaths, mc.tolerance, mc.blockSize, mc.seed,
+               mc.threads, trade.grid.tolerance, trade.grid.minSteps, trade.grid.maxSteps,
+               trade.grid.richardson);
+}
+
+MarketCache::Lease MarketCache::acquire(const BermudanTrade& trade) {
+    std::shared_ptr<Entry> entry;
+    std::shared_ptr<Entry> evicted;     // destroyed after the cache lock is released
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = entries_[keyOf(trade)];
+        if (slot) {
+            ++hits_;
+        } else {
+            ++misses_;
+            slot = std::make_shared<Entry>();
+            if (entries_.size() > capacity_) {
+                auto oldest = entries_.end();
+                for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                    if (it->second != slot &&
+                        (oldest == entries_.end() || it->second->lastUse < oldest->second->lastUse))
+                        oldest = it;
+                }
+                evicted = std::move(oldest->second);
+                entries_.erase(oldest);
+            }
+        }
+        slot->lastUse = ++clock_;
+        entry = slot;
+    }
+
+    Lease lease;
+    lease.lock_ = std::unique_lock<std::mutex>(entry->mutex);
+    lease.entry_ = std::move(entry);
+    if (!lease.entry_->pricer) {
+        BermudanTrade atm = trade;
+        atm.strikeMultiplier = 1.0;
+        lease.entry_->objects.emplace(atm);
+        lease.entry_->pricer = std::make_unique<BermudanSwaptionPricer>(
+            lease.entry_->objects->swap, lease.entry_->objects->model, atm.engine,
+            nullptr, atm.lsmc, atm.grid);
+    }
+    return lease;
+}
+
+std::size_t MarketCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void MarketCache::clear() {
+    std::map<Key, std::shared_ptr<Entry>> dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    dropped.swap(entries_);
+}
+
+std::uint64_t MarketCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+std::uint64_t MarketCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+MarketCache& MarketCache::shared() {
+    static MarketCache cache;
+    return cache;
+}
@@ -0,0 +1,218 @@
+#include "MarketGraph.hpp"
+#include "HullWhiteSoaLattice.hpp"
+#include "HullWhiteTreeAdjoint.hpp"
+#include "QuantLibSession.hpp"
+#include "SwapBuilder.hpp"
+#include "SwaptionCashflows.hpp"
+#include "YieldCurveBuilder.hpp"
+
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/pricingengines/swaption/discretizedswaption.hpp>
+#include <ql/termstructures/yield/piecewisezerospreadedtermstructure.hpp>
+#include <ql/termstructures/yield/zerospreadedtermstructure.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace QuantLib;
+
+namespace {
+
+    // Steps per period of the pricer's default tree engines
+    constexpr Size kTreeSteps = 50;
+
+    // Weight of bucket k in the spread at time t: linear between nodes and
+    // flat outside, as PiecewiseZeroSpreadedTermStructure interpolates.
+    double bucketWeight(const std::vector<Time>& nodes, std::size_t k, Time t) {
+        const std::size_t last = nodes.size() - 1;
+        if (t <= nodes.front())
+            return k == 0 ? 1.0 : 0.0;
+        if (t >= nodes.back())
+            return k == last ? 1.0 : 0.0;
+        const std::size_t hi = std::upper_bound(nodes.begin(), nodes.end(), t) - nodes.begin();
+        const double w = (t - nodes[hi - 1]) / (nodes[hi] - nodes[hi - 1]);
+        if (k == hi)
+            return w;
+        if (k == hi - 1)
+            return 1.0 - w;
+        return 0.0;
+    }
+
+}
+
+MarketGraph::MarketGraph(const BermudanTrade& trade, const std::vector<Period>& buckets,
+                         std::optional<Rate> strike, const std::vector<double>& params)
+    : engine_(trade.engine), lsmc_(trade.lsmc), parallel_(ext::make_shared<SimpleQuote>(0.0)) {
+    QuantLibSession::Guard guard;
+    try {
+        Date settlement = TARGET().advance(trade.evaluationDate, 2, Days);
+        Handle<YieldTermStructure> flat = YieldCurveBuilder(trade.flatRate).buildCurve(settlement);
+
+        std::vector<Handle<Quote>> spreads;
+        for (const Period& p : buckets) {
+            spreads_.push_back(ext::make_shared<SimpleQuote>(0.0));
+            spreads.emplace_back(spreads_.back());
+            dates_.push_back(settlement + p);
+        }
+        auto bucketed = ext::make_shared<PiecewiseZeroSpreadedTermStructure>(
+            flat, spreads, dates_);
+        bucketed->enableExtrapolation();
+        auto shifted = ext::make_shared<ZeroSpreadedTermStructure>(
+            Handle<YieldTermStructure>(bucketed), Handle<Quote>(parallel_));
+        shifted->enableExtrapolation();
+        curve_ = Handle<YieldTermStructure>(shifted);
+
+        SwapBuilder sb(curve_, trade.swap);
+        strike_ = strike ? *strike : sb.fairRate() * trade.strikeMultiplier;
+        swap_ = sb.buildSwap(strike_);
+        modelCurve_ = ext::make_shared<GridDiscountCurve>(curve_);
+        model_ = BermudanSwaptionPricer::makeModel(
+            trade.model, Handle<YieldTermStructure>(modelCurve_));
+        const std::vector<double>& given = params.empty() ? trade.modelParams : params;
+        if (!given.empty()) {
+            QL_REQUIRE(given.size() == model_->params().size(),
+                       given.size() << " model parameters given, " << trade.model
+                       << " has " << model_->params().size());
+            model_->setParams(Array(given.begin(), given.end()));
+        }
+        params_ = model_->params();
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+MarketGraph::~MarketGraph() {
+    QuantLibSession::Guard guard;
+    release();
+}
+
+void MarketGraph::attach(const TimeGrid* grid) {
+    QuantLibSession::Guard guard;
+    pricer_ = std::make_unique<BermudanSwaptionPricer>(swap_, model_, engine_, grid, lsmc_);
+}
+
+double MarketGraph::price() {
+    if (engine_ == "fdm") {
+        // FD engines rebuild the swap with a cloned index inside calculate()
+        QuantLibSession::Guard guard;
+        return pricer_->price();
+    }
+    return pricer_->price();
+}
+
+double MarketGraph::price(const Bump& bump) {
+    shift(bump, bump.shift);
+    const double value = price();
+    shift(bump, 0.0);
+    return value;
+}
+
+double MarketGraph::price(const std::vector<double>& spreads) {
+    QL_REQUIRE(spreads.size() == spreads_.size(),
+               spreads.size() << " spreads given for " << spreads_.size() << " buckets");
+    for (std::size_t k = 0; k < spreads.size(); ++k)
+        spreads_[k]->setValue(spreads[k]);
+    return price();
+}
+
+TimeGrid MarketGraph::treeGrid() const {
+    Swaption::arguments args;
+    pricer_->swaption()->setupArguments(&args);
+    args.validate();
+    DiscretizedSwaption asset(args, curve_->referenceDate(), curve_->dayCounter());
+    std::vector<Time> times = asset.mandatoryTimes();
+    return TimeGrid(times.begin(), times.end(), kTreeSteps);
+}
+
+std::vector<double> MarketGraph::adjointDeltas(const TimeGrid& grid, double curveShift,
+                                           Real& npv) const {
+    auto hw = ext::dynamic_pointer_cast<HullWhite>(model_);
+    QL_REQUIRE(hw && (engine_ == "tree" || engine_ == "hw-simd"),
+               "adjoint Greeks require a HullWhite model on the tree or hw-simd engine");
+
+    Swaption::arguments args;
+    pricer_->swaption()->setupArguments(&args);
+    args.validate();
+
+    const Date referenceDate = curve_->referenceDate();
+    const DayCounter dayCounter = curve_->dayCounter();
+    auto indexOf = [&](const Date& d) {
+        return grid.index(dayCounter.yearFraction(referenceDate, d));
+    };
+
+    std::vector<HullWhiteTreeAdjoint::Cashflow> cashflows;
+    for (const SwaptionCashflow& cf : swaptionCashflows(args, referenceDate))
+        cashflows.push_back({indexOf(cf.resetDate), indexOf(cf.payDate),
+                             cf.fixedPart, cf.bondPart});
+
+    std::vector<std::size_t> exercises;
+    for (const Date& d : args.exercise->dates())
+        if (d >= referenceDate)
+            exercises.push_back(indexOf(d));
+    QL_REQUIRE(!exercises.empty(), "no exercise date left");
+    const std::size_t valuation = *std::min_element(exercises.begin(), exercises.end());
+
+    auto lattice = HullWhiteSoaLattice::build(*hw, grid);
+    const Size nSteps = grid.size() - 1;
+    std::vector<std::size_t> sizes(nSteps + 1);
+    std::vector<HullWhiteTreeAdjoint::Step> steps(nSteps);
+    for (Size i = 0; i <= nSteps; ++i)
+        sizes[i] = lattice->size(i);
+    for (Size i = 0; i < nSteps; ++i) {
+        HullWhiteTreeAdjoint::Step& s = steps[i];
+        const Time dt = grid.dt(i);
+        for (Size j = 0; j < sizes[i]; ++j) {
+            s.growth.push_back(std::exp(-lattice->underlying(i, j) * dt));
+            for (Size l = 0; l < 3; ++l)
+                s.prob[l].push_back(lattice->probability(i, j, l));
+            s.base.push_back(static_cast<std::int32_t>(lattice->descendant(i, j, 0)));
+        }
+    }
+
+    std::vector<double> discounts(nSteps + 1);
+    for (Size i = 0; i <= nSteps; ++i)
+        discounts[i] = curve_->discount(grid[i]);
+
+    HullWhiteTreeAdjoint adjoint(std::move(steps), std::move(sizes));
+    npv = adjoint.calculate(discounts, cashflows, exercises, valuation);
+    const std::vector<double>& sensitivities = adjoint.logDiscountSensitivities();
+
+    // ln P(t) = ln P_flat(t) - (s(t) + parallel) t
+    std::vector<Time> nodes;
+    for (const Date& d : dates_)
+        nodes.push_back(curve_->timeFromReference(d));
+    std::vector<double> deltas(nodes.size(), 0.0);
+    for (Size i = 1; i <= nSteps; ++i)
+        for (std::size_t k = 0; k < nodes.size(); ++k)
+            deltas[k] -= sensitivities[i] * grid[i] * bucketWeight(nodes, k, grid[i]);
+    for (double& d : deltas)
+        d *= curveShift;
+    return deltas;
+}
+
+void MarketGraph::shift(const Bump& bump, double amount) {
+    switch (bump.kind) {
+      case Bump::Bucket:
+        spreads_[bump.index]->setValue(amount);
+        break;
+      case Bump::Parallel:
+        parallel_->setValue(amount);
+        break;
+      case Bump::Param: {
+        Array params = params_;
+        params[bump.index] += amount;
+        model_->setParams(params);
+        break;
+      }
+    }
+}
+
+void MarketGraph::release() {
+    pricer_.reset();
+    model_.reset();
+    modelCurve_.reset();
+    swap_.reset();
+    curve_ = Handle<YieldTermStructure>();
+}
+
@@ -0,0 +1,85 @@
+#include "Metrics.hpp"
+
+#include <array>
+#include <atomic>
+
+namespace {
+
+    constexpr std::size_t kStages = static_cast<std::size_t>(Stage::Count);
+    constexpr std::size_t kCounters = static_cast<std::size_t>(Counter::Count);
+
+    const char* const kStageNames[kStages] = {
+        "curve_build", "swap_build", "fair_rate", "schedule_walk", "engine_setup",
+        "lattice_build", "rollback", "price", "calibration"
+    };
+
+    const char* const kCounterNames[kCounters] = {
+        "lattice_nodes", "lattice_steps", "optimizer_evaluations", "optimizer_gradients",
+        "calibration_cache_hits", "lattice_cache_hits"
+    };
+
+    // One cache line per stage so concurrent pricers timing different stages
+    // do not false-share.
+    struct alignas(64) StageSlot {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> totalNs{0};
+        std::atomic<std::uint64_t> maxNs{0};
+    };
+
+    struct alignas(64) CounterSlot {
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    std::array<StageSlot, kStages> stages;
+    std::array<CounterSlot, kCounters> counters;
+
+}
+
+void Metrics::record(Stage stage, std::chrono::nanoseconds elapsed) {
+    StageSlot& slot = stages[static_cast<std::size_t>(stage)];
+    const auto ns = static_cast<std::uint64_t>(elapsed.count() > 0 ? elapsed.count() : 0);
+    slot.calls.fetch_add(1, std::memory_order_relaxed);
+    slot.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    std::uint64_t seen = slot.maxNs.load(std::memory_order_relaxed);
+    while (ns > seen && !slot.maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+}
+
+void Metrics::add(Counter counter, std::uint64_t n) {
+    counters[static_cast<std::size_t>(counter)].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+MetricsSnapshot Metrics::snapshot() {
+    MetricsSnapshot result;
+    result.enabled = enabled();
+    result.stages.reserve(kStages);
+    for (std::size_t i = 0; i < kStages; ++i) {
+        StageMetrics s;
+        s.name = kStageNames[i];
+        s.calls = stages[i].calls.load(std::memory_order_relaxed);
+        s.totalSeconds = static_cast<double>(stages[i].totalNs.load(std::memory_order_relaxed)) * 1e-9;
+        s.maxSeconds = static_cast<double>(stages[i].maxNs.load(std::memory_order_relaxed)) * 1e-9;
+        result.stages.push_back(s);
+    }
+    result.counters.reserve(kCounters);
+    for (std::size_t i = 0; i < kCounters; ++i)
+        result.counters.push_back({kCounterNames[i], counters[i].value.load(std::memory_order_relaxed)});
+    return result;
+}
+
+void Metrics::reset() {
+    for (auto& s : stages) {
+        s.calls.store(0, std::memory_order_relaxed);
+        s.totalNs.store(0, std::memory_order_relaxed);
+        s.maxNs.store(0, std::memory_order_relaxed);
+    }
+    for (auto& c : counters)
+        c.value.store(0, std::memory_order_relaxed);
+}
+
+const char* Metrics::name(Stage stage) {
+    return kStageNames[static_cast<std::size_t>(stage)];
+}
+
+const char* Metrics::name(Counter counter) {
+    return kCounterNames[static_cast<std::size_t>(counter)];
+}
@@ -0,0 +1,641 @@
+#include "PortfolioStream.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "QuantLibSession.hpp"
+#include "TradeCodes.hpp"
+#include "TradeObjects.hpp"
+
+#include <ql/settings.hpp>
+#include <ql/utilities/dataparsers.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace QuantLib;
+
+namespace {
+
+    constexpr char kMagic[4] = {'B', 'S', 'P', 'F'};
+    constexpr std::uint32_t kVersion = 1;
+    constexpr std::size_t kHeaderSize = 16;     // magic, version, row count
+
+    template <std::size_t N>
+    std::uint8_t codeOf(const char* const (&names)[N], const std::string& name, const char* what) {
+        for (std::size_t i = 0; i < N; ++i)
+            if (name == names[i])
+                return static_cast<std::uint8_t>(i);
+        QL_FAIL("Unknown " << what << " '" << name << "' cannot be stored in a binary portfolio");
+    }
+
+    template <std::size_t N>
+    std::string nameOf(const char* const (&names)[N], std::uint8_t code, const char* what) {
+        QL_REQUIRE(code < N, "Invalid " << what << " code " << int(code) << " in binary portfolio");
+        return names[code];
+    }
+
+    std::uint64_t toUnsigned(const std::string& field) {
+        char* end = nullptr;
+        const unsigned long long value = std::strtoull(field.c_str(), &end, 10);
+        QL_REQUIRE(!field.empty() && field[0] != '-' && end == field.c_str() + field.size(),
+                   "'" << field << "' is not an unsigned integer");
+        return value;
+    }
+
+    double toDouble(const std::string& field) {
+        char* end = nullptr;
+        const double value = std::strtod(field.c_str(), &end);
+        QL_REQUIRE(!field.empty() && end == field.c_str() + field.size(),
+                   "'" << field << "' is not a number");
+        return value;
+    }
+
+    std::string trimmed(std::string_view field) {
+        const auto first = field.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos)
+            return std::string();
+        const auto last = field.find_last_not_of(" \t\r");
+        return std::string(field.substr(first, last - first + 1));
+    }
+
+    class CsvPortfolioReader : public PortfolioReader {
+    public:
+        CsvPortfolioReader(const std::string& path, const BermudanTrade& defaults)
+        : path_(path), in_(path), defaults_(defaults) {
+            QL_REQUIRE(in_, "Cannot open portfolio " << path);
+            std::string header;
+            QL_REQUIRE(std::getline(in_, header), "Portfolio " << path << " is empty");
+            ++line_;
+            bool date = false, rate = false;
+            for (const std::string& name : split(header)) {
+                columns_.push_back(columnOf(name));
+                date = date || columns_.back() == Column::EvaluationDate;
+                rate = rate || columns_.back() == Column::FlatRate;
+            }
+            QL_REQUIRE(date && rate,
+                       path << ": header needs evaluation_date and flat_rate columns");
+        }
+
+        bool next(PortfolioRow& row) override {
+            std::string text;
+            do {
+                if (!std::getline(in_, text))
+                    return false;
+                ++line_;
+            } while (trimmed(text).empty());
+
+            try {
+                std::vector<std::string> fields = split(text);
+                QL_REQUIRE(fields.size() == columns_.size(),
+                           fields.size() << " fields, header has " << columns_.size());
+                row.id = rows_;
+                row.trade = defaults_;
+                for (std::size_t i = 0; i < fields.size(); ++i)
+                    assign(columns_[i], fields[i], row);
+            } catch (const std::exception& e) {
+                QL_FAIL(path_ << ":" << line_ << ": " << e.what());
+            }
+            ++rows_;
+            return true;
+        }
+
+    private:
+        enum class Column {
+            Id, EvaluationDate, FlatRate, Model, Engine, StrikeMultiplier, ForwardStart,
+            Tenor, FixedFrequency, FloatFrequency, Notional, Type
+        };
+
+        static Column columnOf(const std::string& name) {
+            static const std::map<std::string, Column> columns = {
+                {"id", Column::Id},
+                {"evaluation_date", Column::EvaluationDate},
+                {"flat_rate", Column::FlatRate},
+                {"model", Column::Model},
+                {"engine", Column::Engine},
+                {"strike_multiplier", Column::StrikeMultiplier},
+                {"forward_start", Column::ForwardStart},
+                {"tenor", Column::Tenor},
+                {"fixed_frequency", Column::FixedFrequency},
+                {"float_frequency", Column::FloatFrequency},
+                {"notional", Column::Notional},
+                {"type", Column::Type},
+            };
+            auto it = columns.find(name);
+            QL_REQUIRE(it != columns.end(), "Unknown portfolio column '" << name << "'");
+            return it->second;
+        }
+
+        static std::vector<std::string> split(std::string_view line) {
+            std::vector<std::string> fields;
+            for (std::size_t begin = 0;;) {
+                const std::size_t end = line.find(',', begin);
+                fields.push_back(trimmed(line.substr(begin, end - begin)));
+                if (end == std::string_view::npos)
+                    return fields;
+                begin = end + 1;
+            }
+        }
+
+        static void assign(Column column, const std::string& field, PortfolioRow& row) {
+            BermudanTrade& t = row.trade;
+            SwapDescription& s = t.swap;
+            switch (column) {
+              case Column::Id:
+                row.id = toUnsigned(field);
+                break;
+              case Column::EvaluationDate:
+                t.evaluationDate = DateParser::parseISO(field);
+                break;
+              case Column::FlatRate:
+                t.flatRate = toDouble(field);
+                break;
+              case Column::Model:
+                t.model = field;
+                break;
+              case Column::Engine:
+                t.engine = field;
+                break;
+              case Column::StrikeMultiplier:
+                t.strikeMultiplier = toDouble(field);
+                break;
+              case Column::ForwardStart:
+                s.forwardStart = PeriodParser::parse(field);
+                break;
+              case Column::Tenor:
+                s.tenor = PeriodParser::parse(field);
+                break;
+              case Column::FixedFrequency:
+                s.fixedFrequency = PeriodParser::parse(field).frequency();
+                break;
+              case Column::FloatFrequency:
+                s.floatFrequency = PeriodParser::parse(field).frequency();
+                break;
+              case Column::Notional:
+                s.notional = toDouble(field);
+                break;
+              case Column::Type:
+                QL_REQUIRE(field == "payer" || field == "receiver",
+                           "type must be 'payer' or 'receiver', got '" << field << "'");
+                s.type = field == "payer" ? Swap::Payer : Swap::Receiver;
+                break;
+            }
+        }
+
+        std::string path_;
+        std::ifstream in_;
+        BermudanTrade defaults_;
+        std::vector<Column> columns_;
+        std::size_t line_ = 0;
+        std::uint64_t rows_ = 0;
+    };
+
+    class MappedPortfolioReader : public PortfolioReader {
+    public:
+        MappedPortfolioReader(const std::string& path, const BermudanTrade& defaults)
+        : defaults_(defaults) {
+            fd_ = ::open(path.c_str(), O_RDONLY);
+            QL_REQUIRE(fd_ >= 0, "Cannot open portfolio " << path);
+            struct stat st;
+            if (::fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+                ::close(fd_);
+                QL_FAIL("Portfolio " << path << " is truncated");
+            }
+            size_ = static_cast<std::size_t>(st.st_size);
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd_);
+                QL_FAIL("Cannot map portfolio " << path);
+            }
+            data_ = static_cast<const unsigned char*>(data);
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            page_ = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+            std::uint32_t version;
+            std::memcpy(&version, data_ + 4, sizeof version);
+            std::memcpy(&count_, data_ + 8, sizeof count_);
+            const std::size_t body = size_ - kHeaderSize;
+            if (version != kVersion || body % sizeof(PortfolioRecord) != 0 ||
+                body / sizeof(PortfolioRecord) != count_) {
+                release();
+                QL_FAIL("Portfolio " << path << " has version " << version << " or a size ("
+                        << size_ << " bytes) that does not match its " << count_ << " rows");
+            }
+            offset_ = kHeaderSize;
+        }
+
+        ~MappedPortfolioReader() override { release(); }
+
+        bool next(PortfolioRow& row) override {
+            if (rows_ == count_)
+                return false;
+            PortfolioRecord record;
+            std::memcpy(&record, data_ + offset_, sizeof record);
+            offset_ += sizeof record;
+            ++rows_;
+            row.trade = defaults_;
+            decodeRecord(record, row);
+
+            // Drop pages already read, so a large book never becomes resident
+            if (offset_ - released_ >= kReleaseChunk) {
+                const std::size_t upTo = offset_ / page_ * page_;
+                ::madvise(const_cast<unsigned char*>(data_) + released_, upTo - released_,
+                          MADV_DONTNEED);
+                released_ = upTo;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr std::size_t kReleaseChunk = std::size_t(4) << 20;
+
+        void release() {
+            if (data_)
+                ::munmap(const_cast<unsigned char*>(data_), size_);
+            if (fd_ >= 0)
+                ::close(fd_);
+            data_ = nullptr;
+            fd_ = -1;
+        }
+
+        BermudanTrade defaults_;
+        int fd_ = -1;
+        const unsigned char* data_ = nullptr;
+        std::size_t size_ = 0;
+        std::size_t page_ = 4096;
+        std::size_t offset_ = 0;
+        std::size_t released_ = 0;
+        std::uint64_t count_ = 0;
+        std::uint64_t rows_ = 0;
+    };
+
+    // Unbounded FIFO with close(); the stream's window bounds what it holds.
+    template <class T>
+    class WorkQueue {
+    public:
+        void push(T item) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                items_.push_back(std::move(item));
+            }
+            ready_.notify_one();
+        }
+
+        // Empty once the queue is closed and drained
+        std::optional<T> pop() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [&] { return !items_.empty() || closed_; });
+            if (items_.empty())
+                return std::nullopt;
+            T item = std::move(items_.front());
+            items_.pop_front();
+            return item;
+        }
+
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            ready_.notify_all();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::deque<T> items_;
+        bool closed_ = false;
+    };
+
+    struct Job {
+        std::size_t seq = 0;
+        PortfolioRow row;
+        std::unique_ptr<TradeObjects> objects;
+        std::string error;
+    };
+
+    struct Result {
+        std::size_t seq = 0;
+        std::uint64_t id = 0;
+        double npv = std::numeric_limits<double>::quiet_NaN();
+        std::string error;
+    };
+
+    // Trades between the reader and the writer. acquire() blocks the reader
+    // while the window is full, or until the pipeline is empty when the
+    // evaluation date has to change.
+    class Window {
+    public:
+        explicit Window(std::size_t size) : size_(size) {}
+
+        bool acquire(bool drain) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [&] {
+                return aborted_ || (drain ? inFlight_ == 0 : inFlight_ < size_);
+            });
+            if (aborted_)
+                return false;
+            ++inFlight_;
+            return true;
+        }
+
+        void release() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --inFlight_;
+            }
+            changed_.notify_all();
+        }
+
+        void abort() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                aborted_ = true;
+            }
+            changed_.notify_all();
+        }
+
+        bool aborted() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return aborted_;
+        }
+
+    private:
+        std::size_t size_;
+        mutable std::mutex mutex_;
+        std::condition_variable changed_;
+        std::size_t inFlight_ = 0;
+        bool aborted_ = false;
+    };
+
+    // Joins on scope exit, including when the writer throws
+    struct Threads {
+        std::vector<std::thread> threads;
+        ~Threads() {
+            for (auto& t : threads)
+                t.join();
+        }
+    };
+
+    double priceObjects(const TradeObjects& objects, const BermudanTrade& trade) {
+        BermudanSwaptionPricer pricer(objects.swap, objects.model, trade.engine,
+                                      nullptr, trade.lsmc, trade.grid);
+        if (trade.engine == "fdm") {
+            // FD engines rebuild the swap with a cloned index inside calculate()
+            QuantLibSession::Guard guard;
+            return pricer.price();
+        }
+        return pricer.price();
+    }
+
+}
+
+
+PortfolioRecord encodeRecord(const PortfolioRow& row) {
+    const BermudanTrade& t = row.trade;
+    const SwapDescription& s = t.swap;
+    PortfolioRecord r{};
+    r.id = row.id;
+    r.flatRate = t.flatRate;
+    r.strikeMultiplier = t.strikeMultiplier;
+    r.notional = s.notional;
+    r.evaluationDate = static_cast<std::int32_t>(t.evaluationDate.serialNumber());
+    r.forwardStart = s.forwardStart.length();
+    r.tenor = s.tenor.length();
+    r.fixedFrequency = static_cast<std::int16_t>(s.fixedFrequency);
+    r.floatFrequency = static_cast<std::int16_t>(s.floatFrequency);
+    r.forwardStartUnits = static_cast<std::uint8_t>(s.forwardStart.units());
+    r.tenorUnits = static_cast<std::uint8_t>(s.tenor.units());
+    r.model = codeOf(kModelCodes, t.model, "model");
+    r.engine = codeOf(kEngineCodes, t.engine, "engine");
+    r.type = static_cast<std::int8_t>(s.type);
+    return r;
+}
+
+void decodeRecord(const PortfolioRecord& r, PortfolioRow& row) {
+    BermudanTrade& t = row.trade;
+    SwapDescription& s = t.swap;
+    row.id = r.id;
+    t.flatRate = r.flatRate;
+    t.strikeMultiplier = r.strikeMultiplier;
+    s.notional = r.notional;
+    t.evaluationDate = Date(static_cast<Date::serial_type>(r.evaluationDate));
+    s.forwardStart = Period(r.forwardStart, static_cast<TimeUnit>(r.forwardStartUnits));
+    s.tenor = Period(r.tenor, static_cast<TimeUnit>(r.tenorUnits));
+    s.fixedFrequency = static_cast<Frequency>(r.fixedFrequency);
+    s.floatFrequency = static_cast<Frequency>(r.floatFrequency);
+    t.model = nameOf(kModelCodes, r.model, "model");
+    t.engine = nameOf(kEngineCodes, r.engine, "engine");
+    QL_REQUIRE(r.type == Swap::Payer || r.type == Swap::Receiver,
+               "Invalid swap type " << int(r.type) << " in binary portfolio");
+    s.type = static_cast<Swap::Type>(r.type);
+}
+
+std::unique_ptr<PortfolioReader> PortfolioReader::open(const std::string& path,
+                                                       const BermudanTrade& defaults) {
+    char magic[sizeof kMagic] = {};
+    {
+        std::ifstream probe(path, std::ios::binary);
+        QL_REQUIRE(probe, "Cannot open portfolio " << path);
+        probe.read(magic, sizeof magic);
+    }
+    if (std::equal(std::begin(magic), std::end(magic), std::begin(kMagic)))
+        return std::make_unique<MappedPortfolioReader>(path, defaults);
+    return std::make_unique<CsvPortfolioReader>(path, defaults);
+}
+
+BinaryPortfolioWriter::BinaryPortfolioWriter(const std::string& path)
+    : out_(path, std::ios::binary | std::ios::trunc) {
+    QL_REQUIRE(out_, "Cannot create portfolio " << path);
+    const std::uint64_t count = 0;
+    out_.write(kMagic, sizeof kMagic);
+    out_.write(reinterpret_cast<const char*>(&kVersion), sizeof kVersion);
+    out_.write(reinterpret_cast<const char*>(&count), sizeof count);
+}
+
+BinaryPortfolioWriter::~BinaryPortfolioWriter() {
+    try {
+        close();
+    } catch (...) {}
+}
+
+void BinaryPortfolioWriter::write(const PortfolioRow& row) {
+    QL_REQUIRE(out_.is_open(), "Portfolio writer is closed");
+    const PortfolioRecord record = encodeRecord(row);
+    out_.write(reinterpret_cast<const char*>(&record), sizeof record);
+    ++count_;
+}
+
+void BinaryPortfolioWriter::close() {
+    if (!out_.is_open())
+        return;
+    out_.seekp(8);
+    out_.write(reinterpret_cast<const char*>(&count_), sizeof count_);
+    out_.close();
+    QL_REQUIRE(!out_.fail(), "Failed to write portfolio");
+}
+
+void writePortfolioResult(std::ostream& out, std::uint64_t id, double npv,
+                          const std::string& error) {
+    out << id << ',' << npv << ',';
+    if (!error.empty()) {
+        out << '"';
+        for (char c : error) {
+            if (c == '"')
+                out << '"';
+            out << (c == '\n' ? ' ' : c);
+        }
+        out << '"';
+    }
+    out << '\n';
+}
+
+StreamStats streamPortfolio(PortfolioReader& reader, std::ostream& out,
+                            const StreamSettings& settings) {
+    QL_REQUIRE(settings.window > 0, "Stream window must be positive");
+    QL_REQUIRE(settings.buildThreads > 0, "Stream needs at least one build thread");
+    const std::size_t priceThreads =
+        settings.priceThreads != 0
+            ? settings.priceThreads
+            : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    constexpr bool isolated = QuantLibSession::isolated();
+
+    const auto start = std::chrono::steady_clock::now();
+    SavedSettings backup;
+
+    Window window(settings.window);
+    WorkQueue<Job> parsed;
+    WorkQueue<Job> built;
+    WorkQueue<Result> priced;
+    std::exception_ptr readError;
+    // Session builds skip the build stage: a graph stays in the session
+    // (thread) that built it, so the pricing thread builds it.
+    WorkQueue<Job>& toPrice = isolated ? parsed : built;
+    const std::size_t buildThreads = isolated ? 0 : settings.buildThreads;
+    std::atomic<std::size_t> builders{buildThreads};
+    std::atomic<std::size_t> pricers{priceThreads};
+
+    Threads threads;
+    try {
+        threads.threads.emplace_back([&] {
+            try {
+                std::optional<Date> date;
+                PortfolioRow row;
+                for (std::size_t seq = 0; reader.next(row); ++seq) {
+                    const bool drain = !isolated && date && *date != row.trade.evaluationDate;
+                    if (!window.acquire(drain))
+                        break;
+                    if (!isolated && date != row.trade.evaluationDate) {
+                        Settings::instance().evaluationDate() = row.trade.evaluationDate;
+                        date = row.trade.evaluationDate;
+                    }
+                    parsed.push(Job{seq, row, nullptr, std::string()});
+                }
+            } catch (...) {
+                readError = std::current_exception();
+            }
+            parsed.close();
+        });
+
+        for (std::size_t i = 0; i < buildThreads; ++i) {
+            threads.threads.emplace_back([&] {
+                while (std::optional<Job> job = parsed.pop()) {
+                    if (!window.aborted()) {
+                        try {
+                            job->objects = std::make_unique<TradeObjects>(job->row.trade);
+                        } catch (const std::exception& e) {
+                            job->error = e.what();
+                        }
+                    }
+                    built.push(std::move(*job));
+                }
+                if (--builders == 0)
+                    built.close();
+            });
+        }
+
+        for (std::size_t i = 0; i < priceThreads; ++i) {
+            threads.threads.emplace_back([&] {
+                while (std::optional<Job> job = toPrice.pop()) {
+                    const BermudanTrade& trade = job->row.trade;
+                    Result result{job->seq, job->row.id,
+                                  std::numeric_limits<double>::quiet_NaN(), std::move(job->error)};
+                    if (!window.aborted() && result.error.empty()) {
+                        try {
+                            if constexpr (isolated) {
+                                Settings::instance().evaluationDate() = trade.evaluationDate;
+                                job->objects = std::make_unique<TradeObjects>(trade);
+                            }
+                            result.npv = priceObjects(*job->objects, trade);
+                        } catch (const std::exception& e) {
+                            result.error = e.what();
+                        }
+                    }
+                    job->objects.reset();
+                    priced.push(std::move(result));
+                }
+                if (--pricers == 0)
+                    priced.close();
+            });
+        }
+    } catch (...) {
+        // A thread failed to start; let the ones running wind down
+        window.abort();
+        parsed.close();
+        built.close();
+        priced.close();
+        throw;
+    }
+
+    StreamStats stats;
+    const auto precision = out.precision(std::numeric_limits<double>::max_digits10);
+    try {
+        out << kPortfolioResultHeader << '\n';
+        std::map<std::size_t, Result> pending;      // finished out of order
+        std::size_t nextSeq = 0;
+        while (std::optional<Result> result = priced.pop()) {
+            pending.emplace(result->seq, std::move(*result));
+            for (auto it = pending.begin(); it != pending.end() && it->first == nextSeq;
+                 it = pending.erase(it), ++nextSeq) {
+                const Result& r = it->second;
+                writePortfolioResult(out, r.id, r.npv, r.error);
+                ++stats.trades;
+                if (!it->second.error.empty())
+                    ++stats.failed;
+                window.release();
+            }
+            QL_REQUIRE(out, "Failed to write pricing results");
+        }
+        out.flush();
+    } catch (...) {
+        window.abort();
+        out.precision(precision);
+        // Keep consuming so the workers can finish before the join
+        while (priced.pop()) {}
+        throw;
+    }
+    out.precision(precision);
+
+    if (readError)
+        std::rethrow_exception(readError);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,39 @@
+#include "PricingCancellation.hpp"
+
+#include <ql/discretizedasset.hpp>
+#include <ql/math/comparison.hpp>
+#include <ql/timegrid.hpp>
+
+using namespace QuantLib;
+
+thread_local const CancellationToken* CancellationToken::current_ = nullptr;
+
+PricingCancelled::PricingCancelled(Reason reason)
+    : std::runtime_error(reason == Cancelled ? "pricing job cancelled"
+                                             : "pricing job deadline expired"),
+      reason_(reason) {}
+
+void CancellationToken::check() const {
+    if (cancelled())
+        throw PricingCancelled(PricingCancelled::Cancelled);
+    if (deadline_ != Clock::time_point::max() && Clock::now() >= deadline_)
+        throw PricingCancelled(PricingCancelled::DeadlineExpired);
+}
+
+void rollbackWithCheckpoints(DiscretizedAsset& asset, double to) {
+    const TimeGrid& grid = asset.method()->timeGrid();
+    if (close(asset.time(), to)) {
+        asset.rollback(to);
+        return;
+    }
+    // rollback(grid[i]) applies the adjustment at grid[i], exactly as the
+    // single rollback does at every intermediate step
+    Size i = grid.index(asset.time());
+    const Size iTo = grid.index(to);
+    while (i > iTo + 1) {
+        CancellationToken::checkpoint();
+        asset.rollback(grid[--i]);
+    }
+    CancellationToken::checkpoint();
+    asset.rollback(to);
+}
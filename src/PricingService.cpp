@@ -0,0 +1,327 @@
+#include "PricingService.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "QuantLibSession.hpp"
+#include "ThreadPool.hpp"
+
+#include <ql/errors.hpp>
+#include <ql/settings.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <tuple>
+
+using namespace QuantLib;
+
+struct PricingService::Task {
+    JobPriority priority = JobPriority::Normal;
+    CancellationToken::Clock::time_point deadline;
+    std::uint64_t sequence = 0;
+    std::shared_ptr<CancellationToken> token;
+    Date date;
+    std::function<void()> run;                      // prices and fulfils the job
+    std::function<void(std::exception_ptr)> fail;   // fulfils it with an error instead
+};
+
+namespace {
+
+    // Shared by the chunks of one book job
+    struct BookState {
+        std::vector<BermudanTrade> trades;     // sorted so chunks are contiguous
+        std::vector<std::size_t> rows;         // trades[k] is row rows[k] of the input
+        std::vector<double> npvs;
+        std::atomic<std::size_t> remaining{0};
+        std::atomic<bool> settled{false};
+        std::promise<std::vector<double>> promise;
+    };
+
+    std::exception_ptr cancelled(PricingCancelled::Reason reason) {
+        return std::make_exception_ptr(PricingCancelled(reason));
+    }
+
+    thread_local bool runningJob = false;
+
+}
+
+bool PricingService::Order::operator()(const std::shared_ptr<Task>& a,
+                                       const std::shared_ptr<Task>& b) const {
+    return std::tie(a->priority, a->deadline, a->sequence) <
+           std::tie(b->priority, b->deadline, b->sequence);
+}
+
+PricingService::PricingService(const ServiceSettings& settings)
+    : settings_(settings) {
+    QL_REQUIRE(settings_.bookChunk > 0, "bookChunk must be positive");
+    const std::size_t n = settings_.workers
+        ? settings_.workers
+        : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    // At least one worker takes background jobs
+    backgroundSlots_ = n - std::min(settings_.reservedInteractive, n - 1);
+    threads_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        threads_.emplace_back([this] { workerLoop(); });
+}
+
+PricingService::~PricingService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        for (const auto& task : queue_)
+            task->fail(cancelled(PricingCancelled::Cancelled));
+        queue_.clear();
+        deadlines_.clear();
+        for (const Task* task : active_)
+            task->token->cancel();
+    }
+    wake_.notify_all();
+    for (auto& t : threads_)
+        t.join();
+}
+
+PricingJob<double> PricingService::submit(const BermudanTrade& trade, const JobOptions& options) {
+    auto promise = std::make_shared<std::promise<double>>();
+    auto task = std::make_shared<Task>();
+    task->priority = options.priority;
+    task->deadline = options.deadline;
+    task->token = std::make_shared<CancellationToken>(options.deadline);
+    task->date = trade.evaluationDate;
+    task->run = [promise, trade] {
+        promise->set_value(BermudanSwaptionPricer::priceTrade(trade));
+    };
+    task->fail = [promise](std::exception_ptr e) { promise->set_exception(e); };
+
+    PricingJob<double> job{promise->get_future(), task->token, this};
+    push(std::move(task));
+    return job;
+}
+
+PricingJob<void> PricingService::submitTask(const Date& date, std::function<void()> work,
+                                            const JobOptions& options) {
+    auto promise = std::make_shared<std::promise<void>>();
+    auto task = std::make_shared<Task>();
+    task->priority = options.priority;
+    task->deadline = options.deadline;
+    task->token = std::make_shared<CancellationToken>(options.deadline);
+    task->date = date;
+    task->run = [promise, work = std::move(work)] {
+        work();
+        promise->set_value();
+    };
+    task->fail = [promise](std::exception_ptr e) { promise->set_exception(e); };
+
+    PricingJob<void> job{promise->get_future(), task->token, this};
+    push(std::move(task));
+    return job;
+}
+
+PricingJob<std::vector<double>>
+PricingService::submitBook(std::vector<BermudanTrade> trades, const JobOptions& options) {
+    auto state = std::make_shared<BookState>();
+    auto token = std::make_shared<CancellationToken>(options.deadline);
+    PricingJob<std::vector<double>> job{state->promise.get_future(), token, this};
+
+    const std::size_t n = trades.size();
+    if (n == 0) {
+        state->promise.set_value({});
+        return job;
+    }
+
+    // Same-market rows next to each other, so a chunk prices few ladders
+    state->rows.resize(n);
+    std::iota(state->rows.begin(), state->rows.end(), std::size_t(0));
+    std::stable_sort(state->rows.begin(), state->rows.end(), [&](std::size_t a, std::size_t b) {
+        const BermudanTrade& x = trades[a];
+        const BermudanTrade& y = trades[b];
+        return std::tie(x.evaluationDate, x.model, x.engine, x.flatRate) <
+               std::tie(y.evaluationDate, y.model, y.engine, y.flatRate);
+    });
+    state->trades.reserve(n);
+    for (std::size_t r : state->rows)
+        state->trades.push_back(std::move(trades[r]));
+    state->npvs.resize(n);
+
+    // Chunks of at most bookChunk rows, never spanning two dates
+    std::vector<std::pair<std::size_t, std::size_t>> chunks;
+    for (std::size_t begin = 0; begin < n;) {
+        std::size_t end = begin + 1;
+        while (end < n && end - begin < settings_.bookChunk &&
+               state->trades[end].evaluationDate == state->trades[begin].evaluationDate)
+            ++end;
+        chunks.emplace_back(begin, end);
+        begin = end;
+    }
+    state->remaining = chunks.size();
+
+    std::vector<std::shared_ptr<Task>> tasks;
+    tasks.reserve(chunks.size());
+    for (auto [begin, end] : chunks) {
+        auto task = std::make_shared<Task>();
+        task->priority = options.priority;
+        task->deadline = options.deadline;
+        task->token = token;
+        task->date = state->trades[begin].evaluationDate;
+        task->run = [state, begin = begin, end = end, threads = options.threads,
+                     markets = options.markets] {
+            if (state->settled)
+                return;
+            const std::vector<double> npvs = BermudanSwaptionPricer::priceBook(
+                std::span<const BermudanTrade>(state->trades.data() + begin, end - begin),
+                threads, 64, markets);
+            for (std::size_t k = 0; k < npvs.size(); ++k)
+                state->npvs[state->rows[begin + k]] = npvs[k];
+            if (state->remaining.fetch_sub(1) == 1 && !state->settled.exchange(true))
+                state->promise.set_value(std::move(state->npvs));
+        };
+        // The first error settles the job; its other chunks are dropped
+        task->fail = [state, token](std::exception_ptr e) {
+            token->cancel();
+            if (!state->settled.exchange(true))
+                state->promise.set_exception(e);
+        };
+        tasks.push_back(std::move(task));
+    }
+    for (auto& task : tasks)
+        push(std::move(task));
+    return job;
+}
+
+void PricingService::cancel(const std::shared_ptr<CancellationToken>& token) {
+    token->cancel();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::shared_ptr<Task>> dropped;
+        for (const auto& task : queue_)
+            if (task->token == token)
+                dropped.push_back(task);
+        for (const auto& task : dropped) {
+            take(task);
+            task->fail(cancelled(PricingCancelled::Cancelled));
+        }
+    }
+    wake_.notify_all();
+}
+
+std::size_t PricingService::queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+std::size_t PricingService::running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_.size();
+}
+
+bool PricingService::inJob() {
+    return runningJob;
+}
+
+PricingService& PricingService::shared() {
+    // Constructed first so it outlives the service's workers at exit
+    ThreadPool::shared();
+    static PricingService service;
+    return service;
+}
+
+void PricingService::push(std::shared_ptr<Task> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+            task->fail(cancelled(PricingCancelled::Cancelled));
+            return;
+        }
+        task->sequence = sequence_++;
+        if (task->deadline != CancellationToken::Clock::time_point::max())
+            deadlines_.emplace(task->deadline, task);
+        queue_.insert(std::move(task));
+    }
+    // Workers turn down tasks they may not start (reserve, dates), so wake all
+    wake_.notify_all();
+}
+
+void PricingService::take(const std::shared_ptr<Task>& task) {
+    queue_.erase(task);
+    if (task->deadline == CancellationToken::Clock::time_point::max())
+        return;
+    auto [first, last] = deadlines_.equal_range(task->deadline);
+    for (auto it = first; it != last; ++it) {
+        if (it->second == task) {
+            deadlines_.erase(it);
+            return;
+        }
+    }
+}
+
+void PricingService::failExpired() {
+    const auto now = CancellationToken::Clock::now();
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+        const std::shared_ptr<Task> task = deadlines_.begin()->second;
+        take(task);
+        task->fail(cancelled(PricingCancelled::DeadlineExpired));
+    }
+}
+
+// Head of the queue if this worker may start it now; called under mutex_
+std::shared_ptr<PricingService::Task> PricingService::next() {
+    failExpired();
+    while (!queue_.empty() && (*queue_.begin())->token->cancelled()) {
+        const std::shared_ptr<Task> task = *queue_.begin();
+        take(task);
+        task->fail(cancelled(PricingCancelled::Cancelled));
+    }
+    if (queue_.empty())
+        return nullptr;
+
+    const std::shared_ptr<Task>& head = *queue_.begin();
+    if (head->priority != JobPriority::Interactive &&
+        activeBackground_ >= backgroundSlots_)
+        return nullptr;
+    if (!QuantLibSession::isolated() && !active_.empty() && head->date != activeDate_)
+        return nullptr;
+    return head;
+}
+
+void PricingService::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        const std::shared_ptr<Task> task = next();
+        if (!task) {
+            if (deadlines_.empty())
+                wake_.wait(lock);
+            else
+                wake_.wait_until(lock, deadlines_.begin()->first);
+            continue;
+        }
+        take(task);
+        if (!QuantLibSession::isolated() && active_.empty()) {
+            // No job is running, so the global date is ours to move; jobs
+            // that follow on the same date leave it alone
+            activeDate_ = task->date;
+            QuantLibSession::Guard guard;
+            if (Date(Settings::instance().evaluationDate()) != activeDate_)
+                Settings::instance().evaluationDate() = activeDate_;
+        }
+        active_.insert(task.get());
+        const bool background = task->priority != JobPriority::Interactive;
+        if (background)
+            ++activeBackground_;
+        lock.unlock();
+
+        runningJob = true;
+        try {
+            CancellationToken::Scope scope(task->token.get());
+            task->token->check();
+            task->run();
+        } catch (...) {
+            task->fail(std::current_exception());
+        }
+        runningJob = false;
+
+        lock.lock();
+        active_.erase(task.get());
+        if (background)
+            --activeBackground_;
+        wake_.notify_all();
+    }
+}
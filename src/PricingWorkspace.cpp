@@ -0,0 +1,80 @@
+#include "PricingWorkspace.hpp"
+
+#include <ql/errors.hpp>
+#include <algorithm>
+
+namespace {
+    constexpr std::size_t kFirstBlock = std::size_t(64) << 10;
+}
+
+PricingWorkspace::Scope::Scope(PricingWorkspace& workspace)
+    : workspace_(workspace), block_(workspace.current_), used_(workspace.used_) {
+    ++workspace_.depth_;
+}
+
+PricingWorkspace::Scope::~Scope() {
+    --workspace_.depth_;
+    workspace_.rewind(block_, used_);
+}
+
+void* PricingWorkspace::allocate(std::size_t bytes) {
+    if (bytes == 0)
+        return nullptr;
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+
+    if (!blocks_.empty() && used_ + bytes <= blocks_[current_].size) {
+        void* p = blocks_[current_].data.get() + used_;
+        used_ += bytes;
+        return p;
+    }
+
+    // Next block that fits, or a new one at least twice the last
+    std::size_t next = blocks_.empty() ? 0 : current_ + 1;
+    while (next < blocks_.size() && blocks_[next].size < bytes)
+        ++next;
+    if (next == blocks_.size()) {
+        const std::size_t size =
+            std::max(bytes, blocks_.empty() ? kFirstBlock : 2 * blocks_.back().size);
+        auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t(alignment)));
+        blocks_.push_back({std::unique_ptr<std::byte, Free>(data), size});
+    }
+    current_ = next;
+    used_ = bytes;
+    return blocks_[current_].data.get();
+}
+
+void PricingWorkspace::rewind(std::size_t block, std::size_t used) {
+    current_ = block;
+    used_ = used;
+    if (depth_ != 0 || block != 0 || used != 0 || blocks_.size() < 2)
+        return;
+
+    // Workspace emptied after spilling: one block big enough for the
+    // whole pass, so the next one stays inside it
+    const std::size_t total = capacity();
+    blocks_.clear();
+    auto* data = static_cast<std::byte*>(::operator new(total, std::align_val_t(alignment)));
+    blocks_.push_back({std::unique_ptr<std::byte, Free>(data), total});
+    current_ = 0;
+    used_ = 0;
+}
+
+std::size_t PricingWorkspace::capacity() const {
+    std::size_t total = 0;
+    for (const Block& b : blocks_)
+        total += b.size;
+    return total;
+}
+
+void PricingWorkspace::release() {
+    QL_REQUIRE(depth_ == 0, "cannot release a workspace inside a scope");
+    blocks_.clear();
+    blocks_.shrink_to_fit();
+    current_ = 0;
+    used_ = 0;
+}
+
+PricingWorkspace& PricingWorkspace::local() {
+    thread_local PricingWorkspace workspace;
+    return workspace;
+}
@@ -0,0 +1,32 @@
+#include "QuantLibSession.hpp"
+
+#include <atomic>
+
+#if defined(QL_ENABLE_SESSIONS)
+namespace QuantLib {
+
+    // Required by QuantLib when built with sessions: one session per thread.
+    // QL 1.25 signature.
+    Integer sessionId() {
+        static std::atomic<Integer> nextId{0};
+        thread_local Integer id = nextId++;
+        return id;
+    }
+
+}
+#endif
+
+std::recursive_mutex& QuantLibSession::globalMutex() {
+    static std::recursive_mutex m;
+    return m;
+}
+
+QuantLibSession::Guard::Guard() : locked_(!isolated()) {
+    if (locked_)
+        globalMutex().lock();
+}
+
+QuantLibSession::Guard::~Guard() {
+    if (locked_)
+        globalMutex().unlock();
+}
@@ -0,0 +1,75 @@
+#include "SchedulePool.hpp"
+
+#include <ql/errors.hpp>
+
+using namespace QuantLib;
+
+SchedulePool::SchedulePool(std::size_t capacity)
+    : capacity_(capacity) {
+    QL_REQUIRE(capacity_ > 0, "SchedulePool capacity must be positive");
+}
+
+ext::shared_ptr<const Schedule>
+SchedulePool::schedule(const Date& start, const Date& maturity, const Period& tenor,
+                       const Calendar& calendar, BusinessDayConvention convention,
+                       DateGeneration::Rule rule, bool endOfMonth) {
+    Key key(start, maturity, tenor.length(), tenor.units(), calendar.name(), convention, rule,
+            endOfMonth);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = schedules_.find(key);
+        if (it != schedules_.end()) {
+            ++hits_;
+            it->second.lastUse = ++clock_;
+            return it->second.schedule;
+        }
+        ++misses_;
+    }
+
+    // Generated outside the lock; if another thread got there first its
+    // copy wins, so every holder shares one instance.
+    auto generated = ext::make_shared<const Schedule>(start, maturity, tenor, calendar, convention,
+                                                      convention, rule, endOfMonth);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = schedules_.try_emplace(std::move(key));
+    if (inserted) {
+        it->second.schedule = std::move(generated);
+        if (schedules_.size() > capacity_) {
+            auto oldest = schedules_.end();
+            for (auto e = schedules_.begin(); e != schedules_.end(); ++e) {
+                if (e != it && (oldest == schedules_.end() || e->second.lastUse < oldest->second.lastUse))
+                    oldest = e;
+            }
+            schedules_.erase(oldest);
+        }
+    }
+    it->second.lastUse = ++clock_;
+    return it->second.schedule;
+}
+
+std::size_t SchedulePool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return schedules_.size();
+}
+
+void SchedulePool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    schedules_.clear();
+    hits_ = 0;
+    misses_ = 0;
+}
+
+std::uint64_t SchedulePool::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+std::uint64_t SchedulePool::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+SchedulePool& SchedulePool::shared() {
+    static SchedulePool pool;
+    return pool;
+}
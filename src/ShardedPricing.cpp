@@ -0,0 +1,367 @@
+#include "ShardedPricing.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "ThreadPool.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+extern char** environ;
+
+using namespace QuantLib;
+
+namespace {
+
+    constexpr char kBookMagic[8] = {'B', 'S', 'P', 'S', 'H', 'M', '1', '\0'};
+    constexpr std::size_t kMaxModelName = 8;
+    constexpr std::size_t kMaxParams = 8;
+    constexpr std::size_t kChunk = 256;     // rows per priceBook() call in a worker
+    constexpr std::size_t kMaxError = 256;  // error text per failed row, truncated
+
+    struct BookHeader {
+        char magic[8];
+        std::uint64_t rows;
+        std::uint64_t models;               // ParamEntry count
+        std::uint64_t paramsOffset;
+        std::uint64_t recordsOffset;        // PortfolioRecord per row
+    };
+
+    struct ParamEntry {
+        char model[kMaxModelName];
+        std::uint32_t count;
+        std::uint32_t reserved;
+        double values[kMaxParams];
+    };
+
+    enum SlotStatus : std::uint32_t { Pending = 0, Priced = 1, Failed = 2 };
+
+    struct ResultSlot {
+        double npv;
+        std::uint32_t status;
+        std::uint32_t reserved;
+    };
+
+    // Result segment: a ResultSlot per row, then a kMaxError text block per
+    // row, only written (and so only backed by memory) for failed rows
+    std::size_t resultsSize(std::uint64_t rows) {
+        return rows * (sizeof(ResultSlot) + kMaxError);
+    }
+
+    char* errorText(unsigned char* results, std::uint64_t rows, std::uint64_t i) {
+        return reinterpret_cast<char*>(results + rows * sizeof(ResultSlot) + i * kMaxError);
+    }
+
+    // Mapped POSIX shared-memory object; the creating side unlinks it.
+    class SharedSegment {
+    public:
+        static SharedSegment create(const std::string& name, std::size_t size) {
+            const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            QL_REQUIRE(fd >= 0, "Cannot create shared memory " << name << ": "
+                       << std::strerror(errno));
+            SharedSegment segment(name, fd, true);
+            QL_REQUIRE(::ftruncate(fd, static_cast<off_t>(size)) == 0,
+                       "Cannot size shared memory " << name << ": " << std::strerror(errno));
+            segment.map(size, true);
+            return segment;
+        }
+
+        static SharedSegment open(const std::string& name, bool writable) {
+            const int fd = ::shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+            QL_REQUIRE(fd >= 0, "Cannot open shared memory " << name << ": "
+                       << std::strerror(errno));
+            SharedSegment segment(name, fd, false);
+            struct stat st;
+            QL_REQUIRE(::fstat(fd, &st) == 0, "Cannot stat shared memory " << name);
+            segment.map(static_cast<std::size_t>(st.st_size), writable);
+            return segment;
+        }
+
+        SharedSegment(SharedSegment&& other) noexcept
+        : name_(std::move(other.name_)), fd_(other.fd_), owner_(other.owner_),
+          data_(other.data_), size_(other.size_) {
+            other.fd_ = -1;
+            other.owner_ = false;
+            other.data_ = nullptr;
+        }
+
+        SharedSegment& operator=(SharedSegment&&) = delete;
+
+        ~SharedSegment() {
+            if (data_)
+                ::munmap(data_, size_);
+            if (fd_ >= 0)
+                ::close(fd_);
+            if (owner_)
+                ::shm_unlink(name_.c_str());
+        }
+
+        unsigned char* data() const { return data_; }
+        std::size_t size() const { return size_; }
+
+    private:
+        SharedSegment(std::string name, int fd, bool owner)
+        : name_(std::move(name)), fd_(fd), owner_(owner) {}
+
+        void map(std::size_t size, bool writable) {
+            size_ = size;
+            if (size == 0)
+                return;
+            void* data = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                                MAP_SHARED, fd_, 0);
+            QL_REQUIRE(data != MAP_FAILED, "Cannot map shared memory " << name_ << ": "
+                       << std::strerror(errno));
+            data_ = static_cast<unsigned char*>(data);
+        }
+
+        std::string name_;
+        int fd_ = -1;
+        bool owner_ = false;
+        unsigned char* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+
+    std::string resultsName(const std::string& segment) {
+        return segment + "-results";
+    }
+
+    std::string uniqueName() {
+        static std::atomic<unsigned> counter{0};
+        return "/bermudan-" + std::to_string(::getpid()) + "-" + std::to_string(counter++);
+    }
+
+    // Rows [begin, end) of shard index of count
+    std::pair<std::uint64_t, std::uint64_t> shardRows(std::uint64_t rows, std::size_t index,
+                                                      std::size_t count) {
+        return {rows * index / count, rows * (index + 1) / count};
+    }
+
+    PortfolioRow rowAt(const unsigned char* book, const BookHeader& header, std::uint64_t i) {
+        PortfolioRecord record;
+        std::memcpy(&record, book + header.recordsOffset + i * sizeof record, sizeof record);
+        PortfolioRow row;
+        decodeRecord(record, row);
+        return row;
+    }
+
+    std::string describe(int status) {
+        if (WIFEXITED(status))
+            return "exited with status " + std::to_string(WEXITSTATUS(status));
+        if (WIFSIGNALED(status))
+            return "killed by signal " + std::to_string(WTERMSIG(status));
+        return "stopped";
+    }
+
+}
+
+
+void runShardWorker(const std::string& segment, std::size_t index, std::size_t count,
+                    std::size_t threads) {
+    QL_REQUIRE(count > 0 && index < count, "Invalid shard " << index << " of " << count);
+    // Zero would be the shared pool, whose threads a forked worker lacks
+    QL_REQUIRE(threads > 0, "A shard worker needs at least one thread");
+
+    const SharedSegment book = SharedSegment::open(segment, false);
+    QL_REQUIRE(book.size() >= sizeof(BookHeader), "Shared book " << segment << " is truncated");
+    BookHeader header;
+    std::memcpy(&header, book.data(), sizeof header);
+    QL_REQUIRE(std::memcmp(header.magic, kBookMagic, sizeof kBookMagic) == 0,
+               segment << " is not a shared book");
+    QL_REQUIRE(header.recordsOffset + header.rows * sizeof(PortfolioRecord) <= book.size(),
+               "Shared book " << segment << " is truncated");
+
+    std::map<std::string, std::vector<double>> params;
+    for (std::uint64_t m = 0; m < header.models; ++m) {
+        ParamEntry entry;
+        std::memcpy(&entry, book.data() + header.paramsOffset + m * sizeof entry, sizeof entry);
+        params[std::string(entry.model, strnlen(entry.model, kMaxModelName))]
+            .assign(entry.values, entry.values + entry.count);
+    }
+
+    const SharedSegment results = SharedSegment::open(resultsName(segment), true);
+    QL_REQUIRE(results.size() >= resultsSize(header.rows),
+               "Result segment of " << segment << " is truncated");
+    auto* slots = reinterpret_cast<ResultSlot*>(results.data());
+
+    const auto [begin, end] = shardRows(header.rows, index, count);
+    std::vector<BermudanTrade> trades;
+    for (std::uint64_t first = begin; first < end; first += kChunk) {
+        const std::uint64_t last = std::min<std::uint64_t>(end, first + kChunk);
+        trades.clear();
+        for (std::uint64_t i = first; i < last; ++i) {
+            BermudanTrade trade = rowAt(book.data(), header, i).trade;
+            auto it = params.find(trade.model);
+            if (it != params.end())
+                trade.modelParams = it->second;
+            trades.push_back(std::move(trade));
+        }
+
+        try {
+            const std::vector<double> npvs = BermudanSwaptionPricer::priceBook(trades, threads);
+            for (std::size_t k = 0; k < npvs.size(); ++k)
+                slots[first + k] = {npvs[k], Priced, 0};
+        } catch (const std::exception&) {
+            // One bad trade fails the whole chunk; isolate it
+            for (std::size_t k = 0; k < trades.size(); ++k) {
+                try {
+                    slots[first + k] = {BermudanSwaptionPricer::priceTrade(trades[k]), Priced, 0};
+                } catch (const std::exception& e) {
+                    slots[first + k] = {std::numeric_limits<double>::quiet_NaN(), Failed, 0};
+                    std::strncpy(errorText(results.data(), header.rows, first + k), e.what(),
+                                 kMaxError - 1);
+                }
+            }
+        }
+    }
+}
+
+StreamStats priceSharded(const std::string& portfolio, std::ostream& out,
+                         const MarketSnapshot& market, const ShardSettings& settings) {
+    QL_REQUIRE(settings.threadsPerWorker > 0, "A shard worker needs at least one thread");
+    const auto start = std::chrono::steady_clock::now();
+
+    std::uint64_t rows = 0;
+    {
+        auto reader = PortfolioReader::open(portfolio);
+        PortfolioRow row;
+        while (reader->next(row))
+            ++rows;
+    }
+
+    for (const auto& [model, values] : market.modelParams) {
+        QL_REQUIRE(!model.empty() && model.size() <= kMaxModelName,
+                   "Model name '" << model << "' does not fit the shared book");
+        QL_REQUIRE(values.size() <= kMaxParams,
+                   values.size() << " parameters for " << model << ", at most " << kMaxParams);
+    }
+
+    BookHeader header{};
+    std::memcpy(header.magic, kBookMagic, sizeof kBookMagic);
+    header.rows = rows;
+    header.models = market.modelParams.size();
+    header.paramsOffset = sizeof(BookHeader);
+    header.recordsOffset = header.paramsOffset + header.models * sizeof(ParamEntry);
+
+    const std::string name = uniqueName();
+    SharedSegment book = SharedSegment::create(
+        name, header.recordsOffset + rows * sizeof(PortfolioRecord));
+    std::memcpy(book.data(), &header, sizeof header);
+    std::uint64_t m = 0;
+    for (const auto& [model, values] : market.modelParams) {
+        ParamEntry entry{};
+        std::memcpy(entry.model, model.data(), model.size());
+        entry.count = static_cast<std::uint32_t>(values.size());
+        std::copy(values.begin(), values.end(), entry.values);
+        std::memcpy(book.data() + header.paramsOffset + m++ * sizeof entry, &entry, sizeof entry);
+    }
+    {
+        auto reader = PortfolioReader::open(portfolio);
+        PortfolioRow row;
+        for (std::uint64_t i = 0; i < rows; ++i) {
+            QL_REQUIRE(reader->next(row), "Portfolio " << portfolio << " changed while loading");
+            const PortfolioRecord record = encodeRecord(row);
+            std::memcpy(book.data() + header.recordsOffset + i * sizeof record, &record,
+                        sizeof record);
+        }
+    }
+    const SharedSegment results =
+        SharedSegment::create(resultsName(name), resultsSize(rows));   // zero: Pending
+
+    std::size_t workers = settings.workers != 0
+        ? settings.workers
+        : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    workers = std::max<std::uint64_t>(1, std::min<std::uint64_t>(workers, rows));
+
+    // fork() only duplicates the calling thread; with the shared pools
+    // running, the child could inherit a mutex one of them holds
+    QL_REQUIRE(!settings.workerExecutable.empty() || !ThreadPool::sharedStarted(),
+               "Cannot fork shard workers once the shared thread pool is running; "
+               "set ShardSettings::workerExecutable");
+
+    std::vector<pid_t> pids;
+    std::string launchError;
+    for (std::size_t i = 0; i < workers && launchError.empty(); ++i) {
+        pid_t pid = -1;
+        if (settings.workerExecutable.empty()) {
+            std::fflush(nullptr);   // do not duplicate buffered output
+            pid = ::fork();
+            if (pid == 0) {
+                int code = 0;
+                try {
+                    runShardWorker(name, i, workers, settings.threadsPerWorker);
+                } catch (const std::exception& e) {
+                    std::fprintf(stderr, "shard %zu: %s\n", i, e.what());
+                    code = 1;
+                }
+                std::_Exit(code);   // none of the parent's exit handlers
+            }
+            if (pid < 0)
+                launchError = std::strerror(errno);
+        } else {
+            std::vector<std::string> args = {settings.workerExecutable, "--worker", name,
+                                             std::to_string(i), std::to_string(workers),
+                                             std::to_string(settings.threadsPerWorker)};
+            std::vector<char*> argv;
+            for (std::string& a : args)
+                argv.push_back(a.data());
+            argv.push_back(nullptr);
+            const int rc = ::posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ);
+            if (rc != 0)
+                launchError = std::strerror(rc);
+        }
+        if (launchError.empty())
+            pids.push_back(pid);
+    }
+
+    std::vector<int> statuses(pids.size(), 0);
+    for (std::size_t i = 0; i < pids.size(); ++i)
+        while (::waitpid(pids[i], &statuses[i], 0) < 0 && errno == EINTR) {}
+    QL_REQUIRE(launchError.empty(), "Cannot start shard worker " << pids.size() << ": "
+               << launchError);
+
+    StreamStats stats;
+    const auto* slots = reinterpret_cast<const ResultSlot*>(results.data());
+    const auto precision = out.precision(std::numeric_limits<double>::max_digits10);
+    out << kPortfolioResultHeader << '\n';
+    for (std::size_t w = 0; w < workers; ++w) {
+        const auto [begin, end] = shardRows(rows, w, workers);
+        for (std::uint64_t i = begin; i < end; ++i) {
+            const PortfolioRow row = rowAt(book.data(), header, i);
+            double npv = slots[i].npv;
+            std::string error;
+            if (slots[i].status == Failed) {
+                const char* text = errorText(results.data(), rows, i);
+                error.assign(text, strnlen(text, kMaxError));
+                if (error.empty())
+                    error = "pricing failed";
+            } else if (slots[i].status == Pending) {
+                error = "shard worker " + std::to_string(w) + " " + describe(statuses[w]);
+            }
+            writePortfolioResult(out, row.id, error.empty() ? npv
+                                                            : std::numeric_limits<double>::quiet_NaN(),
+                                 error);
+            ++stats.trades;
+            if (!error.empty())
+                ++stats.failed;
+        }
+    }
+    out.precision(precision);
+    out.flush();
+    QL_REQUIRE(out, "Failed to write pricing results");
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
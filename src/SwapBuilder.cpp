@@ -1,66 +1,56 @@
 #include "SwapBuilder.hpp"
+#include "Metrics.hpp"
+#include "SchedulePool.hpp"
 
 #include <ql/pricingengines/swap/discountingswapengine.hpp>
-#include <ql/time/calendars/target.hpp>
-#include <ql/time/daycounters/thirty360.hpp>
-#include <ql/time/dategenerationrule.hpp>
 
 using namespace QuantLib;
 
-namespace {
-    constexpr Frequency kFixedLegFrequency = Annual;
-    constexpr Frequency kFloatLegFrequency = Semiannual;
-    const BusinessDayConvention kFixedLegBDC = Unadjusted;
-    const BusinessDayConvention kFloatLegBDC = ModifiedFollowing;
-    const DayCounter kFixedLegDC = Thirty360(Thirty360::European);
-}
-
-SwapBuilder::SwapBuilder(const Handle<YieldTermStructure>& termStructure)
-    : termStructure_(termStructure) {
+SwapBuilder::SwapBuilder(const Handle<YieldTermStructure>& termStructure,
+                         const SwapDescription& description)
+    : termStructure_(termStructure), description_(description) {
     QL_REQUIRE(!termStructure_.empty(), "Term structure handle is empty");
+    QL_REQUIRE(description_.notional > 0.0, "Swap notional must be positive");
+    BERMUDAN_TIME_STAGE(Stage::SwapBuild);
 
+    const SwapDescription& d = description_;
     Date settlementDate = termStructure_->referenceDate();
-    Calendar cal = TARGET();
-
-    Date start = cal.advance(settlementDate, 1, Years, kFloatLegBDC);
-    Date maturity = cal.advance(start, 5, Years, kFloatLegBDC);
 
-    fixedSchedule_ = Schedule(start, maturity, Period(kFixedLegFrequency),
-                              cal, kFixedLegBDC, kFixedLegBDC,
-                              DateGeneration::Forward, false);
+    Date start = d.calendar.advance(settlementDate, d.forwardStart, d.floatConvention);
+    Date maturity = d.calendar.advance(start, d.tenor, d.floatConvention);
 
-    floatSchedule_ = Schedule(start, maturity, Period(kFloatLegFrequency),
-                              cal, kFloatLegBDC, kFloatLegBDC,
-                              DateGeneration::Forward, false);
+    SchedulePool& pool = SchedulePool::shared();
+    fixedSchedule_ = pool.schedule(start, maturity, Period(d.fixedFrequency), d.calendar,
+                                   d.fixedConvention, d.rule, d.endOfMonth);
+    floatSchedule_ = pool.schedule(start, maturity, Period(d.floatFrequency), d.calendar,
+                                   d.floatConvention, d.rule, d.endOfMonth);
 
-    indexSixMonths_ = ext::make_shared<Euribor6M>(termStructure_);
+    index_ = ext::make_shared<Euribor>(Period(d.floatFrequency), termStructure_);
 }
 
 ext::shared_ptr<VanillaSwap>
 SwapBuilder::buildSwap(Rate fixedRate) const {
+    BERMUDAN_TIME_STAGE(Stage::SwapBuild);
+    const SwapDescription& d = description_;
     auto swap = ext::make_shared<VanillaSwap>(
-        Swap::Payer,
-        1000.0,
-        fixedSchedule_, fixedRate, kFixedLegDC,
-        floatSchedule_, ext::static_pointer_cast<IborIndex>(indexSixMonths_), 0.0,
-        indexSixMonths_->dayCounter());
+        d.type, d.notional,
+        *fixedSchedule_, fixedRate, d.fixedDayCounter,
+        *floatSchedule_, ext::static_pointer_cast<IborIndex>(index_), 0.0,
+        d.floatDayCounter);
 
     swap->setPricingEngine(ext::make_shared<DiscountingSwapEngine>(termStructure_));
     return swap;
 }
 
 Rate SwapBuilder::fairRate() const {
+    BERMUDAN_TIME_STAGE(Stage::FairRate);
+    const SwapDescription& d = description_;
     auto swap = ext::make_shared<VanillaSwap>(
-        Swap::Payer,
-        1000.0,
-        fixedSchedule_, /*dummy*/ 0.03, kFixedLegDC,
-        floatSchedule_, ext::static_pointer_cast<IborIndex>(indexSixMonths_), 0.0,
-        indexSixMonths_->dayCounter());
+        d.type, d.notional,
+        *fixedSchedule_, /*dummy*/ 0.03, d.fixedDayCounter,
+        *floatSchedule_, ext::static_pointer_cast<IborIndex>(index_), 0.0,
+        d.floatDayCounter);
 
     swap->setPricingEngine(ext::make_shared<DiscountingSwapEngine>(termStructure_));
     return swap->fairRate();
 }
-
-Schedule SwapBuilder::fixedSchedule() const { return fixedSchedule_; }
-Schedule SwapBuilder::floatSchedule() const { return floatSchedule_; }
-
@@ -1,35 +1,225 @@
 #include "SwaptionCalibrator.hpp"
+#include "CalibrationCache.hpp"
+#include "Metrics.hpp"
+#include "ThreadPool.hpp"
 
 #include <ql/models/model.hpp>                            // CalibratedModel
 #include <ql/math/optimization/levenbergmarquardt.hpp>
 #include <ql/math/optimization/endcriteria.hpp>
+#include <ql/math/optimization/costfunction.hpp>
+#include <ql/math/optimization/problem.hpp>
 #include <ql/models/shortrate/calibrationhelpers/swaptionhelper.hpp>
 #include <ql/math/optimization/constraint.hpp>            // Constraint (singular header in QL 1.25)
+#include <ql/pricingengines/swaption/fdg2swaptionengine.hpp>
+#include <ql/pricingengines/swaption/fdhullwhiteswaptionengine.hpp>
+#include <ql/settings.hpp>
+#include <ql/termstructures/yieldtermstructure.hpp>
 #include <algorithm>
+#include <cmath>
+#include <optional>
+#include <set>
+#include <typeinfo>
 
 using namespace QuantLib;
 
+namespace {
+
+    // Curve fingerprint times (years from the reference date)
+    const double kCurvePillars[] = {0.25, 0.5, 1, 2, 3, 4, 5, 7, 10, 12, 15, 20, 25, 30};
+
+    // CalibratedModel::CalibrationFunction with unit weights and no fixed
+    // parameters, repricing the helpers on a pool. Parameters are set once
+    // per evaluation on the calling thread; only the pricing fans out.
+    class ParallelCalibrationFunction : public CostFunction {
+    public:
+        ParallelCalibrationFunction(CalibratedModel& model,
+                                    const std::vector<ext::shared_ptr<BlackCalibrationHelper>>& helpers,
+                                    ThreadPool* pool)
+            : model_(model), helpers_(helpers), pool_(pool) {}
+
+        Real value(const Array& params) const override {
+            const Array errors = values(params);
+            return std::sqrt(DotProduct(errors, errors));
+        }
+
+        Disposable<Array> values(const Array& params) const override {
+            model_.setParams(params);
+            ++evaluations_;
+            Array errors(helpers_.size());
+            // The first pass builds each helper's swap and swaption, which
+            // registers coupons with the shared index: keep it serial.
+            if (pool_ && primed_) {
+                pool_->parallelFor(helpers_.size(), [&](std::size_t i) {
+                    errors[i] = helpers_[i]->calibrationError();
+                });
+            } else {
+                for (Size i = 0; i < helpers_.size(); ++i)
+                    errors[i] = helpers_[i]->calibrationError();
+                primed_ = true;
+            }
+            return errors;
+        }
+
+        Size evaluations() const { return evaluations_; }
+
+    private:
+        CalibratedModel& model_;
+        const std::vector<ext::shared_ptr<BlackCalibrationHelper>>& helpers_;
+        ThreadPool* pool_;
+        mutable bool primed_ = false;
+        mutable Size evaluations_ = 0;
+    };
+
+    // BlackCalibrationHelper keeps its engine protected, with no accessor
+    struct HelperEngine : BlackCalibrationHelper {
+        static const PricingEngine* of(const BlackCalibrationHelper& helper) {
+            return (helper.*(&HelperEngine::engine_)).get();
+        }
+    };
+
+    // Concurrent calibrationError() calls on helpers sharing an engine write
+    // the same arguments and results; the FD engines clone the swap's index
+    // on every call, which registers with global observables
+    bool needsSerialRepricing(const std::vector<ext::shared_ptr<BlackCalibrationHelper>>& helpers) {
+        std::set<const PricingEngine*> engines;
+        for (const auto& helper : helpers) {
+            const PricingEngine* engine = HelperEngine::of(*helper);
+            if (!engine)
+                continue;
+            if (!engines.insert(engine).second ||
+                dynamic_cast<const FdHullWhiteSwaptionEngine*>(engine) ||
+                dynamic_cast<const FdG2SwaptionEngine*>(engine))
+                return true;
+        }
+        return false;
+    }
+
+    // CalibratedModel keeps the outcome of its last calibrate() protected;
+    // calibrateModel() runs its own problem and records it the same way
+    struct ModelFit : CalibratedModel {
+        static void record(CalibratedModel& model, EndCriteria::Type endCriteria,
+                           const Array& values, Integer evaluations) {
+            model.*(&ModelFit::shortRateEndCriteria_) = endCriteria;
+            model.*(&ModelFit::problemValues_) = values;
+            model.*(&ModelFit::functionEvaluation_) = evaluations;
+        }
+    };
+
+}
+
 SwaptionCalibrator::SwaptionCalibrator(
     const std::vector<QuantLib::ext::shared_ptr<QuantLib::BlackCalibrationHelper>>& swaptions,
     const std::vector<double>& marketVols,
-    const std::vector<int>& swapLengths)
+    const std::vector<int>& swapLengths,
+    const Handle<YieldTermStructure>& curve)
     : swaptions_(swaptions),
       marketVols_(marketVols),
-      swapLengths_(swapLengths) {}
+      swapLengths_(swapLengths),
+      curve_(curve) {}
+
+std::uint64_t SwaptionCalibrator::snapshotKey(const CalibratedModel& model,
+                                              const OptimizationMethod& method,
+                                              const CalibrationSettings& settings) const {
+    SnapshotHash h;
+    h.add(static_cast<std::int64_t>(Settings::instance().evaluationDate().serialNumber()));
+    if (!curve_.empty()) {
+        h.add(static_cast<std::int64_t>(curve_->referenceDate().serialNumber()));
+        for (double t : kCurvePillars)
+            h.add(curve_->discount(t, true));
+    }
+    h.add(static_cast<std::int64_t>(marketVols_.size()));
+    for (double v : marketVols_)
+        h.add(v);
+    h.add(static_cast<std::int64_t>(swapLengths_.size()));
+    for (int l : swapLengths_)
+        h.add(static_cast<std::int64_t>(l));
+    // Black prices pin down the helpers' strikes, tenors and the curve they see
+    h.add(static_cast<std::int64_t>(swaptions_.size()));
+    for (const auto& helper : swaptions_)
+        h.add(helper->marketValue());
 
-void SwaptionCalibrator::calibrateModel(
+    h.add(std::string(typeid(model).name()));
+    h.add(std::string(typeid(method).name()));
+    h.add(static_cast<std::int64_t>(settings.maxIterations));
+    h.add(static_cast<std::int64_t>(settings.maxStationaryIterations));
+    h.add(settings.rootEpsilon);
+    h.add(settings.functionEpsilon);
+    h.add(settings.gradientNormEpsilon);
+    h.add(static_cast<std::int64_t>(settings.initialGuess.size()));
+    for (double g : settings.initialGuess)
+        h.add(g);
+    h.add(settings.cacheTag);
+    return h.value();
+}
+
+CalibrationResult SwaptionCalibrator::calibrateModel(
     const QuantLib::ext::shared_ptr<QuantLib::CalibratedModel>& model,
-    QuantLib::OptimizationMethod& method) {
+    QuantLib::OptimizationMethod& method,
+    const CalibrationSettings& settings) {
 
     QL_REQUIRE(model, "Null model");
     QL_REQUIRE(!swaptions_.empty(), "No swaptions provided");
+    BERMUDAN_TIME_STAGE(Stage::Calibration);
 
-    std::vector<QuantLib::ext::shared_ptr<CalibrationHelper>> helpers(swaptions_.begin(),
-                                                                      swaptions_.end());
+    const std::string modelType = typeid(*model).name();
 
-    EndCriteria ec(400, 100, 1e-8, 1e-8, 1e-8);
+    std::uint64_t key = 0;
+    if (settings.cache) {
+        key = snapshotKey(*model, method, settings);
+        if (auto cached = settings.cache->find(key)) {
+            CalibrationResult result;
+            result.parameters = Array(cached->begin(), cached->end());
+            result.fromCache = true;
+            BERMUDAN_COUNT(Counter::CalibrationCacheHits, 1);
+            model->setParams(result.parameters);
+            ModelFit::record(*model, EndCriteria::None, Array(), 0);
+            warmStarts_[modelType] = result.parameters;
+            return result;
+        }
+    }
 
-    // Use full overload for QL 1.25
-    model->calibrate(helpers, method, ec, Constraint(), std::vector<double>(), std::vector<bool>());
-}
+    Array start = model->params();
+    if (!settings.initialGuess.empty()) {
+        QL_REQUIRE(settings.initialGuess.size() == start.size(),
+                   "initial guess has " << settings.initialGuess.size()
+                   << " parameters, model has " << start.size());
+        std::copy(settings.initialGuess.begin(), settings.initialGuess.end(), start.begin());
+    } else if (settings.warmStart) {
+        auto previous = warmStarts_.find(modelType);
+        if (previous != warmStarts_.end() && previous->second.size() == start.size())
+            start = previous->second;
+    }
 
+    const bool parallel = settings.threads != 1 && !needsSerialRepricing(swaptions_);
+    std::optional<ThreadPool> ownPool;
+    if (parallel && settings.threads > 1)
+        ownPool.emplace(settings.threads);
+    ThreadPool* pool = !parallel ? nullptr
+                     : ownPool ? &*ownPool : &ThreadPool::shared();
+
+    EndCriteria ec(settings.maxIterations, settings.maxStationaryIterations,
+                   settings.rootEpsilon, settings.functionEpsilon, settings.gradientNormEpsilon);
+
+    ParallelCalibrationFunction f(*model, swaptions_, pool);
+    Problem problem(f, *model->constraint(), start);
+
+    CalibrationResult result;
+    result.endCriteria = method.minimize(problem, ec);
+    result.parameters = problem.currentValue();
+    result.evaluations = f.evaluations();
+    result.parallel = parallel;
+    // As CalibratedModel::calibrate: endCriteria(), problemValues() and
+    // functionEvaluation() describe this fit
+    model->setParams(result.parameters);
+    const Array errors = problem.values(result.parameters);
+    ModelFit::record(*model, result.endCriteria, errors,
+                     static_cast<Integer>(problem.functionEvaluation()));
+    BERMUDAN_COUNT(Counter::OptimizerEvaluations, result.evaluations);
+    BERMUDAN_COUNT(Counter::OptimizerGradients, problem.gradientEvaluation());
+
+    warmStarts_[modelType] = result.parameters;
+    if (settings.cache)
+        settings.cache->insert(key, std::vector<double>(result.parameters.begin(),
+                                                        result.parameters.end()));
+    return result;
+}
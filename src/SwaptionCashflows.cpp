@@ -0,0 +1,44 @@
+#include "SwaptionCashflows.hpp"
+
+using namespace QuantLib;
+
+namespace {
+    // Reset date as DiscretizedSwaption sees it
+    Date snapped(const Date& d, const std::vector<Date>& exercises) {
+        Date result = d;
+        for (const Date& exercise : exercises)
+            if (result >= exercise - 7 && result <= exercise)
+                result = exercise;
+        return result;
+    }
+}
+
+std::vector<SwaptionCashflow>
+swaptionCashflows(const Swaption::arguments& args, const Date& referenceDate) {
+    std::vector<SwaptionCashflow> cashflows;
+    swaptionCashflows(args, referenceDate, cashflows);
+    return cashflows;
+}
+
+void swaptionCashflows(const Swaption::arguments& args, const Date& referenceDate,
+                       std::vector<SwaptionCashflow>& cashflows) {
+    const std::vector<Date>& exercises = args.exercise->dates();
+    const Real sign = args.type == Swap::Payer ? 1.0 : -1.0;
+    cashflows.clear();
+    cashflows.reserve(args.fixedResetDates.size() + args.floatingResetDates.size());
+    for (Size i = 0; i < args.fixedResetDates.size(); ++i) {
+        const Date reset = snapped(args.fixedResetDates[i], exercises);
+        if (reset < referenceDate)
+            continue;
+        cashflows.push_back({reset, args.fixedPayDates[i], 0.0, -sign * args.fixedCoupons[i]});
+    }
+    for (Size i = 0; i < args.floatingResetDates.size(); ++i) {
+        const Date reset = snapped(args.floatingResetDates[i], exercises);
+        if (reset < referenceDate)
+            continue;
+        const Real accruedSpread =
+            args.nominal * args.floatingAccrualTimes[i] * args.floatingSpreads[i];
+        cashflows.push_back({reset, args.floatingPayDates[i],
+                             sign * args.nominal, sign * (accruedSpread - args.nominal)});
+    }
+}
@@ -0,0 +1,174 @@
+#include "ThreadPool.hpp"
+#include "PricingCancellation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace {
+    struct WorkerIdentity {
+        const ThreadPool* pool = nullptr;
+        std::size_t index = 0;
+    };
+    thread_local WorkerIdentity tlsWorker;
+
+    constexpr std::size_t kNoQueue = static_cast<std::size_t>(-1);
+
+    std::atomic<bool> sharedPoolStarted{false};
+}
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0)
+        threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+    queues_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+        threads_.emplace_back([this, i]() { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_)
+        t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    std::size_t target;
+    if (tlsWorker.pool == this)
+        target = tlsWorker.index;
+    else
+        target = next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queued_.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::tryRunOne(std::size_t self) {
+    std::function<void()> task;
+
+    if (self != kNoQueue) {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    const std::size_t n = queues_.size();
+    const std::size_t start = (self == kNoQueue) ? 0 : self + 1;
+    for (std::size_t k = 0; !task && k < n; ++k) {
+        Queue& victim = *queues_[(start + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task)
+        return false;
+
+    queued_.fetch_sub(1);
+    task();
+    if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        idle_.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+    tlsWorker = WorkerIdentity{this, index};
+    for (;;) {
+        if (tryRunOne(index))
+            continue;
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this]() { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0)
+            return;
+    }
+}
+
+void ThreadPool::wait() {
+    const std::size_t self = (tlsWorker.pool == this) ? tlsWorker.index : kNoQueue;
+    while (pending_ > 0) {
+        if (tryRunOne(self))
+            continue;
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        idle_.wait_for(lock, std::chrono::milliseconds(1),
+                       [this]() { return pending_ == 0; });
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t n,
+                             const std::function<void(std::size_t)>& body,
+                             std::size_t grain) {
+    if (n == 0)
+        return;
+    grain = std::max<std::size_t>(1, grain);
+    const std::size_t chunks = (n + grain - 1) / grain;
+
+    std::atomic<std::size_t> remaining{chunks};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    // The caller's job, if any, follows its chunks onto whichever thread
+    // runs them; a cancelled job starts no further chunks
+    const CancellationToken* token = CancellationToken::current();
+
+    for (std::size_t c = 0; c < chunks; ++c) {
+        const std::size_t begin = c * grain;
+        const std::size_t end = std::min(n, begin + grain);
+        submit([&, begin, end]() {
+            CancellationToken::Scope scope(token);
+            try {
+                CancellationToken::checkpoint();
+                for (std::size_t i = begin; i < end; ++i)
+                    body(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+            remaining.fetch_sub(1);
+        });
+    }
+
+    // Help drain the queues until our own chunks are done; this keeps
+    // nested parallelFor calls from worker threads deadlock-free.
+    const std::size_t self = (tlsWorker.pool == this) ? tlsWorker.index : kNoQueue;
+    while (remaining > 0) {
+        if (!tryRunOne(self))
+            std::this_thread::yield();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    sharedPoolStarted.store(true, std::memory_order_relaxed);
+    return pool;
+}
+
+bool ThreadPool::sharedStarted() {
+    return sharedPoolStarted.load(std::memory_order_relaxed);
+}
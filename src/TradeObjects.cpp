@@ -0,0 +1,40 @@
+#include "TradeObjects.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "QuantLibSession.hpp"
+#include "SwapBuilder.hpp"
+#include "YieldCurveBuilder.hpp"
+
+#include <ql/time/calendars/target.hpp>
+
+using namespace QuantLib;
+
+TradeObjects::TradeObjects(const BermudanTrade& trade) {
+    QuantLibSession::Guard guard;
+    try {
+        Date settlement = TARGET().advance(trade.evaluationDate, 2, Days);
+        ts = YieldCurveBuilder(trade.flatRate).buildCurve(settlement);
+        SwapBuilder sb(ts, trade.swap);
+        swap = sb.buildSwap(sb.fairRate() * trade.strikeMultiplier);
+        model = BermudanSwaptionPricer::makeModel(trade.model, ts);
+        if (!trade.modelParams.empty()) {
+            QL_REQUIRE(trade.modelParams.size() == model->params().size(),
+                       trade.modelParams.size() << " model parameters given, " << trade.model
+                       << " has " << model->params().size());
+            model->setParams(Array(trade.modelParams.begin(), trade.modelParams.end()));
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+TradeObjects::~TradeObjects() {
+    QuantLibSession::Guard guard;
+    release();
+}
+
+void TradeObjects::release() {
+    model.reset();
+    swap.reset();
+    ts = Handle<YieldTermStructure>();
+}
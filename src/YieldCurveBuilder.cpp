@@ -1,4 +1,5 @@
 #include "YieldCurveBuilder.hpp"
+#include "Metrics.hpp"
 
 #include <ql/quotes/simplequote.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
@@ -11,6 +12,7 @@ YieldCurveBuilder::YieldCurveBuilder(double flatRate)
 
 Handle<YieldTermStructure>
 YieldCurveBuilder::buildCurve(const Date& settlementDate) const {
+    BERMUDAN_TIME_STAGE(Stage::CurveBuild);
     auto q = ext::make_shared<SimpleQuote>(flatRate_);
     Handle<Quote> hq(q);
     auto ts = ext::make_shared<FlatForward>(settlementDate, hq, Actual365Fixed());
@@ -0,0 +1,112 @@
+// test/test_batch.cpp
+#include <gtest/gtest.h>
+
+#include "BermudanSwaptionPricer.hpp"
+#include "MarketCache.hpp"
+
+#include <ql/settings.hpp>
+
+using namespace QuantLib;
+
+TEST(BermudanSwaptionPricer, BatchMatchesSerial) {
+    const Date d1(15, July, 2025);
+    const Date d2(15, August, 2025);
+
+    std::vector<BermudanTrade> trades;
+    for (double mult : {0.8, 1.0, 1.2}) {
+        trades.push_back({d1, 0.035, "hw", "tree", mult});
+        trades.push_back({d2, 0.030, "hw", "fdm",  mult});
+        trades.push_back({d1, 0.040, "bk", "tree", mult});
+    }
+
+    std::vector<double> serial;
+    for (const auto& t : trades)
+        serial.push_back(BermudanSwaptionPricer::priceTrade(t));
+
+    Settings::instance().evaluationDate() = d2;
+    std::vector<double> batch = BermudanSwaptionPricer::priceBatch(trades, 4);
+
+    ASSERT_EQ(batch.size(), serial.size());
+    for (std::size_t i = 0; i < trades.size(); ++i)
+        EXPECT_EQ(batch[i], serial[i]) << "trade " << i;
+
+    // The caller's evaluation date survives the batch
+    EXPECT_EQ(Date(Settings::instance().evaluationDate()), d2);
+}
+
+TEST(BermudanSwaptionPricer, BookSharesMarketsAndMatchesSerial) {
+    const Date d1(15, July, 2025);
+    const Date d2(15, August, 2025);
+
+    // Interleaved rows over three markets, with repeats and a small ladder
+    // chunk so one market spans several chunks
+    std::vector<BermudanTrade> trades;
+    for (double mult : {0.8, 1.0, 1.2, 0.9, 1.1}) {
+        trades.push_back({d1, 0.035, "hw", "tree", mult});
+        trades.push_back({d2, 0.030, "hw", "fdm",  mult});
+        trades.push_back({d1, 0.040, "bk", "tree", mult});
+        trades.push_back({d1, 0.035, "hw", "tree", mult});
+    }
+
+    std::vector<double> serial;
+    for (const auto& t : trades)
+        serial.push_back(BermudanSwaptionPricer::priceTrade(t));
+
+    Settings::instance().evaluationDate() = d2;
+    std::vector<double> book = BermudanSwaptionPricer::priceBook(trades, 4, 3);
+
+    ASSERT_EQ(book.size(), serial.size());
+    for (std::size_t i = 0; i < trades.size(); ++i)
+        EXPECT_NEAR(book[i], serial[i], 1e-10) << "trade " << i;
+    EXPECT_EQ(Date(Settings::instance().evaluationDate()), d2);
+}
+
+TEST(BermudanSwaptionPricer, BookReusesCachedMarkets) {
+    const Date d1(15, July, 2025);
+
+    std::vector<BermudanTrade> trades;
+    for (double mult : {0.8, 1.0, 1.2}) {
+        trades.push_back({d1, 0.035, "hw", "tree", mult});
+        trades.push_back({d1, 0.040, "g2", "tree", mult});
+    }
+
+    const std::vector<double> cold = BermudanSwaptionPricer::priceBook(trades, 2);
+
+    MarketCache markets(8);
+    const std::vector<double> first = BermudanSwaptionPricer::priceBook(trades, 2, 64, &markets);
+    EXPECT_EQ(markets.size(), 2u);
+    EXPECT_EQ(markets.misses(), 2u);
+
+    // Second request: same graphs and fitted lattices, same numbers
+    const std::vector<double> second = BermudanSwaptionPricer::priceBook(trades, 2, 64, &markets);
+    EXPECT_EQ(markets.misses(), 2u);
+    EXPECT_EQ(markets.hits(), 2u);
+
+    for (std::size_t i = 0; i < trades.size(); ++i) {
+        EXPECT_EQ(first[i], cold[i]) << "trade " << i;
+        EXPECT_EQ(second[i], cold[i]) << "trade " << i;
+    }
+}
+
+// Many ladders on one date priced at once: the strike swaps of every ladder
+// register with the global evaluation date (run under ENABLE_TSAN)
+TEST(BermudanSwaptionPricer, ParallelLaddersOnOneDate) {
+    const Date today(15, July, 2025);
+
+    std::vector<BermudanTrade> trades;
+    for (int m = 0; m < 8; ++m) {
+        for (double mult : {0.8, 0.9, 1.0, 1.1, 1.2}) {
+            trades.push_back({today, 0.02 + 0.004 * m, "hw", "tree", mult});
+            trades.push_back({today, 0.02 + 0.004 * m, "g2", "fdm-adi", mult});
+        }
+    }
+
+    std::vector<double> serial;
+    for (const auto& t : trades)
+        serial.push_back(BermudanSwaptionPricer::priceTrade(t));
+
+    const std::vector<double> book = BermudanSwaptionPricer::priceBook(trades, 8, 2);
+    ASSERT_EQ(book.size(), serial.size());
+    for (std::size_t i = 0; i < trades.size(); ++i)
+        EXPECT_NEAR(book[i], serial[i], 1e-10) << "trade " << i;
+}
@@ -3,10 +3,26 @@
 #include "YieldCurveBuilder.hpp"
 #include "SwapBuilder.hpp"
 #include "BermudanSwaptionPricer.hpp"
+#include "BasicBermudanSwaptionPricer.hpp"
+#include "GridDiscountCurve.hpp"
+#include "G2AdiSwaptionEngine.hpp"
+#include "CachedTreeSwaptionEngine.hpp"
+#include "FittedLatticeCache.hpp"
 
 #include <ql/settings.hpp>
 #include <ql/time/calendars/target.hpp>
 #include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/models/shortrate/onefactormodels/blackkarasinski.hpp>
+#include <ql/models/shortrate/onefactormodels/extendedcoxingersollross.hpp>
+#include <ql/models/shortrate/twofactormodels/g2.hpp>
+#include <ql/cashflows/coupon.hpp>
+#include <ql/exercise.hpp>
+#include <ql/pricingengines/swaption/fdg2swaptionengine.hpp>
+#include <ql/pricingengines/swaption/fdhullwhiteswaptionengine.hpp>
+#include <ql/pricingengines/swaption/treeswaptionengine.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
 
 using namespace QuantLib;
 
@@ -52,3 +68,335 @@ TEST(BermudanSwaptionPricer, MonotonicityHW) {
     EXPECT_GE(vATM + 1e-10, vOTM);
 }
 
+
+TEST(BermudanSwaptionPricer, RepriceTracksModelChanges) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    YieldCurveBuilder ycb(0.035);
+    Handle<YieldTermStructure> ts = ycb.buildCurve(settlement);
+    SwapBuilder sb(ts);
+    auto swap = sb.buildSwap(sb.fairRate());
+
+    auto hw = ext::make_shared<HullWhite>(ts);
+    BermudanSwaptionPricer pricer(swap, hw, "tree");
+
+    const double v0 = pricer.price();
+    EXPECT_EQ(pricer.price(), v0);   // unchanged inputs: cached result
+
+    // Parameter change propagates through the observer chain
+    Array params(2);
+    params[0] = 0.05;
+    params[1] = 0.015;
+    hw->setParams(params);
+
+    const double v1 = pricer.price();
+    EXPECT_NE(v1, v0);
+    EXPECT_NEAR(v1, BermudanSwaptionPricer(swap, hw, "tree").price(), 1e-12);
+}
+
+TEST(BermudanSwaptionPricer, StrikeLadderMatchesSinglePrices) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    YieldCurveBuilder ycb(0.035);
+    Handle<YieldTermStructure> ts = ycb.buildCurve(settlement);
+    SwapBuilder sb(ts);
+    Rate atm = sb.fairRate();
+    std::vector<Rate> strikes = {atm * 0.8, atm, atm * 1.2};
+
+    std::vector<ext::shared_ptr<ShortRateModel>> models = {
+        ext::make_shared<HullWhite>(ts),
+        ext::make_shared<BlackKarasinski>(ts)
+    };
+
+    for (const auto& model : models) {
+        BermudanSwaptionPricer ladder(sb.buildSwap(atm), model, "tree");
+        std::vector<double> npvs = ladder.priceStrikes(strikes);
+        ASSERT_EQ(npvs.size(), strikes.size());
+        for (Size i = 0; i < strikes.size(); ++i) {
+            BermudanSwaptionPricer single(sb.buildSwap(strikes[i]), model, "tree");
+            EXPECT_NEAR(npvs[i], single.price(), 1e-10);
+        }
+    }
+}
+
+TEST(BermudanSwaptionPricer, HwSimdMatchesTreeEngine) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    YieldCurveBuilder ycb(0.035);
+    Handle<YieldTermStructure> ts = ycb.buildCurve(settlement);
+    SwapBuilder sb(ts);
+    Rate atm = sb.fairRate();
+    auto hw = ext::make_shared<HullWhite>(ts, 0.05, 0.012);
+
+    TimeGrid grid(7.0, 200);
+    for (Real mult : {0.8, 1.0, 1.2}) {
+        auto swap = sb.buildSwap(atm * mult);
+        EXPECT_NEAR(BermudanSwaptionPricer(swap, hw, "hw-simd").price(),
+                    BermudanSwaptionPricer(swap, hw, "tree").price(), 1e-10);
+        EXPECT_NEAR(BermudanSwaptionPricer(swap, hw, "hw-simd", &grid).price(),
+                    BermudanSwaptionPricer(swap, hw, "tree", &grid).price(), 1e-10);
+    }
+}
+
+TEST(BermudanSwaptionPricer, GridDiscountCacheMatchesCurveAndFollowsQuotes) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    auto rate = ext::make_shared<SimpleQuote>(0.035);
+    Handle<YieldTermStructure> ts(
+        ext::make_shared<FlatForward>(settlement, Handle<Quote>(rate), Actual365Fixed()));
+    auto cached = ext::make_shared<GridDiscountCurve>(ts);
+
+    SwapBuilder sb(ts);
+    auto swap = sb.buildSwap(sb.fairRate());
+    auto direct = ext::make_shared<HullWhite>(ts);
+    auto onGrid = ext::make_shared<HullWhite>(Handle<YieldTermStructure>(cached));
+
+    BermudanSwaptionPricer reference(swap, direct, "tree");
+    BermudanSwaptionPricer pricer(swap, onGrid, "tree");
+    EXPECT_FALSE(cached->times().empty());
+
+    // Same discount factors, so the same lattice and price
+    EXPECT_DOUBLE_EQ(pricer.price(), reference.price());
+    EXPECT_GT(cached->hits(), 0u);
+
+    // A quote change reaches the model through the cache
+    const double before = pricer.price();
+    rate->setValue(0.040);
+    EXPECT_NE(pricer.price(), before);
+    EXPECT_DOUBLE_EQ(pricer.price(), reference.price());
+    EXPECT_DOUBLE_EQ(cached->discounts().back(), ts->discount(cached->times().back()));
+}
+
+TEST(BermudanSwaptionPricer, AutoGridMeetsToleranceAndCachesChoice) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    YieldCurveBuilder ycb(0.035);
+    Handle<YieldTermStructure> ts = ycb.buildCurve(settlement);
+    SwapBuilder sb(ts);
+    Rate atm = sb.fairRate();
+    auto hw = ext::make_shared<HullWhite>(ts, 0.05, 0.012);
+    auto swap = sb.buildSwap(atm);
+
+    GridCache::shared().clear();
+    GridSettings grid;
+    grid.tolerance = 2e-3;
+    BermudanSwaptionPricer pricer(swap, hw, "tree", nullptr, LsmcSettings(), grid);
+    const double npv = pricer.price();
+    EXPECT_GT(pricer.gridSteps(), grid.minSteps);
+    EXPECT_LE(pricer.gridSteps(), grid.maxSteps);
+    EXPECT_LE(pricer.gridError(), grid.tolerance);
+    EXPECT_EQ(GridCache::shared().size(), 1u);
+
+    // Extrapolated reference on a much finer pair of grids
+    GridSettings fine;
+    fine.tolerance = 1e-12;
+    fine.minSteps = 1024;
+    fine.maxSteps = 2048;
+    fine.cache = false;
+    const double reference =
+        BermudanSwaptionPricer(swap, hw, "tree", nullptr, LsmcSettings(), fine).price();
+    EXPECT_NEAR(npv, reference, 5 * grid.tolerance);
+
+    // Same shape: straight to the cached resolution
+    BermudanSwaptionPricer again(swap, hw, "tree", nullptr, LsmcSettings(), grid);
+    EXPECT_NEAR(again.price(), npv, 1e-12);
+    EXPECT_EQ(again.gridSteps(), pricer.gridSteps());
+    EXPECT_EQ(GridCache::shared().hits(), 1u);
+
+    // The ladder extrapolates from the same pair of lattices
+    EXPECT_NEAR(pricer.priceStrikes({atm})[0], npv, 1e-10);
+
+    // Room for one doubling only: the error is the fine price's own estimate
+    GridSettings single = grid;
+    single.maxSteps = 2 * single.minSteps;
+    single.cache = false;
+    BermudanSwaptionPricer capped(swap, hw, "tree", nullptr, LsmcSettings(), single);
+    capped.price();
+    EXPECT_EQ(capped.gridSteps(), single.maxSteps);
+    EXPECT_GT(capped.gridError(), 0.0);
+    EXPECT_LT(capped.gridError(), 1.0);
+
+    // Bounded by least recent use: a stream of strikes keeps the last ones
+    GridCache small(2);
+    GridCache::Shape shape;
+    for (long bp : {100L, 200L}) {
+        shape.strikeBp = bp;
+        small.insert(shape, {64, 1e-4});
+    }
+    shape.strikeBp = 100;
+    ASSERT_TRUE(small.find(shape));
+    shape.strikeBp = 300;
+    small.insert(shape, {128, 1e-4});
+    EXPECT_EQ(small.size(), 2u);
+    EXPECT_EQ(small.find(shape)->steps, 128u);
+    shape.strikeBp = 100;
+    EXPECT_TRUE(small.find(shape));
+    shape.strikeBp = 200;
+    EXPECT_FALSE(small.find(shape));
+}
+
+TEST(BermudanSwaptionPricer, TypedPricersMatchQuantLibEngines) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    YieldCurveBuilder ycb(0.035);
+    Handle<YieldTermStructure> ts = ycb.buildCurve(settlement);
+    SwapBuilder sb(ts);
+    Rate atm = sb.fairRate();
+    auto swap = sb.buildSwap(atm);
+    auto hw = ext::make_shared<HullWhite>(ts, 0.05, 0.012);
+    auto g2 = ext::make_shared<G2>(ts);
+    auto bk = ext::make_shared<BlackKarasinski>(ts);
+
+    // Reference: the Bermudan on its fixed-leg accrual starts, priced by
+    // QuantLib's own engines
+    std::vector<Date> exerciseDates;
+    for (const auto& cf : swap->fixedLeg())
+        exerciseDates.push_back(ext::dynamic_pointer_cast<Coupon>(cf)->accrualStartDate());
+    auto direct = [&](const ext::shared_ptr<PricingEngine>& engine) {
+        Swaption swaption(swap, ext::make_shared<BermudanExercise>(exerciseDates));
+        swaption.setPricingEngine(engine);
+        return swaption.NPV();
+    };
+
+    BasicBermudanSwaptionPricer<HullWhite, TreeEngine> hwTree(swap, hw);
+    const double hwTreeNpv = direct(ext::make_shared<TreeSwaptionEngine>(hw, 50));
+    EXPECT_NEAR(hwTree.price(), hwTreeNpv, 1e-12);
+    EXPECT_NEAR(hwTree.priceStrikes({atm})[0], hwTreeNpv, 1e-10);
+
+    BasicBermudanSwaptionPricer<HullWhite, HwSimdEngine> hwSimd(swap, hw);
+    EXPECT_NEAR(hwSimd.price(), hwTreeNpv, 1e-10);
+
+    BasicBermudanSwaptionPricer<HullWhite, FdEngine> hwFd(swap, hw);
+    EXPECT_NEAR(hwFd.price(), direct(ext::make_shared<FdHullWhiteSwaptionEngine>(hw)), 1e-12);
+
+    BasicBermudanSwaptionPricer<G2, FdEngine> g2Fd(swap, g2);
+    EXPECT_NEAR(g2Fd.price(), direct(ext::make_shared<FdG2SwaptionEngine>(g2)), 1e-12);
+
+    TimeGrid grid(50.0, 50);
+    BasicBermudanSwaptionPricer<BlackKarasinski, TreeEngine> bkTree(swap, bk, &grid);
+    EXPECT_NEAR(bkTree.price(), direct(ext::make_shared<TreeSwaptionEngine>(bk, grid)), 1e-10);
+
+    // Any other short-rate model: the facade's tree fallback
+    auto cir = ext::make_shared<ExtendedCoxIngersollRoss>(ts);
+    const double cirNpv = direct(ext::make_shared<TreeSwaptionEngine>(cir, 50));
+    EXPECT_NEAR(BermudanSwaptionPricer(swap, cir, "tree").price(), cirNpv, 1e-12);
+    EXPECT_NEAR(BermudanSwaptionPricer(swap, cir, "tree").priceStrikes({atm})[0], cirNpv, 1e-10);
+    EXPECT_THROW(BermudanSwaptionPricer(swap, cir, "hw-simd"), Error);
+
+    EXPECT_THROW(BermudanSwaptionPricer(swap, hw, "binomial"), Error);
+}
+
+TEST(BermudanSwaptionPricer, G2AdiMatchesQuantLibFdOnAnyThreadCount) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    YieldCurveBuilder ycb(0.035);
+    Handle<YieldTermStructure> ts = ycb.buildCurve(settlement);
+    SwapBuilder sb(ts);
+    Rate atm = sb.fairRate();
+    auto g2 = ext::make_shared<G2>(ts);
+
+    // Both second order in time and space: Richardson over one doubling of
+    // every grid removes the leading error of each discretization
+    auto npv = [](const ext::shared_ptr<Swaption>& swaption,
+                  const ext::shared_ptr<PricingEngine>& engine) {
+        swaption->setPricingEngine(engine);
+        return swaption->NPV();
+    };
+    auto extrapolated = [](double coarse, double fine) { return (4.0 * fine - coarse) / 3.0; };
+
+    for (Real mult : {0.8, 1.0, 1.2}) {
+        BermudanSwaptionPricer pricer(sb.buildSwap(atm * mult), g2, "fdm-adi");
+        const auto& swaption = pricer.swaption();
+
+        const double fd = extrapolated(
+            npv(swaption, ext::make_shared<FdG2SwaptionEngine>(g2, 100, 60, 60)),
+            npv(swaption, ext::make_shared<FdG2SwaptionEngine>(g2, 200, 120, 120)));
+        const double adi = extrapolated(
+            npv(swaption, ext::make_shared<G2AdiSwaptionEngine>(g2, 100, 61, 61)),
+            npv(swaption, ext::make_shared<G2AdiSwaptionEngine>(g2, 200, 121, 121)));
+        EXPECT_NEAR(adi, fd, 1e-4 * fd) << "strike multiplier " << mult;
+
+        // The sweeps split rows and column blocks over the pool, each solved
+        // the same way: any thread count gives the same bits
+        std::vector<double> npvs;
+        for (std::size_t threads : {1, 2, 3, 4, 8}) {
+            npvs.push_back(npv(swaption, ext::make_shared<G2AdiSwaptionEngine>(
+                g2, 100, 61, 61, G2AdiSwaptionEngine::CraigSneyd, threads)));
+            EXPECT_EQ(npvs.back(), npvs.front()) << threads << " threads";
+        }
+
+        // Douglas is only first order in time with the correlation term
+        // explicit: checked on the fine mesh, and its thread counts agree
+        const double douglas = npv(swaption, ext::make_shared<G2AdiSwaptionEngine>(
+            g2, 400, 121, 121, G2AdiSwaptionEngine::Douglas, 1));
+        EXPECT_NEAR(douglas, fd, 1e-3 * fd);
+        EXPECT_EQ(npv(swaption, ext::make_shared<G2AdiSwaptionEngine>(
+                      g2, 400, 121, 121, G2AdiSwaptionEngine::Douglas, 4)),
+                  douglas);
+    }
+
+    auto hw = ext::make_shared<HullWhite>(ts);
+    EXPECT_THROW(BermudanSwaptionPricer(sb.buildSwap(atm), hw, "fdm-adi"), Error);
+}
+
+TEST(BermudanSwaptionPricer, BlackKarasinskiTreeIsFittedOncePerMarket) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+
+    auto rate = ext::make_shared<SimpleQuote>(0.035);
+    Handle<YieldTermStructure> ts(
+        ext::make_shared<FlatForward>(settlement, Handle<Quote>(rate), Actual365Fixed()));
+    SwapBuilder sb(ts);
+    const Rate atm = sb.fairRate();
+    auto bk = ext::make_shared<BlackKarasinski>(ts);
+    auto other = ext::make_shared<BlackKarasinski>(ts);     // same market, separate object
+
+    FittedLatticeCache cache;
+    auto check = [&](const ext::shared_ptr<BlackKarasinski>& model, Real mult) {
+        BermudanSwaptionPricer pricer(sb.buildSwap(atm * mult), model, "tree");
+        const auto& swaption = pricer.swaption();
+        swaption->setPricingEngine(ext::make_shared<TreeSwaptionEngine>(model, 50));
+        const Real refitted = swaption->NPV();
+        swaption->setPricingEngine(ext::make_shared<CachedTreeSwaptionEngine>(model, 50, cache));
+        EXPECT_DOUBLE_EQ(swaption->NPV(), refitted);
+    };
+
+    // Every strike and both models roll back on one fitted tree
+    for (const auto& model : {bk, other})
+        for (Real mult : {0.8, 1.0, 1.2})
+            check(model, mult);
+    EXPECT_EQ(cache.misses(), 1u);
+    EXPECT_EQ(cache.hits(), 5u);
+
+    // A quote or parameter change fits a new tree
+    rate->setValue(0.040);
+    check(bk, 1.0);
+    EXPECT_EQ(cache.misses(), 2u);
+    Array params(2);
+    params[0] = 0.08;
+    params[1] = 0.12;
+    bk->setParams(params);
+    check(bk, 1.0);
+    EXPECT_EQ(cache.misses(), 3u);
+
+    // Back on the first market: still cached
+    rate->setValue(0.035);
+    check(other, 1.0);
+    EXPECT_EQ(cache.misses(), 3u);
+    EXPECT_EQ(cache.size(), 3u);
+}
@@ -3,6 +3,8 @@
 
 #include "YieldCurveBuilder.hpp"
 #include "SwapBuilder.hpp"
+#include "SwaptionCalibrator.hpp"
+#include "CalibrationCache.hpp"
 
 #include <ql/settings.hpp>
 #include <ql/time/calendars/target.hpp>
@@ -20,6 +22,10 @@
 #include <ql/math/optimization/levenbergmarquardt.hpp>
 #include <ql/utilities/dataformatters.hpp>
 
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
 using namespace QuantLib;
 
 namespace {
@@ -185,3 +191,124 @@ TEST(Calibration, Diagonal_G2pp_HW_BK) {
     EXPECT_GE(hw_ana->params()[1], 0.0);
 }
 
+
+TEST(Calibration, ParallelRepricingAndWarmStart) {
+    MarketFixture mkt;
+    auto swaptions = makeDiagonalSwaptions(mkt);
+    auto diag = diagonalMarketVols();
+    std::vector<int> lengths = {5, 4, 3, 2, 1};
+
+    auto calibrateFresh = [&](SwaptionCalibrator& calibrator, const CalibrationSettings& settings) {
+        auto hw = ext::make_shared<HullWhite>(mkt.ts);
+        for (auto& s : swaptions)
+            s->setPricingEngine(ext::make_shared<JamshidianSwaptionEngine>(hw));
+        LevenbergMarquardt lm;
+        return calibrator.calibrateModel(hw, lm, settings);
+    };
+
+    CalibrationSettings serial;
+    serial.threads = 1;
+    CalibrationSettings parallel;
+    parallel.threads = 4;
+
+    SwaptionCalibrator serialCalibrator(swaptions, diag, lengths);
+    SwaptionCalibrator parallelCalibrator(swaptions, diag, lengths);
+    const CalibrationResult s = calibrateFresh(serialCalibrator, serial);
+    const CalibrationResult p = calibrateFresh(parallelCalibrator, parallel);
+
+    ASSERT_EQ(s.parameters.size(), 2u);
+    EXPECT_EQ(s.parameters[0], p.parameters[0]);
+    EXPECT_EQ(s.parameters[1], p.parameters[1]);
+    EXPECT_EQ(s.evaluations, p.evaluations);
+
+    // A second fit of the same model type starts from the first one
+    const CalibrationResult warm = calibrateFresh(parallelCalibrator, parallel);
+    EXPECT_LT(warm.evaluations, p.evaluations);
+    EXPECT_NEAR(warm.parameters[0], p.parameters[0], 1e-6);
+    EXPECT_NEAR(warm.parameters[1], p.parameters[1], 1e-6);
+    EXPECT_FALSE(s.parallel);
+    EXPECT_TRUE(p.parallel);
+
+    // One engine on every helper: repriced serially despite threads = 4
+    auto hw = ext::make_shared<HullWhite>(mkt.ts);
+    auto engine = ext::make_shared<JamshidianSwaptionEngine>(hw);
+    for (auto& h : swaptions)
+        h->setPricingEngine(engine);
+    LevenbergMarquardt lm;
+    SwaptionCalibrator sharedCalibrator(swaptions, diag, lengths);
+    const CalibrationResult shared = sharedCalibrator.calibrateModel(hw, lm, parallel);
+    EXPECT_FALSE(shared.parallel);
+    EXPECT_EQ(shared.parameters[0], s.parameters[0]);
+    EXPECT_EQ(shared.parameters[1], s.parameters[1]);
+
+    // The model reports the fit as after CalibratedModel::calibrate
+    EXPECT_EQ(hw->endCriteria(), shared.endCriteria);
+    ASSERT_EQ(hw->problemValues().size(), swaptions.size());
+    for (Size i = 0; i < swaptions.size(); ++i)
+        EXPECT_NEAR(hw->problemValues()[i], swaptions[i]->calibrationError(), 1e-12);
+    EXPECT_GT(hw->functionEvaluation(), 0);
+}
+
+TEST(Calibration, CacheKeyedBySnapshot) {
+    MarketFixture mkt;
+    auto swaptions = makeDiagonalSwaptions(mkt);
+    auto diag = diagonalMarketVols();
+    std::vector<int> lengths = {5, 4, 3, 2, 1};
+
+    std::string pattern =
+        (std::filesystem::temp_directory_path() / "calibration_cache_test_XXXXXX").string();
+    ASSERT_NE(mkdtemp(pattern.data()), nullptr);
+    const std::filesystem::path directory = pattern;
+
+    auto calibrate = [&](CalibrationCache& cache) {
+        auto hw = ext::make_shared<HullWhite>(mkt.ts);
+        for (auto& s : swaptions)
+            s->setPricingEngine(ext::make_shared<JamshidianSwaptionEngine>(hw));
+        LevenbergMarquardt lm;
+        CalibrationSettings settings;
+        settings.warmStart = false;
+        settings.cache = &cache;
+        settings.cacheTag = "jamshidian";
+        SwaptionCalibrator calibrator(swaptions, diag, lengths, mkt.ts);
+        return calibrator.calibrateModel(hw, lm, settings);
+    };
+
+    CalibrationCache cache(16, directory.string());
+    const CalibrationResult first = calibrate(cache);
+    EXPECT_FALSE(first.fromCache);
+    EXPECT_GT(first.evaluations, 0u);
+
+    // Same snapshot: a lookup, no optimizer run
+    const CalibrationResult second = calibrate(cache);
+    EXPECT_TRUE(second.fromCache);
+    EXPECT_EQ(second.evaluations, 0u);
+    ASSERT_EQ(second.parameters.size(), first.parameters.size());
+    EXPECT_EQ(second.parameters[0], first.parameters[0]);
+    EXPECT_EQ(second.parameters[1], first.parameters[1]);
+
+    // A fresh cache on the same directory is served from disk
+    CalibrationCache reopened(16, directory.string());
+    const CalibrationResult fromDisk = calibrate(reopened);
+    EXPECT_TRUE(fromDisk.fromCache);
+    EXPECT_EQ(fromDisk.parameters[0], first.parameters[0]);
+    EXPECT_EQ(fromDisk.parameters[1], first.parameters[1]);
+
+    // A damaged file on disk is a miss, not an error
+    for (const auto& file : std::filesystem::directory_iterator(directory))
+        std::ofstream(file.path(), std::ios::trunc) << "zz-not-a-key 2\n0.1\n";
+    CalibrationCache damaged(16, directory.string());
+    const CalibrationResult refit = calibrate(damaged);
+    EXPECT_FALSE(refit.fromCache);
+    EXPECT_EQ(refit.parameters[0], first.parameters[0]);
+
+    // Moving one vol quote changes the snapshot
+    auto quote = ext::dynamic_pointer_cast<SimpleQuote>(
+        swaptions[0]->volatility().currentLink());
+    ASSERT_TRUE(quote);
+    quote->setValue(quote->value() + 0.01);
+    const CalibrationResult moved = calibrate(cache);
+    EXPECT_FALSE(moved.fromCache);
+    EXPECT_NE(moved.parameters[1], first.parameters[1]);
+
+    std::filesystem::remove_all(directory);
+}
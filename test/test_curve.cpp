@@ -1,8 +1,17 @@
 // test/test_curve.cpp
 #include <gtest/gtest.h>
 #include "YieldCurveBuilder.hpp"
+#include "BootstrappedCurveBuilder.hpp"
 #include <ql/settings.hpp>
 #include <ql/time/calendars/target.hpp>
+#include <ql/indexes/ibor/euribor.hpp>
+#include <ql/termstructures/yield/piecewiseyieldcurve.hpp>
+#include <ql/termstructures/yield/ratehelpers.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/time/daycounters/thirty360.hpp>
+#include <algorithm>
+#include <cmath>
 
 using namespace QuantLib;
 
@@ -26,3 +35,94 @@ TEST(YieldCurveBuilder, FlatCurveBuilds) {
     EXPECT_NEAR(df1, approx, 1e-3);
 }
 
+
+namespace {
+    struct QuotedCurve {
+        Date settlement;
+        BootstrappedCurveBuilder builder;
+        std::vector<ext::shared_ptr<SimpleQuote>> deposits, fras, swaps;
+
+        QuotedCurve() {
+            Date today(15, July, 2025);
+            Settings::instance().evaluationDate() = today;
+            settlement = TARGET().advance(today, 2, Days);
+            deposits.push_back(builder.addDeposit(Period(1, Months), 0.0300));
+            deposits.push_back(builder.addDeposit(Period(3, Months), 0.0310));
+            fras.push_back(builder.addFra(3, 9, 0.0320));
+            fras.push_back(builder.addFra(6, 12, 0.0325));
+            for (int y : {2, 3, 5, 7, 10})
+                swaps.push_back(builder.addSwap(Period(y, Years), 0.0330 + 0.0005 * y));
+        }
+    };
+
+    double maxDiscountGap(const YieldTermStructure& a, const YieldTermStructure& b, const Date& from) {
+        double gap = 0.0;
+        for (int m = 1; m <= 144; ++m) {
+            const Date d = from + Period(m, Months);
+            gap = std::max(gap, std::fabs(a.discount(d) - b.discount(d)));
+        }
+        return gap;
+    }
+}
+
+TEST(BootstrappedCurve, RepricesQuotesLikePiecewiseCurve) {
+    QuotedCurve q;
+    auto curve = q.builder.build(q.settlement);
+
+    // Same instruments through QuantLib's own bootstrap
+    std::vector<ext::shared_ptr<RateHelper>> helpers = {
+        ext::make_shared<DepositRateHelper>(Handle<Quote>(q.deposits[0]), Period(1, Months), 2,
+                                            TARGET(), ModifiedFollowing, true, Actual360()),
+        ext::make_shared<DepositRateHelper>(Handle<Quote>(q.deposits[1]), Period(3, Months), 2,
+                                            TARGET(), ModifiedFollowing, true, Actual360()),
+        ext::make_shared<FraRateHelper>(Handle<Quote>(q.fras[0]), 3, 9, 2,
+                                        TARGET(), ModifiedFollowing, true, Actual360()),
+        ext::make_shared<FraRateHelper>(Handle<Quote>(q.fras[1]), 6, 12, 2,
+                                        TARGET(), ModifiedFollowing, true, Actual360()),
+    };
+    const int years[] = {2, 3, 5, 7, 10};
+    for (std::size_t i = 0; i < q.swaps.size(); ++i)
+        helpers.push_back(ext::make_shared<SwapRateHelper>(
+            Handle<Quote>(q.swaps[i]), Period(years[i], Years), TARGET(), Annual, Unadjusted,
+            Thirty360(Thirty360::European), ext::make_shared<Euribor6M>()));
+    PiecewiseYieldCurve<Discount, LogLinear> reference(q.settlement, helpers, Actual365Fixed());
+    reference.enableExtrapolation();
+
+    EXPECT_LT(maxDiscountGap(*curve, reference, q.settlement), 1e-10);
+    EXPECT_EQ(curve->lastSolvedPillars(), 9u);
+}
+
+TEST(BootstrappedCurve, QuoteTickRebootstrapsAffectedPillarsOnly) {
+    QuotedCurve q;
+    auto curve = q.builder.build(q.settlement);
+    curve->discount(1.0);
+
+    // Last swap: only its own pillar
+    q.swaps.back()->setValue(0.0390);
+    curve->discount(1.0);
+    EXPECT_EQ(curve->lastSolvedPillars(), 1u);
+
+    // 1M deposit: its pillar, plus the FRAs and swaps reading the first segment
+    q.deposits.front()->setValue(0.0305);
+    curve->discount(1.0);
+    EXPECT_LT(curve->lastSolvedPillars(), 9u);
+
+    // 5Y swap: itself and the 7Y and 10Y swaps
+    q.swaps[2]->setValue(0.0360);
+    auto snapshot = curve->snapshot();
+    EXPECT_EQ(curve->lastSolvedPillars(), 3u);
+
+    // Incremental result equals a cold bootstrap of the same quotes
+    auto cold = q.builder.build(q.settlement);
+    EXPECT_LT(maxDiscountGap(*curve, *cold, q.settlement), 1e-10);
+
+    // The published snapshot reads the same discount factors
+    for (double t : {0.1, 0.75, 2.5, 6.0, 12.0})
+        EXPECT_NEAR(snapshot->discount(t), cold->discount(t), 1e-10);
+
+    // Outside the nodes: the first and last forwards, extrapolated flat
+    DiscountCurveSnapshot nodes{{0.0, 1.0, 2.0}, {0.0, -0.03, -0.07}, {0.03, 0.04}};
+    EXPECT_NEAR(nodes.discount(-0.5), std::exp(0.015), 1e-15);
+    EXPECT_NEAR(nodes.discount(0.0), 1.0, 1e-15);
+    EXPECT_NEAR(nodes.discount(3.0), std::exp(-0.11), 1e-15);
+}
@@ -0,0 +1,59 @@
+// test/test_greeks.cpp
+#include <gtest/gtest.h>
+
+#include "BermudanSwaptionPricer.hpp"
+
+#include <ql/settings.hpp>
+#include <cmath>
+
+using namespace QuantLib;
+
+TEST(BermudanGreeks, AdjointDeltasMatchBumpedDeltas) {
+    const BermudanTrade trade{Date(15, July, 2025), 0.035, "hw", "tree", 1.0};
+
+    GreeksSettings bumped;
+    bumped.threads = 4;
+    GreeksSettings adjoint = bumped;
+    adjoint.adjoint = true;
+
+    const BermudanGreeks b = BermudanSwaptionPricer::greeks(trade, bumped);
+    const BermudanGreeks a = BermudanSwaptionPricer::greeks(trade, adjoint);
+
+    EXPECT_NEAR(b.npv, BermudanSwaptionPricer::priceTrade(trade), 1e-10);
+    EXPECT_EQ(a.npv, b.npv);
+
+    ASSERT_EQ(a.deltas.size(), bumped.buckets.size());
+    ASSERT_EQ(b.deltas.size(), bumped.buckets.size());
+    double total = 0.0;
+    for (std::size_t k = 0; k < a.deltas.size(); ++k) {
+        EXPECT_NEAR(a.deltas[k], b.deltas[k], 1e-3 * std::fabs(b.deltas[k]) + 1e-6)
+            << "bucket " << k;
+        total += std::fabs(a.deltas[k]);
+    }
+    EXPECT_GT(total, 0.0);
+
+    // Vegas and gamma come from the same bumps in both modes
+    ASSERT_EQ(a.vegas.size(), 2u);
+    EXPECT_EQ(a.vegas, b.vegas);
+    EXPECT_EQ(a.gamma, b.gamma);
+    EXPECT_GT(b.vegas[1], 0.0);   // long option: dNPV/dsigma > 0
+}
+
+TEST(BermudanGreeks, ParallelBumpsMatchSerial) {
+    const BermudanTrade trade{Date(15, July, 2025), 0.03, "bk", "tree", 1.2};
+
+    GreeksSettings serial;
+    serial.threads = 1;
+    GreeksSettings parallel = serial;
+    parallel.threads = 4;
+
+    Settings::instance().evaluationDate() = Date(15, August, 2025);
+    const BermudanGreeks s = BermudanSwaptionPricer::greeks(trade, serial);
+    const BermudanGreeks p = BermudanSwaptionPricer::greeks(trade, parallel);
+
+    EXPECT_EQ(s.npv, p.npv);
+    EXPECT_EQ(s.deltas, p.deltas);
+    EXPECT_EQ(s.vegas, p.vegas);
+    EXPECT_EQ(s.gamma, p.gamma);
+    EXPECT_EQ(Date(Settings::instance().evaluationDate()), Date(15, August, 2025));
+}
@@ -0,0 +1,83 @@
+// test/test_lsmc.cpp
+#include <gtest/gtest.h>
+
+#include "YieldCurveBuilder.hpp"
+#include "SwapBuilder.hpp"
+#include "BermudanSwaptionPricer.hpp"
+
+#include <ql/settings.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/models/shortrate/twofactormodels/g2.hpp>
+
+using namespace QuantLib;
+
+namespace {
+    struct Market {
+        Handle<YieldTermStructure> ts;
+        ext::shared_ptr<VanillaSwap> swap;
+
+        Market() {
+            Date today(15, July, 2025);
+            Settings::instance().evaluationDate() = today;
+            ts = YieldCurveBuilder(0.035).buildCurve(TARGET().advance(today, 2, Days));
+            SwapBuilder sb(ts);
+            swap = sb.buildSwap(sb.fairRate());
+        }
+    };
+}
+
+TEST(LsmcSwaptionEngine, MatchesTreeWithinErrorHW) {
+    Market m;
+    auto hw = ext::make_shared<HullWhite>(m.ts);
+
+    const double tree = BermudanSwaptionPricer(m.swap, hw, "tree").price();
+    BermudanSwaptionPricer lsmc(m.swap, hw, "lsmc");
+    const double mc = lsmc.price();
+    const double se = lsmc.swaption()->errorEstimate();
+
+    EXPECT_GT(se, 0.0);
+    EXPECT_NEAR(mc, tree, 4.0 * se + 0.01 * tree);
+}
+
+TEST(LsmcSwaptionEngine, MatchesTreeWithinErrorG2) {
+    Market m;
+    auto g2 = ext::make_shared<G2>(m.ts);
+
+    const double tree = BermudanSwaptionPricer(m.swap, g2, "tree").price();
+    BermudanSwaptionPricer lsmc(m.swap, g2, "lsmc");
+    const double mc = lsmc.price();
+    const double se = lsmc.swaption()->errorEstimate();
+
+    EXPECT_NEAR(mc, tree, 4.0 * se + 0.01 * tree);
+}
+
+TEST(LsmcSwaptionEngine, ReproducibleAcrossThreadCounts) {
+    Market m;
+    auto g2 = ext::make_shared<G2>(m.ts);
+
+    LsmcSettings serial;
+    serial.maxPaths = 16384;
+    serial.threads = 1;
+    LsmcSettings parallel = serial;
+    parallel.threads = 4;
+
+    BermudanSwaptionPricer a(m.swap, g2, "lsmc", nullptr, serial);
+    BermudanSwaptionPricer b(m.swap, g2, "lsmc", nullptr, parallel);
+    EXPECT_EQ(a.price(), b.price());
+    EXPECT_EQ(a.swaption()->errorEstimate(), b.swaption()->errorEstimate());
+}
+
+TEST(LsmcSwaptionEngine, StopsAtTolerance) {
+    Market m;
+    auto hw = ext::make_shared<HullWhite>(m.ts);
+
+    LsmcSettings loose;
+    loose.maxPaths = 1 << 20;
+    loose.tolerance = 0.5;
+
+    BermudanSwaptionPricer pricer(m.swap, hw, "lsmc", nullptr, loose);
+    pricer.price();
+    EXPECT_LE(pricer.swaption()->errorEstimate(), loose.tolerance);
+    EXPECT_LT(pricer.swaption()->result<Size>("paths"), loose.maxPaths);
+}
@@ -0,0 +1,59 @@
+// test/test_metrics.cpp
+#include <gtest/gtest.h>
+
+#include "YieldCurveBuilder.hpp"
+#include "SwapBuilder.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "Metrics.hpp"
+
+#include <ql/settings.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+
+using namespace QuantLib;
+
+namespace {
+    const StageMetrics& stage(const MetricsSnapshot& s, Stage which) {
+        return s.stages[static_cast<std::size_t>(which)];
+    }
+
+    std::uint64_t counter(const MetricsSnapshot& s, Counter which) {
+        return s.counters[static_cast<std::size_t>(which)].value;
+    }
+}
+
+TEST(Metrics, RecordsPricingStages) {
+    if (!Metrics::enabled())
+        GTEST_SKIP() << "built without BERMUDAN_ENABLE_METRICS";
+
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Metrics::reset();
+
+    auto ts = YieldCurveBuilder(0.035).buildCurve(TARGET().advance(today, 2, Days));
+    SwapBuilder sb(ts);
+    const Rate atm = sb.fairRate();
+    auto hw = ext::make_shared<HullWhite>(ts);
+
+    BermudanSwaptionPricer pricer(sb.buildSwap(atm), hw, "hw-simd");
+    pricer.price();
+    pricer.priceStrikes({atm, atm * 1.2});
+
+    const MetricsSnapshot s = Metrics::snapshot();
+    EXPECT_TRUE(s.enabled);
+    EXPECT_EQ(stage(s, Stage::CurveBuild).calls, 1u);
+    EXPECT_EQ(stage(s, Stage::FairRate).calls, 1u);
+    EXPECT_EQ(stage(s, Stage::SwapBuild).calls, 2u);      // constructor + buildSwap
+    EXPECT_EQ(stage(s, Stage::ScheduleWalk).calls, 1u);
+    EXPECT_EQ(stage(s, Stage::Price).calls, 1u);
+    EXPECT_EQ(stage(s, Stage::LatticeBuild).calls, 2u);   // engine + strike ladder
+    EXPECT_EQ(stage(s, Stage::Rollback).calls, 2u);
+    EXPECT_GT(stage(s, Stage::Price).totalSeconds, 0.0);
+    EXPECT_GE(stage(s, Stage::Price).totalSeconds, stage(s, Stage::Price).maxSeconds);
+    EXPECT_GT(counter(s, Counter::LatticeNodes), counter(s, Counter::LatticeSteps));
+
+    Metrics::reset();
+    const MetricsSnapshot cleared = Metrics::snapshot();
+    EXPECT_EQ(stage(cleared, Stage::Price).calls, 0u);
+    EXPECT_EQ(counter(cleared, Counter::LatticeNodes), 0u);
+}
@@ -0,0 +1,83 @@
+// test/test_scenarios.cpp
+#include <gtest/gtest.h>
+
+#include "BermudanSwaptionPricer.hpp"
+
+#include <ql/settings.hpp>
+#include <cmath>
+
+using namespace QuantLib;
+
+TEST(BermudanScenarios, BucketScenariosReproduceGreeks) {
+    const BermudanTrade trade{Date(15, July, 2025), 0.035, "hw", "tree", 1.0};
+    const double shift = 1e-4;
+
+    ScenarioSettings settings;
+    std::vector<std::vector<double>> shifts;
+    for (std::size_t k = 0; k < settings.buckets.size(); ++k) {
+        std::vector<double> up(settings.buckets.size(), 0.0);
+        std::vector<double> down = up;
+        up[k] = shift;
+        down[k] = -shift;
+        shifts.push_back(up);
+        shifts.push_back(down);
+    }
+
+    settings.threads = 4;
+    const std::vector<BermudanTrade> book = {trade};
+    const ScenarioResults r = BermudanSwaptionPricer::scenarios(book, shifts, settings);
+
+    GreeksSettings greeksSettings;
+    greeksSettings.threads = 4;
+    const BermudanGreeks g = BermudanSwaptionPricer::greeks(trade, greeksSettings);
+
+    ASSERT_EQ(r.base.size(), 1u);
+    ASSERT_EQ(r.npvs.size(), shifts.size());
+    EXPECT_EQ(r.base[0], g.npv);
+    for (std::size_t k = 0; k < g.deltas.size(); ++k)
+        EXPECT_NEAR(0.5 * (r.npvs[2 * k][0] - r.npvs[2 * k + 1][0]), g.deltas[k], 1e-12)
+            << "bucket " << k;
+}
+
+TEST(BermudanScenarios, ParallelMatchesSerialAndKeepsParameters) {
+    const Date d1(15, July, 2025);
+    const Date d2(15, August, 2025);
+    const std::vector<BermudanTrade> book = {
+        {d1, 0.035, "hw", "tree", 1.0},
+        {d2, 0.030, "bk", "tree", 1.2},
+        {d1, 0.035, "hw", "fdm", 0.8},
+    };
+
+    ScenarioSettings serial;
+    serial.threads = 1;
+    serial.modelParams = {{0.05, 0.012}, {}, {}};
+    std::vector<std::vector<double>> shifts;
+    for (int s = -3; s <= 3; ++s)
+        shifts.push_back(std::vector<double>(serial.buckets.size(), s * 5e-4));
+
+    Settings::instance().evaluationDate() = d2;
+    const ScenarioResults a = BermudanSwaptionPricer::scenarios(book, shifts, serial);
+    ScenarioSettings parallel = serial;
+    parallel.threads = 4;
+    const ScenarioResults b = BermudanSwaptionPricer::scenarios(book, shifts, parallel);
+    EXPECT_EQ(a.base, b.base);
+    EXPECT_EQ(a.npvs, b.npvs);
+    EXPECT_EQ(Date(Settings::instance().evaluationDate()), d2);
+
+    // The unshifted scenario is the base, and payers gain as rates rise
+    for (std::size_t i = 0; i < book.size(); ++i) {
+        EXPECT_EQ(a.npvs[3][i], a.base[i]);
+        EXPECT_LT(a.npvs[0][i], a.npvs[6][i]);
+    }
+
+    // Trade 0 priced with the given parameters, not the model's defaults
+    ScenarioSettings defaults = serial;
+    defaults.modelParams.clear();
+    const ScenarioResults c = BermudanSwaptionPricer::scenarios(book, {}, defaults);
+    EXPECT_NE(c.base[0], a.base[0]);
+    EXPECT_EQ(c.base[1], a.base[1]);
+
+    const std::vector<double> pnl = a.pnl();
+    EXPECT_EQ(pnl[3], 0.0);
+    EXPECT_DOUBLE_EQ(a.valueAtRisk(0.99), -pnl[0]);   // worst of 7: the largest rate fall
+}
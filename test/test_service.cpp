@@ -0,0 +1,100 @@
+// test/test_service.cpp
+#include <gtest/gtest.h>
+
+#include "BermudanSwaptionPricer.hpp"
+#include "PricingService.hpp"
+
+#include <chrono>
+
+using namespace QuantLib;
+
+TEST(PricingService, MatchesDirectPricing) {
+    const Date d1(15, July, 2025);
+    const Date d2(15, August, 2025);
+
+    std::vector<BermudanTrade> trades;
+    for (double mult : {0.8, 1.0, 1.2}) {
+        trades.push_back({d1, 0.035, "hw", "tree", mult});
+        trades.push_back({d2, 0.030, "hw", "fdm",  mult});
+        trades.push_back({d1, 0.040, "bk", "tree", mult});
+    }
+    std::vector<double> serial;
+    for (const auto& t : trades)
+        serial.push_back(BermudanSwaptionPricer::priceTrade(t));
+
+    ServiceSettings settings;
+    settings.workers = 3;
+    settings.bookChunk = 2;     // several chunks per date
+    PricingService service(settings);
+
+    auto single = service.submit(trades[1], {JobPriority::Interactive});
+    JobOptions batch;
+    batch.priority = JobPriority::Batch;
+    auto book = service.submitBook(trades, batch);
+
+    EXPECT_EQ(single.result.get(), serial[1]);
+    const std::vector<double> npvs = book.result.get();
+    ASSERT_EQ(npvs.size(), serial.size());
+    for (std::size_t i = 0; i < trades.size(); ++i)
+        EXPECT_NEAR(npvs[i], serial[i], 1e-10) << "trade " << i;
+
+    EXPECT_TRUE(service.submitBook({}).result.get().empty());
+}
+
+TEST(PricingService, CancelledAndExpiredJobsFail) {
+    const Date today(15, July, 2025);
+    ServiceSettings settings;
+    settings.workers = 2;
+    settings.bookChunk = 4;
+    PricingService service(settings);
+
+    // Already past its deadline: fails without pricing
+    JobOptions late;
+    late.deadline = CancellationToken::Clock::now() - std::chrono::milliseconds(1);
+    auto expired = service.submit({today, 0.035, "hw", "tree", 1.0}, late);
+    try {
+        expired.result.get();
+        FAIL() << "expired job priced";
+    } catch (const PricingCancelled& e) {
+        EXPECT_EQ(e.reason(), PricingCancelled::DeadlineExpired);
+    }
+
+    std::vector<BermudanTrade> trades;
+    for (int i = 0; i < 200; ++i)
+        trades.push_back({today, 0.02 + 0.0001 * i, "g2", "fdm", 1.0});
+    auto book = service.submitBook(trades);
+    book.cancel();
+    try {
+        book.result.get();
+        FAIL() << "cancelled book priced";
+    } catch (const PricingCancelled& e) {
+        EXPECT_EQ(e.reason(), PricingCancelled::Cancelled);
+    }
+
+    // The workers are free again
+    EXPECT_GT(service.submit({today, 0.035, "hw", "tree", 1.0}).result.get(), 0.0);
+}
+
+TEST(PricingService, InteractiveJobOvertakesBatch) {
+    const Date today(15, July, 2025);
+    ServiceSettings settings;
+    settings.workers = 2;
+    settings.reservedInteractive = 1;
+    settings.bookChunk = 4;
+    PricingService service(settings);
+
+    std::vector<BermudanTrade> trades;
+    for (int i = 0; i < 64; ++i)
+        trades.push_back({today, 0.02 + 0.0005 * i, "g2", "fdm", 1.0});
+    JobOptions batch;
+    batch.priority = JobPriority::Batch;
+    auto book = service.submitBook(trades, batch);
+
+    const BermudanTrade quote{today, 0.035, "hw", "tree", 1.0};
+    auto job = service.submit(quote, {JobPriority::Interactive});
+    EXPECT_EQ(job.result.get(), BermudanSwaptionPricer::priceTrade(quote));
+    EXPECT_EQ(book.result.wait_for(std::chrono::seconds(0)), std::future_status::timeout);
+
+    book.cancel();
+    EXPECT_THROW(book.result.get(), PricingCancelled);
+}
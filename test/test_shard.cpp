@@ -0,0 +1,91 @@
+// test/test_shard.cpp
+#include <gtest/gtest.h>
+
+#include "BermudanSwaptionPricer.hpp"
+#include "ShardedPricing.hpp"
+#include "ThreadPool.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST(ShardedPricing, ForkedWorkersMatchSerialPricing) {
+    const std::string csv =
+        (std::filesystem::temp_directory_path() / "bermudan_shard_test.csv").string();
+    {
+        std::ofstream out(csv);
+        out << "id,evaluation_date,flat_rate,model,engine,strike_multiplier,tenor,type\n"
+            << "1,2025-07-15,0.035,hw,tree,1.0,5Y,payer\n"
+            << "2,2025-07-15,0.035,hw,tree,0.8,5Y,payer\n"
+            << "3,2025-07-15,0.030,bk,tree,1.2,5Y,payer\n"
+            << "4,2025-08-15,0.040,hw,binomial,1.0,5Y,payer\n"
+            << "5,2025-08-15,0.040,hw,tree,1.0,7Y,receiver\n"
+            << "6,2025-07-15,0.035,g2,tree,1.1,5Y,payer\n";
+    }
+
+    MarketSnapshot market;
+    market.modelParams["hw"] = {0.05, 0.012};
+
+    std::vector<double> serial;
+    auto reader = PortfolioReader::open(csv);
+    for (PortfolioRow row; reader->next(row);) {
+        if (row.trade.model == "hw")
+            row.trade.modelParams = market.modelParams["hw"];
+        serial.push_back(row.trade.engine == "binomial"
+                             ? std::nan("")
+                             : BermudanSwaptionPricer::priceTrade(row.trade));
+    }
+    ASSERT_EQ(serial.size(), 6u);
+
+    ShardSettings settings;
+    settings.workers = 2;
+    settings.threadsPerWorker = 2;
+    std::ostringstream out;
+    StreamStats stats = priceSharded(csv, out, market, settings);
+    EXPECT_EQ(stats.trades, 6u);
+    EXPECT_EQ(stats.failed, 1u);
+
+    std::istringstream in(out.str());
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, "id,npv,error");
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        ASSERT_TRUE(std::getline(in, line));
+        const auto a = line.find(',');
+        const auto b = line.find(',', a + 1);
+        EXPECT_EQ(std::stoull(line.substr(0, a)), i + 1);
+        const double npv = std::strtod(line.substr(a + 1, b - a - 1).c_str(), nullptr);
+        const std::string error = line.substr(b + 1);
+        if (std::isnan(serial[i])) {
+            EXPECT_TRUE(std::isnan(npv));
+            EXPECT_NE(error.find("binomial"), std::string::npos) << error;
+        } else {
+            EXPECT_NEAR(npv, serial[i], 1e-10) << "row " << i;
+            EXPECT_TRUE(error.empty()) << error;
+        }
+    }
+    EXPECT_FALSE(std::getline(in, line));
+
+    std::filesystem::remove(csv);
+}
+
+// Runs last: starts the shared pool, after which forking is refused
+TEST(ShardedPricing, RefusesToForkOnceTheSharedPoolRuns) {
+    const std::string csv =
+        (std::filesystem::temp_directory_path() / "bermudan_shard_fork_test.csv").string();
+    {
+        std::ofstream out(csv);
+        out << "id,evaluation_date,flat_rate,model,engine,strike_multiplier,tenor,type\n"
+            << "1,2025-07-15,0.035,hw,tree,1.0,5Y,payer\n";
+    }
+    ThreadPool::shared();
+    ASSERT_TRUE(ThreadPool::sharedStarted());
+
+    std::ostringstream out;
+    EXPECT_THROW(priceSharded(csv, out), QuantLib::Error);
+
+    std::filesystem::remove(csv);
+}
@@ -0,0 +1,143 @@
+// test/test_stream.cpp
+#include <gtest/gtest.h>
+
+#include "BermudanSwaptionPricer.hpp"
+#include "PortfolioStream.hpp"
+
+#include <ql/settings.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace QuantLib;
+
+namespace {
+
+    struct Line {
+        std::uint64_t id;
+        double npv;
+        std::string error;
+    };
+
+    std::vector<Line> parseResults(const std::string& text) {
+        std::istringstream in(text);
+        std::string line;
+        std::getline(in, line);
+        EXPECT_EQ(line, "id,npv,error");
+        std::vector<Line> lines;
+        while (std::getline(in, line)) {
+            const auto a = line.find(',');
+            const auto b = line.find(',', a + 1);
+            lines.push_back({std::stoull(line.substr(0, a)),
+                             std::strtod(line.substr(a + 1, b - a - 1).c_str(), nullptr),
+                             line.substr(b + 1)});
+        }
+        return lines;
+    }
+
+}
+
+TEST(PortfolioStream, CsvAndBinaryMatchSerialPricing) {
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::string csv = (dir / "bermudan_stream_test.csv").string();
+    const std::string bin = (dir / "bermudan_stream_test.bin").string();
+    {
+        // Two evaluation dates (forces a drain), a non-default swap and a
+        // row that fails to price
+        std::ofstream out(csv);
+        out << "id,evaluation_date,flat_rate,model,engine,strike_multiplier,tenor,type\n"
+            << "7,2025-07-15,0.035,hw,tree,1.0,5Y,payer\n"
+            << "8,2025-07-15,0.035,bk,tree,0.8,5Y,payer\n"
+            << "9,2025-07-15,0.030,hw,fdm,1.2,5Y,payer\n"
+            << "\n"
+            << "10,2025-08-15,0.040,hw,tree,1.0,7Y,receiver\n"
+            << "11,2025-08-15,0.040,hw,binomial,1.0,5Y,payer\n"
+            << "12,2025-07-15,0.035,g2,tree,1.1,5Y,payer\n";
+    }
+
+    std::vector<double> serial;
+    for (auto reader = PortfolioReader::open(csv); ;) {
+        PortfolioRow row;
+        if (!reader->next(row))
+            break;
+        serial.push_back(row.trade.engine == "binomial"
+                             ? std::nan("")
+                             : BermudanSwaptionPricer::priceTrade(row.trade));
+    }
+    ASSERT_EQ(serial.size(), 6u);
+
+    const Date today(1, June, 2025);
+    Settings::instance().evaluationDate() = today;
+
+    StreamSettings settings;
+    settings.window = 2;
+    settings.priceThreads = 3;
+    std::ostringstream fromCsv;
+    auto reader = PortfolioReader::open(csv);
+    StreamStats stats = streamPortfolio(*reader, fromCsv, settings);
+    EXPECT_EQ(stats.trades, 6u);
+    EXPECT_EQ(stats.failed, 1u);
+    EXPECT_GT(stats.tradesPerSecond(), 0.0);
+    EXPECT_EQ(Date(Settings::instance().evaluationDate()), today);
+
+    std::vector<Line> lines = parseResults(fromCsv.str());
+    ASSERT_EQ(lines.size(), serial.size());
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        EXPECT_EQ(lines[i].id, 7 + i);
+        if (std::isnan(serial[i])) {
+            EXPECT_TRUE(std::isnan(lines[i].npv));
+            EXPECT_NE(lines[i].error.find("binomial"), std::string::npos);
+        } else {
+            EXPECT_EQ(lines[i].npv, serial[i]) << "row " << i;
+            EXPECT_TRUE(lines[i].error.empty());
+        }
+    }
+
+    {
+        auto rows = PortfolioReader::open(csv);
+        BinaryPortfolioWriter writer(bin);
+        PortfolioRow row;
+        while (rows->next(row)) {
+            if (row.trade.engine == "binomial")
+                row.trade.engine = "tree";
+            writer.write(row);
+        }
+    }
+    std::ostringstream fromBinary;
+    auto mapped = PortfolioReader::open(bin);
+    EXPECT_EQ(streamPortfolio(*mapped, fromBinary, settings).failed, 0u);
+    std::vector<Line> binaryLines = parseResults(fromBinary.str());
+    ASSERT_EQ(binaryLines.size(), lines.size());
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        if (!std::isnan(serial[i]))
+            EXPECT_EQ(binaryLines[i].npv, lines[i].npv) << "row " << i;
+    }
+
+    std::filesystem::remove(csv);
+    std::filesystem::remove(bin);
+}
+
+TEST(PortfolioStream, MalformedRowThrowsWithLocation) {
+    const std::string csv =
+        (std::filesystem::temp_directory_path() / "bermudan_stream_bad.csv").string();
+    {
+        std::ofstream out(csv);
+        out << "evaluation_date,flat_rate\n"
+            << "2025-07-15,0.035\n"
+            << "2025-07-15,abc\n";
+    }
+    std::ostringstream out;
+    auto reader = PortfolioReader::open(csv);
+    try {
+        streamPortfolio(*reader, out);
+        FAIL() << "expected a parse error";
+    } catch (const Error& e) {
+        EXPECT_NE(std::string(e.what()).find(":3:"), std::string::npos) << e.what();
+    }
+    std::filesystem::remove(csv);
+}
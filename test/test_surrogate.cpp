@@ -0,0 +1,73 @@
+// test/test_surrogate.cpp
+#include <gtest/gtest.h>
+
+#include "BermudanSwaptionPricer.hpp"
+#include "ChebyshevSurrogate.hpp"
+
+#include <ql/errors.hpp>
+
+using namespace QuantLib;
+
+TEST(ChebyshevSurrogate, ReproducesFullPricerInsideDomain) {
+    const BermudanTrade shape{Date(15, July, 2025), 0.0, "hw", "tree", 1.0};
+
+    SurrogateSettings settings;
+    settings.minRate = 0.02;
+    settings.maxRate = 0.05;
+    settings.minMultiplier = 0.8;
+    settings.maxMultiplier = 1.2;
+    settings.rateNodes = 8;
+    settings.multiplierNodes = 8;
+    settings.checkNodes = 4;
+    settings.threads = 2;
+
+    SurrogateCache cache;
+    auto surrogate = cache.build(shape, settings);
+    EXPECT_LT(surrogate->errorEstimate(), 0.1);  // NPV on 1000 notional
+    EXPECT_GT(surrogate->tailEstimate(), 0.0);
+    EXPECT_EQ(surrogate->errorEstimate(),
+              surrogate->checkedError() + surrogate->tailEstimate());
+
+    // Off both the node and the check grids
+    for (auto [rate, mult] : {std::pair{0.0237, 0.93}, std::pair{0.0411, 1.17}}) {
+        BermudanTrade trade = shape;
+        trade.flatRate = rate;
+        trade.strikeMultiplier = mult;
+        bool fromSurrogate = false;
+        const double npv = cache.price(trade, &fromSurrogate);
+        EXPECT_TRUE(fromSurrogate);
+        EXPECT_NEAR(npv, BermudanSwaptionPricer::priceTrade(trade), 0.1);
+    }
+
+    // Outside the box, or another shape: the full pricer answers
+    BermudanTrade outside = shape;
+    outside.flatRate = 0.06;
+    EXPECT_FALSE(surrogate->price(outside.flatRate, outside.strikeMultiplier));
+    bool fromSurrogate = true;
+    EXPECT_EQ(cache.price(outside, &fromSurrogate), BermudanSwaptionPricer::priceTrade(outside));
+    EXPECT_FALSE(fromSurrogate);
+
+    BermudanTrade otherShape = shape;
+    otherShape.flatRate = 0.03;
+    otherShape.model = "bk";
+    EXPECT_FALSE(cache.find(otherShape));
+    cache.price(otherShape, &fromSurrogate);
+    EXPECT_FALSE(fromSurrogate);
+
+    EXPECT_EQ(cache.hits(), 2u);
+    EXPECT_EQ(cache.fallbacks(), 2u);
+}
+
+TEST(ChebyshevSurrogate, RejectsDomainBeyondTolerance) {
+    const BermudanTrade shape{Date(15, July, 2025), 0.0, "hw", "tree", 1.0};
+    SurrogateSettings settings;
+    settings.rateNodes = 2;
+    settings.multiplierNodes = 2;
+    settings.checkNodes = 3;
+    settings.tolerance = 1e-6;
+    EXPECT_THROW(ChebyshevSurrogate::build(shape, settings), Error);
+
+    settings.minRate = settings.maxRate;
+    settings.tolerance = 0.0;
+    EXPECT_THROW(ChebyshevSurrogate::build(shape, settings), Error);
+}
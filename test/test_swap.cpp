@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include "YieldCurveBuilder.hpp"
 #include "SwapBuilder.hpp"
+#include "SchedulePool.hpp"
 #include <ql/settings.hpp>
 #include <ql/time/calendars/target.hpp>
 
@@ -25,3 +26,49 @@ TEST(SwapBuilder, FairRateAndNPVSign) {
     EXPECT_LT(over->NPV(), 0.0);  // payer swap at higher than fair -> negative
 }
 
+
+TEST(SwapBuilder, DescriptionDrivesSwapAndSchedulesAreShared) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Date settlement = TARGET().advance(today, 2, Days);
+    auto ts = YieldCurveBuilder(0.035).buildCurve(settlement);
+
+    SchedulePool::shared().clear();
+    SwapBuilder a(ts);
+    SwapBuilder b(ts);
+    EXPECT_EQ(&a.fixedSchedule(), &b.fixedSchedule());
+    EXPECT_EQ(&a.floatSchedule(), &b.floatSchedule());
+    EXPECT_EQ(SchedulePool::shared().size(), 2u);
+    EXPECT_EQ(SchedulePool::shared().hits(), 2u);
+
+    SwapDescription d;
+    d.forwardStart = Period(2, Years);
+    d.tenor = Period(10, Years);
+    d.floatFrequency = Quarterly;
+    d.notional = 1e6;
+    d.type = Swap::Receiver;
+    SwapBuilder c(ts, d);
+    EXPECT_EQ(c.fixedSchedule().size(), 11u);
+    EXPECT_EQ(c.floatSchedule().size(), 41u);
+    EXPECT_EQ(SchedulePool::shared().size(), 4u);
+
+    auto swap = c.buildSwap(c.fairRate() * 0.95);
+    EXPECT_EQ(swap->type(), Swap::Receiver);
+    EXPECT_EQ(swap->nominal(), 1e6);
+    EXPECT_EQ(swap->iborIndex()->tenor(), Period(3, Months));
+    EXPECT_LT(swap->NPV(), 0.0);   // receiving below fair
+
+    // Bounded by least recent use: rolling start dates keep the latest ones
+    SchedulePool small(2);
+    const Date start = TARGET().advance(settlement, 1, Years);
+    auto first = small.schedule(start, start + 5 * Years, Period(Annual), TARGET(),
+                                Unadjusted, DateGeneration::Forward, false);
+    for (int day = 1; day <= 3; ++day)
+        small.schedule(start + day, start + day + 5 * Years, Period(Annual), TARGET(),
+                       Unadjusted, DateGeneration::Forward, false);
+    EXPECT_EQ(small.size(), 2u);
+    EXPECT_NE(small.schedule(start, start + 5 * Years, Period(Annual), TARGET(), Unadjusted,
+                             DateGeneration::Forward, false),
+              first);
+    EXPECT_EQ(small.misses(), 5u);
+}
@@ -0,0 +1,204 @@
+// test/test_workspace.cpp
+#include <gtest/gtest.h>
+
+#include "YieldCurveBuilder.hpp"
+#include "SwapBuilder.hpp"
+#include "BermudanSwaptionPricer.hpp"
+#include "HullWhiteSoaLattice.hpp"
+#include "PricingWorkspace.hpp"
+#include "SwaptionCashflows.hpp"
+
+#include <ql/settings.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/pricingengines/swaption/discretizedswaption.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+using namespace QuantLib;
+
+// Counting allocator: every global operator new of this binary (built on its
+// own, see CMakeLists.txt) goes through here, and is counted while the test's
+// thread has switched counting on.
+namespace {
+    thread_local bool counting = false;
+    std::atomic<std::size_t> allocations{0};
+
+    void* allocate(std::size_t size, std::size_t alignment) {
+        if (counting)
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        if (size == 0)
+            size = 1;
+        void* p = alignment <= alignof(std::max_align_t)
+                      ? std::malloc(size)
+                      : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    struct CountAllocations {
+        CountAllocations() {
+            allocations = 0;
+            counting = true;
+        }
+        ~CountAllocations() { counting = false; }
+        std::size_t count() const { return allocations.load(); }
+    };
+}
+
+void* operator new(std::size_t size) { return allocate(size, 0); }
+void* operator new[](std::size_t size) { return allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t a) {
+    return allocate(size, static_cast<std::size_t>(a));
+}
+void* operator new[](std::size_t size, std::align_val_t a) {
+    return allocate(size, static_cast<std::size_t>(a));
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+TEST(PricingWorkspace, ScopesRewindAndSpillsMergeIntoOneBlock) {
+    PricingWorkspace workspace;
+    {
+        PricingWorkspace::Scope outer(workspace);
+        auto a = workspace.take<double>(1000);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a.data()) % PricingWorkspace::alignment, 0u);
+        {
+            PricingWorkspace::Scope inner(workspace);
+            auto big = workspace.take<double>(100000);   // spills into a second block
+            big[0] = 1.0;
+            EXPECT_EQ(workspace.blockCount(), 2u);
+        }
+        auto b = workspace.take<double>(10);
+        EXPECT_EQ(b.data(), a.data() + 1000);            // inner scope given back
+    }
+    EXPECT_EQ(workspace.blockCount(), 1u);
+    const std::size_t capacity = workspace.capacity();
+
+    CountAllocations counter;
+    for (int pass = 0; pass < 10; ++pass) {
+        PricingWorkspace::Scope outer(workspace);
+        workspace.take<double>(1000);
+        PricingWorkspace::Scope inner(workspace);
+        workspace.take<double>(100000);
+    }
+    EXPECT_EQ(counter.count(), 0u);
+    EXPECT_EQ(workspace.capacity(), capacity);
+}
+
+TEST(PricingWorkspace, LatticeRepricingIsAllocationFree) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Handle<YieldTermStructure> ts =
+        YieldCurveBuilder(0.035).buildCurve(TARGET().advance(today, 2, Days));
+    SwapBuilder sb(ts);
+    const Rate atm = sb.fairRate();
+    auto hw = ext::make_shared<HullWhite>(ts, 0.05, 0.012);
+
+    BermudanSwaptionPricer tree(sb.buildSwap(atm), hw, "tree");
+    Swaption::arguments args;
+    tree.swaption()->setupArguments(&args);
+    args.validate();
+
+    const Date referenceDate = ts->referenceDate();
+    const DayCounter dayCounter = ts->dayCounter();
+    DiscretizedSwaption discretized(args, referenceDate, dayCounter);
+    const std::vector<Time> times = discretized.mandatoryTimes();
+    const TimeGrid grid(times.begin(), times.end(), 100);
+    auto lattice = HullWhiteSoaLattice::build(*hw, grid);
+
+    std::vector<SwaptionCashflow> cashflows;
+    swaptionCashflows(args, referenceDate, cashflows);
+    HullWhiteSoaLattice::Bermudan bermudan;
+    ASSERT_TRUE(lattice->locate(cashflows, args.exercise->dates(), referenceDate, dayCounter,
+                                bermudan));
+
+    PricingWorkspace& workspace = PricingWorkspace::local();
+    const Real npv = lattice->value(bermudan, workspace);   // warm-up
+    EXPECT_NEAR(npv, BermudanSwaptionPricer(sb.buildSwap(atm), hw, "tree", &grid).price(), 1e-10);
+    EXPECT_NEAR(npv, BermudanSwaptionPricer(sb.buildSwap(atm), hw, "hw-simd", &grid).price(),
+                1e-12);
+
+    // Strike ladder on the fitted lattice: fixed coupons scale with the strike
+    std::vector<Real> fixedBond(bermudan.coupons.size());
+    for (Size k = 0; k < fixedBond.size(); ++k)
+        fixedBond[k] = bermudan.coupons[k].fixedPart == 0.0 ? bermudan.coupons[k].bondPart : 0.0;
+
+    Real sum = 0.0;
+    {
+        CountAllocations counter;
+        for (int i = 0; i < 100; ++i) {
+            const Real scale = 0.8 + 0.004 * i;
+            for (Size k = 0; k < fixedBond.size(); ++k)
+                if (fixedBond[k] != 0.0)
+                    bermudan.coupons[k].bondPart = fixedBond[k] * scale;
+            sum += lattice->value(bermudan, workspace);
+        }
+        EXPECT_EQ(counter.count(), 0u);
+    }
+    EXPECT_GT(sum, 0.0);
+
+    // The last strike against a freshly built swap, through the tree and the
+    // hw-simd engine as production prices it
+    const Real strike = atm * (0.8 + 0.004 * 99);
+    const Real last = lattice->value(bermudan, workspace);
+    EXPECT_NEAR(last, BermudanSwaptionPricer(sb.buildSwap(strike), hw, "tree", &grid).price(),
+                1e-10);
+    EXPECT_NEAR(last, BermudanSwaptionPricer(sb.buildSwap(strike), hw, "hw-simd", &grid).price(),
+                1e-12);
+}
+
+// The engine path production prices through: repricing on the engine's
+// fitted lattice still allocates for the swaption arguments and cash flows
+// it sets up per call, but the rollback adds nothing, so the count per call
+// is the same whatever the tree size.
+TEST(PricingWorkspace, EngineRepricingAllocationsDoNotGrowWithTheTree) {
+    Date today(15, July, 2025);
+    Settings::instance().evaluationDate() = today;
+    Handle<YieldTermStructure> ts =
+        YieldCurveBuilder(0.035).buildCurve(TARGET().advance(today, 2, Days));
+    SwapBuilder sb(ts);
+    const Rate atm = sb.fairRate();
+    auto hw = ext::make_shared<HullWhite>(ts, 0.05, 0.012);
+
+    BermudanSwaptionPricer tree(sb.buildSwap(atm), hw, "tree");
+    Swaption::arguments args;
+    tree.swaption()->setupArguments(&args);
+    args.validate();
+    DiscretizedSwaption discretized(args, ts->referenceDate(), ts->dayCounter());
+    const std::vector<Time> times = discretized.mandatoryTimes();
+
+    constexpr int calls = 10;
+    auto allocationsPerCall = [&](Size steps) {
+        const TimeGrid grid(times.begin(), times.end(), steps);
+        BermudanSwaptionPricer pricer(sb.buildSwap(atm), hw, "hw-simd", &grid);
+        const auto& swaption = pricer.swaption();
+        const Real npv = pricer.price();    // fits the lattice, sizes the workspace
+        swaption->recalculate();
+        std::size_t count = 0;
+        {
+            CountAllocations counter;
+            for (int i = 0; i < calls; ++i)
+                swaption->recalculate();
+            count = counter.count();
+        }
+        EXPECT_EQ(swaption->NPV(), npv);
+        EXPECT_EQ(count % calls, 0u) << count << " allocations over " << calls << " calls";
+        return count / calls;
+    };
+
+    const std::size_t coarse = allocationsPerCall(100);
+    const std::size_t fine = allocationsPerCall(400);
+    EXPECT_EQ(coarse, fine);
+    RecordProperty("allocations_per_engine_call", static_cast<int>(fine));
+}
@@ -33,6 +33,7 @@ Commands:
   build       Configure & build (local) or docker build images
   test        Run unit tests (emits junit.xml)
   run         Run the CLI demo (prints ATM/OTM/ITM)
+  bench       Build & run bermudan_bench, JSON to bench.json (local only)
   serve-api   (reserved) start API container if added later
   clean       Remove local build/ or prune docker images
 
@@ -73,6 +74,13 @@ local_run() {
   fi
 }
 
+local_bench() {
+  cmake -S . -B build -G Ninja -DCMAKE_BUILD_TYPE=Release -DBUILD_BENCHMARKS=ON
+  cmake --build build --target bermudan_bench
+  ./build/bermudan_bench --benchmark_out=bench.json --benchmark_out_format=json
+  echo "Results saved to ./bench.json (compare with bench/compare_bench.py)"
+}
+
 # -------------------------------
 # Docker actions
 # -------------------------------
@@ -128,6 +136,9 @@ case "$ACTION" in
   run)
     if [[ "$IN" == "docker" ]]; then docker_run; else local_run; fi
     ;;
+  bench)
+    local_bench
+    ;;
   serve-api)
     echo "API container not wired yet in this script. (Your FastAPI app can be added later.)"
     ;;